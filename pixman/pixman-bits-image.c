@@ -32,6 +32,8 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <math.h>
+#include "pixman-accessor.h"
 #include "pixman-private.h"
 #include "pixman-combine32.h"
 #include "pixman-inlines.h"
@@ -720,7 +722,23 @@ bits_image_fetch_general (pixman_iter_t  *iter,
     return buffer;
 }
 
-typedef uint32_t (* convert_pixel_t) (const uint8_t *row, int x);
+typedef uint32_t (* convert_pixel_t) (bits_image_t *bits, const uint8_t *row, int x);
+
+/* Pixels of formats without alpha are opaque, except for indexed formats
+ * whose palette provides the alpha.
+ */
+static force_inline uint32_t
+alpha_mask (pixman_format_code_t format)
+{
+    if (PIXMAN_FORMAT_A (format)			||
+	PIXMAN_FORMAT_TYPE (format) == PIXMAN_TYPE_GRAY	||
+	PIXMAN_FORMAT_TYPE (format) == PIXMAN_TYPE_COLOR)
+    {
+	return 0;
+    }
+
+    return 0xff000000;
+}
 
 static force_inline void
 bits_image_fetch_separable_convolution_affine (pixman_image_t * image,
@@ -815,7 +833,7 @@ bits_image_fetch_separable_convolution_affine (pixman_image_t * image,
 			uint32_t pixel, mask;
 			uint8_t *row;
 
-			mask = PIXMAN_FORMAT_A (format)? 0 : 0xff000000;
+			mask = alpha_mask (format);
 
 			if (repeat_mode != PIXMAN_REPEAT_NONE)
 			{
@@ -823,7 +841,7 @@ bits_image_fetch_separable_convolution_affine (pixman_image_t * image,
 			    repeat (repeat_mode, &ry, bits->height);
 
 			    row = (uint8_t *)bits->bits + bits->rowstride * 4 * ry;
-			    pixel = convert_pixel (row, rx) | mask;
+			    pixel = convert_pixel (bits, row, rx) | mask;
 			}
 			else
 			{
@@ -834,7 +852,7 @@ bits_image_fetch_separable_convolution_affine (pixman_image_t * image,
 			    else
 			    {
 				row = (uint8_t *)bits->bits + bits->rowstride * 4 * ry;
-				pixel = convert_pixel (row, rx) | mask;
+				pixel = convert_pixel (bits, row, rx) | mask;
 			    }
 			}
 
@@ -866,7 +884,117 @@ bits_image_fetch_separable_convolution_affine (pixman_image_t * image,
     }
 }
 
-static const uint8_t zero[8] = { 0, 0, 0, 0, 0, 0, 0, 0 };
+static force_inline uint32_t
+bits_image_sample_bilinear (bits_image_t *		bits,
+			    pixman_fixed_t		x,
+			    pixman_fixed_t		y,
+			    convert_pixel_t		convert_pixel,
+			    pixman_format_code_t	format,
+			    pixman_repeat_t		repeat_mode)
+{
+    int x1, y1, x2, y2;
+    uint32_t tl, tr, bl, br;
+    int32_t distx, disty;
+    int width = bits->width;
+    int height = bits->height;
+    const uint8_t *row1;
+    const uint8_t *row2;
+
+    x1 = x - pixman_fixed_1 / 2;
+    y1 = y - pixman_fixed_1 / 2;
+
+    distx = pixman_fixed_to_bilinear_weight (x1);
+    disty = pixman_fixed_to_bilinear_weight (y1);
+
+    y1 = pixman_fixed_to_int (y1);
+    y2 = y1 + 1;
+    x1 = pixman_fixed_to_int (x1);
+    x2 = x1 + 1;
+
+    if (repeat_mode != PIXMAN_REPEAT_NONE)
+    {
+	uint32_t mask;
+
+	mask = alpha_mask (format);
+
+	repeat (repeat_mode, &x1, width);
+	repeat (repeat_mode, &y1, height);
+	repeat (repeat_mode, &x2, width);
+	repeat (repeat_mode, &y2, height);
+
+	row1 = (uint8_t *)bits->bits + bits->rowstride * 4 * y1;
+	row2 = (uint8_t *)bits->bits + bits->rowstride * 4 * y2;
+
+	tl = convert_pixel (bits, row1, x1) | mask;
+	tr = convert_pixel (bits, row1, x2) | mask;
+	bl = convert_pixel (bits, row2, x1) | mask;
+	br = convert_pixel (bits, row2, x2) | mask;
+    }
+    else
+    {
+	uint32_t mask = alpha_mask (format);
+
+	if (x1 >= width || x2 < 0 || y1 >= height || y2 < 0)
+	    return 0;
+
+	/* Pixels outside of the image are transparent */
+	tl = tr = bl = br = 0;
+
+	if (y1 >= 0)
+	{
+	    row1 = (uint8_t *)bits->bits + bits->rowstride * 4 * y1;
+
+	    if (x1 >= 0)
+		tl = convert_pixel (bits, row1, x1) | mask;
+	    if (x2 < width)
+		tr = convert_pixel (bits, row1, x2) | mask;
+	}
+
+	if (y2 < height)
+	{
+	    row2 = (uint8_t *)bits->bits + bits->rowstride * 4 * y2;
+
+	    if (x1 >= 0)
+		bl = convert_pixel (bits, row2, x1) | mask;
+	    if (x2 < width)
+		br = convert_pixel (bits, row2, x2) | mask;
+	}
+    }
+
+    return bilinear_interpolation (tl, tr, bl, br, distx, disty);
+}
+
+static force_inline uint32_t
+bits_image_sample_nearest (bits_image_t *		bits,
+			   pixman_fixed_t		x,
+			   pixman_fixed_t		y,
+			   convert_pixel_t		convert_pixel,
+			   pixman_format_code_t		format,
+			   pixman_repeat_t		repeat_mode)
+{
+    int width = bits->width;
+    int height = bits->height;
+    int x0 = pixman_fixed_to_int (x - pixman_fixed_e);
+    int y0 = pixman_fixed_to_int (y - pixman_fixed_e);
+    uint32_t mask = alpha_mask (format);
+    const uint8_t *row;
+
+    if (repeat_mode == PIXMAN_REPEAT_NONE &&
+	(y0 < 0 || y0 >= height || x0 < 0 || x0 >= width))
+    {
+	return 0;
+    }
+
+    if (repeat_mode != PIXMAN_REPEAT_NONE)
+    {
+	repeat (repeat_mode, &x0, width);
+	repeat (repeat_mode, &y0, height);
+    }
+
+    row = (uint8_t *)bits->bits + bits->rowstride * 4 * y0;
+
+    return convert_pixel (bits, row, x0) | mask;
+}
 
 static force_inline void
 bits_image_fetch_bilinear_affine (pixman_image_t * image,
@@ -883,7 +1011,6 @@ bits_image_fetch_bilinear_affine (pixman_image_t * image,
     pixman_fixed_t x, y;
     pixman_fixed_t ux, uy;
     pixman_vector_t v;
-    bits_image_t *bits = &image->bits;
     int i;
 
     /* reference point is the center of the pixel */
@@ -902,121 +1029,12 @@ bits_image_fetch_bilinear_affine (pixman_image_t * image,
 
     for (i = 0; i < width; ++i)
     {
-	int x1, y1, x2, y2;
-	uint32_t tl, tr, bl, br;
-	int32_t distx, disty;
-	int width = image->bits.width;
-	int height = image->bits.height;
-	const uint8_t *row1;
-	const uint8_t *row2;
-
-	if (mask && !mask[i])
-	    goto next;
-
-	x1 = x - pixman_fixed_1 / 2;
-	y1 = y - pixman_fixed_1 / 2;
-
-	distx = pixman_fixed_to_bilinear_weight (x1);
-	disty = pixman_fixed_to_bilinear_weight (y1);
-
-	y1 = pixman_fixed_to_int (y1);
-	y2 = y1 + 1;
-	x1 = pixman_fixed_to_int (x1);
-	x2 = x1 + 1;
-
-	if (repeat_mode != PIXMAN_REPEAT_NONE)
-	{
-	    uint32_t mask;
-
-	    mask = PIXMAN_FORMAT_A (format)? 0 : 0xff000000;
-
-	    repeat (repeat_mode, &x1, width);
-	    repeat (repeat_mode, &y1, height);
-	    repeat (repeat_mode, &x2, width);
-	    repeat (repeat_mode, &y2, height);
-
-	    row1 = (uint8_t *)bits->bits + bits->rowstride * 4 * y1;
-	    row2 = (uint8_t *)bits->bits + bits->rowstride * 4 * y2;
-
-	    tl = convert_pixel (row1, x1) | mask;
-	    tr = convert_pixel (row1, x2) | mask;
-	    bl = convert_pixel (row2, x1) | mask;
-	    br = convert_pixel (row2, x2) | mask;
-	}
-	else
+	if (!mask || mask[i])
 	{
-	    uint32_t mask1, mask2;
-	    int bpp;
-
-	    /* Note: PIXMAN_FORMAT_BPP() returns an unsigned value,
-	     * which means if you use it in expressions, those
-	     * expressions become unsigned themselves. Since
-	     * the variables below can be negative in some cases,
-	     * that will lead to crashes on 64 bit architectures.
-	     *
-	     * So this line makes sure bpp is signed
-	     */
-	    bpp = PIXMAN_FORMAT_BPP (format);
-
-	    if (x1 >= width || x2 < 0 || y1 >= height || y2 < 0)
-	    {
-		buffer[i] = 0;
-		goto next;
-	    }
-
-	    if (y2 == 0)
-	    {
-		row1 = zero;
-		mask1 = 0;
-	    }
-	    else
-	    {
-		row1 = (uint8_t *)bits->bits + bits->rowstride * 4 * y1;
-		row1 += bpp / 8 * x1;
-
-		mask1 = PIXMAN_FORMAT_A (format)? 0 : 0xff000000;
-	    }
-
-	    if (y1 == height - 1)
-	    {
-		row2 = zero;
-		mask2 = 0;
-	    }
-	    else
-	    {
-		row2 = (uint8_t *)bits->bits + bits->rowstride * 4 * y2;
-		row2 += bpp / 8 * x1;
-
-		mask2 = PIXMAN_FORMAT_A (format)? 0 : 0xff000000;
-	    }
-
-	    if (x2 == 0)
-	    {
-		tl = 0;
-		bl = 0;
-	    }
-	    else
-	    {
-		tl = convert_pixel (row1, 0) | mask1;
-		bl = convert_pixel (row2, 0) | mask2;
-	    }
-
-	    if (x1 == width - 1)
-	    {
-		tr = 0;
-		br = 0;
-	    }
-	    else
-	    {
-		tr = convert_pixel (row1, 1) | mask1;
-		br = convert_pixel (row2, 1) | mask2;
-	    }
+	    buffer[i] = bits_image_sample_bilinear (
+		&image->bits, x, y, convert_pixel, format, repeat_mode);
 	}
 
-	buffer[i] = bilinear_interpolation (
-	    tl, tr, bl, br, distx, disty);
-
-    next:
 	x += ux;
 	y += uy;
     }
@@ -1037,7 +1055,6 @@ bits_image_fetch_nearest_affine (pixman_image_t * image,
     pixman_fixed_t x, y;
     pixman_fixed_t ux, uy;
     pixman_vector_t v;
-    bits_image_t *bits = &image->bits;
     int i;
 
     /* reference point is the center of the pixel */
@@ -1056,67 +1073,170 @@ bits_image_fetch_nearest_affine (pixman_image_t * image,
 
     for (i = 0; i < width; ++i)
     {
-	int width, height, x0, y0;
-	const uint8_t *row;
-
-	if (mask && !mask[i])
-	    goto next;
-	
-	width = image->bits.width;
-	height = image->bits.height;
-	x0 = pixman_fixed_to_int (x - pixman_fixed_e);
-	y0 = pixman_fixed_to_int (y - pixman_fixed_e);
-
-	if (repeat_mode == PIXMAN_REPEAT_NONE &&
-	    (y0 < 0 || y0 >= height || x0 < 0 || x0 >= width))
+	if (!mask || mask[i])
 	{
-	    buffer[i] = 0;
+	    buffer[i] = bits_image_sample_nearest (
+		&image->bits, x, y, convert_pixel, format, repeat_mode);
 	}
-	else
-	{
-	    uint32_t mask = PIXMAN_FORMAT_A (format)? 0 : 0xff000000;
 
-	    if (repeat_mode != PIXMAN_REPEAT_NONE)
+	x += ux;
+	y += uy;
+    }
+}
+
+/* Computes ((pixman_fixed_48_16_t)n << 16) / d, truncated to 16.16 like
+ * bits_image_fetch_general() does, from recip = 65536.0 / d. The error of
+ * the estimate is below |q| * 2^-52, so truncating it is exact unless the
+ * quotient is within that distance of an integer. Only then is the
+ * integer division needed, and a single reciprocal serves both
+ * coordinates of a pixel.
+ */
+static force_inline pixman_fixed_t
+projective_divide (pixman_fixed_t n, pixman_fixed_t d, double recip)
+{
+    double q = n * recip;
+    double frac = fabs (q - (double)(int64_t)q);
+    double eps = fabs (q) * (1.0 / 281474976710656.0); /* 2^-48 */
+
+    if (frac > eps && frac < 1.0 - eps)
+	return (int64_t)q;
+
+    return ((pixman_fixed_48_16_t)n << 16) / d;
+}
+
+/* Projective transformations. The homogeneous vector is stepped along
+ * the scanline as in bits_image_fetch_general(), and the pixels are
+ * sampled exactly as it does, without going through fetch_pixel_32().
+ */
+static force_inline void
+bits_image_fetch_projective (pixman_image_t * image,
+			     int              offset,
+			     int              line,
+			     int              width,
+			     uint32_t *       buffer,
+			     const uint32_t * mask,
+
+			     convert_pixel_t		convert_pixel,
+			     pixman_format_code_t	format,
+			     pixman_repeat_t		repeat_mode,
+			     pixman_bool_t		bilinear)
+{
+    pixman_fixed_t x, y, w;
+    pixman_fixed_t ux, uy, uw;
+    pixman_vector_t v;
+    int i;
+
+    /* reference point is the center of the pixel */
+    v.vector[0] = pixman_int_to_fixed (offset) + pixman_fixed_1 / 2;
+    v.vector[1] = pixman_int_to_fixed (line) + pixman_fixed_1 / 2;
+    v.vector[2] = pixman_fixed_1;
+
+    if (!pixman_transform_point_3d (image->common.transform, &v))
+	return;
+
+    ux = image->common.transform->matrix[0][0];
+    uy = image->common.transform->matrix[1][0];
+    uw = image->common.transform->matrix[2][0];
+
+    x = v.vector[0];
+    y = v.vector[1];
+    w = v.vector[2];
+
+    for (i = 0; i < width; ++i)
+    {
+	pixman_fixed_t x0 = 0, y0 = 0;
+
+	if (!mask || mask[i])
+	{
+	    if (w != 0)
 	    {
-		repeat (repeat_mode, &x0, width);
-		repeat (repeat_mode, &y0, height);
-	    }
+		double recip = 65536.0 / w;
 
-	    row = (uint8_t *)bits->bits + bits->rowstride * 4 * y0;
+		x0 = projective_divide (x, w, recip);
+		y0 = projective_divide (y, w, recip);
+	    }
 
-	    buffer[i] = convert_pixel (row, x0) | mask;
+	    if (bilinear)
+	    {
+		buffer[i] = bits_image_sample_bilinear (
+		    &image->bits, x0, y0, convert_pixel, format, repeat_mode);
+	    }
+	    else
+	    {
+		buffer[i] = bits_image_sample_nearest (
+		    &image->bits, x0, y0, convert_pixel, format, repeat_mode);
+	    }
 	}
 
-    next:
 	x += ux;
 	y += uy;
+	w += uw;
     }
 }
 
 static force_inline uint32_t
-convert_a8r8g8b8 (const uint8_t *row, int x)
+convert_a8r8g8b8 (bits_image_t *bits, const uint8_t *row, int x)
 {
     return *(((uint32_t *)row) + x);
 }
 
 static force_inline uint32_t
-convert_x8r8g8b8 (const uint8_t *row, int x)
+convert_x8r8g8b8 (bits_image_t *bits, const uint8_t *row, int x)
 {
     return *(((uint32_t *)row) + x);
 }
 
 static force_inline uint32_t
-convert_a8 (const uint8_t *row, int x)
+convert_a8 (bits_image_t *bits, const uint8_t *row, int x)
 {
     return *(row + x) << 24;
 }
 
 static force_inline uint32_t
-convert_r5g6b5 (const uint8_t *row, int x)
+convert_r5g6b5 (bits_image_t *bits, const uint8_t *row, int x)
 {
     return convert_0565_to_0888 (*((uint16_t *)row + x));
 }
 
+/* Other formats are converted from their format code the same way as the
+ * fetch_pixel_32 accessors do, without the indirect call per pixel.
+ */
+static force_inline uint32_t
+convert_format (bits_image_t *bits, const uint8_t *row, int x,
+		pixman_format_code_t format)
+{
+    uint32_t pixel;
+
+    switch (PIXMAN_FORMAT_BPP (format))
+    {
+    case 1:
+	pixel = FETCH_1 (bits, row, x);
+	break;
+
+    case 4:
+	pixel = FETCH_4 (bits, row, x);
+	break;
+
+    case 8:
+	pixel = READ (bits, row + x);
+	break;
+
+    case 16:
+	pixel = READ (bits, (uint16_t *)row + x);
+	break;
+
+    case 24:
+	pixel = FETCH_24 (bits, row, x);
+	break;
+
+    default:
+	pixel = READ (bits, (uint32_t *)row + x);
+	break;
+    }
+
+    return convert_pixel_to_a8r8g8b8 ((pixman_image_t *)bits, format, pixel);
+}
+
 #define MAKE_SEPARABLE_CONVOLUTION_FETCHER(name, format, repeat_mode)  \
     static uint32_t *							\
     bits_image_fetch_separable_convolution_affine_ ## name (pixman_iter_t   *iter, \
@@ -1169,6 +1289,37 @@ convert_r5g6b5 (const uint8_t *row, int x)
     MAKE_BILINEAR_FETCHER (name, format, repeat_mode)			\
     MAKE_SEPARABLE_CONVOLUTION_FETCHER (name, format, repeat_mode)
 
+/* The fetchers of the other formats take the repeat mode from the image,
+ * which costs a lot less than the conversion of their pixels.
+ */
+#define MAKE_FORMAT_FETCHERS(format)					\
+    static force_inline uint32_t					\
+    convert_ ## format (bits_image_t *bits, const uint8_t *row, int x)	\
+    {									\
+	return convert_format (bits, row, x, PIXMAN_ ## format);	\
+    }									\
+									\
+    MAKE_FETCHERS (format, format, iter->image->common.repeat)
+
+#define MAKE_PROJECTIVE_FETCHER(name, format, repeat_mode, filter, bilinear) \
+    static uint32_t *							\
+    bits_image_fetch_ ## filter ## _projective_ ## name (pixman_iter_t   *iter, \
+							 const uint32_t * mask) \
+    {									\
+	bits_image_fetch_projective (iter->image,			\
+				     iter->x, iter->y++,		\
+				     iter->width,			\
+				     iter->buffer, mask,		\
+				     convert_ ## format,		\
+				     PIXMAN_ ## format,			\
+				     repeat_mode, bilinear);		\
+	return iter->buffer;						\
+    }
+
+#define MAKE_PROJECTIVE_FETCHERS(name, format, repeat_mode)		\
+    MAKE_PROJECTIVE_FETCHER (name, format, repeat_mode, nearest, FALSE)	\
+    MAKE_PROJECTIVE_FETCHER (name, format, repeat_mode, bilinear, TRUE)
+
 MAKE_FETCHERS (pad_a8r8g8b8,     a8r8g8b8, PIXMAN_REPEAT_PAD)
 MAKE_FETCHERS (none_a8r8g8b8,    a8r8g8b8, PIXMAN_REPEAT_NONE)
 MAKE_FETCHERS (reflect_a8r8g8b8, a8r8g8b8, PIXMAN_REPEAT_REFLECT)
@@ -1186,6 +1337,52 @@ MAKE_FETCHERS (none_r5g6b5,      r5g6b5,   PIXMAN_REPEAT_NONE)
 MAKE_FETCHERS (reflect_r5g6b5,   r5g6b5,   PIXMAN_REPEAT_REFLECT)
 MAKE_FETCHERS (normal_r5g6b5,    r5g6b5,   PIXMAN_REPEAT_NORMAL)
 
+MAKE_FORMAT_FETCHERS (a8b8g8r8)
+MAKE_FORMAT_FETCHERS (x8b8g8r8)
+MAKE_FORMAT_FETCHERS (b8g8r8a8)
+MAKE_FORMAT_FETCHERS (b8g8r8x8)
+MAKE_FORMAT_FETCHERS (r8g8b8a8)
+MAKE_FORMAT_FETCHERS (r8g8b8x8)
+MAKE_FORMAT_FETCHERS (x14r6g6b6)
+MAKE_FORMAT_FETCHERS (r8g8b8)
+MAKE_FORMAT_FETCHERS (b8g8r8)
+MAKE_FORMAT_FETCHERS (b5g6r5)
+MAKE_FORMAT_FETCHERS (a1r5g5b5)
+MAKE_FORMAT_FETCHERS (x1r5g5b5)
+MAKE_FORMAT_FETCHERS (a1b5g5r5)
+MAKE_FORMAT_FETCHERS (x1b5g5r5)
+MAKE_FORMAT_FETCHERS (a4r4g4b4)
+MAKE_FORMAT_FETCHERS (x4r4g4b4)
+MAKE_FORMAT_FETCHERS (a4b4g4r4)
+MAKE_FORMAT_FETCHERS (x4b4g4r4)
+MAKE_FORMAT_FETCHERS (r3g3b2)
+MAKE_FORMAT_FETCHERS (b2g3r3)
+MAKE_FORMAT_FETCHERS (a2r2g2b2)
+MAKE_FORMAT_FETCHERS (a2b2g2r2)
+MAKE_FORMAT_FETCHERS (c8)
+MAKE_FORMAT_FETCHERS (g8)
+MAKE_FORMAT_FETCHERS (x4c4)
+MAKE_FORMAT_FETCHERS (x4g4)
+MAKE_FORMAT_FETCHERS (x4a4)
+MAKE_FORMAT_FETCHERS (a4)
+MAKE_FORMAT_FETCHERS (r1g2b1)
+MAKE_FORMAT_FETCHERS (b1g2r1)
+MAKE_FORMAT_FETCHERS (a1r1g1b1)
+MAKE_FORMAT_FETCHERS (a1b1g1r1)
+MAKE_FORMAT_FETCHERS (c4)
+MAKE_FORMAT_FETCHERS (g4)
+MAKE_FORMAT_FETCHERS (a1)
+MAKE_FORMAT_FETCHERS (g1)
+
+MAKE_PROJECTIVE_FETCHERS (pad_a8r8g8b8,     a8r8g8b8, PIXMAN_REPEAT_PAD)
+MAKE_PROJECTIVE_FETCHERS (none_a8r8g8b8,    a8r8g8b8, PIXMAN_REPEAT_NONE)
+MAKE_PROJECTIVE_FETCHERS (reflect_a8r8g8b8, a8r8g8b8, PIXMAN_REPEAT_REFLECT)
+MAKE_PROJECTIVE_FETCHERS (normal_a8r8g8b8,  a8r8g8b8, PIXMAN_REPEAT_NORMAL)
+MAKE_PROJECTIVE_FETCHERS (pad_x8r8g8b8,     x8r8g8b8, PIXMAN_REPEAT_PAD)
+MAKE_PROJECTIVE_FETCHERS (none_x8r8g8b8,    x8r8g8b8, PIXMAN_REPEAT_NONE)
+MAKE_PROJECTIVE_FETCHERS (reflect_x8r8g8b8, x8r8g8b8, PIXMAN_REPEAT_REFLECT)
+MAKE_PROJECTIVE_FETCHERS (normal_x8r8g8b8,  x8r8g8b8, PIXMAN_REPEAT_NORMAL)
+
 static void
 replicate_pixel_32 (bits_image_t *   bits,
 		    int              x,
@@ -1467,6 +1664,85 @@ static const fetcher_info_t fetcher_info[] =
     AFFINE_FAST_PATHS (reflect_r5g6b5, r5g6b5, REFLECT)
     AFFINE_FAST_PATHS (normal_r5g6b5, r5g6b5, NORMAL)
 
+#define FORMAT_AFFINE_FAST_PATHS(format)				\
+    { PIXMAN_ ## format,						\
+      GENERAL_SEPARABLE_CONVOLUTION_FLAGS,				\
+      bits_image_fetch_separable_convolution_affine_ ## format,	\
+      _pixman_image_get_scanline_generic_float				\
+    },									\
+    { PIXMAN_ ## format,						\
+      GENERAL_BILINEAR_FLAGS,						\
+      bits_image_fetch_bilinear_affine_ ## format,			\
+      _pixman_image_get_scanline_generic_float				\
+    },									\
+    { PIXMAN_ ## format,						\
+      GENERAL_NEAREST_FLAGS,						\
+      bits_image_fetch_nearest_affine_ ## format,			\
+      _pixman_image_get_scanline_generic_float				\
+    },
+
+    FORMAT_AFFINE_FAST_PATHS (a8b8g8r8)
+    FORMAT_AFFINE_FAST_PATHS (x8b8g8r8)
+    FORMAT_AFFINE_FAST_PATHS (b8g8r8a8)
+    FORMAT_AFFINE_FAST_PATHS (b8g8r8x8)
+    FORMAT_AFFINE_FAST_PATHS (r8g8b8a8)
+    FORMAT_AFFINE_FAST_PATHS (r8g8b8x8)
+    FORMAT_AFFINE_FAST_PATHS (x14r6g6b6)
+    FORMAT_AFFINE_FAST_PATHS (r8g8b8)
+    FORMAT_AFFINE_FAST_PATHS (b8g8r8)
+    FORMAT_AFFINE_FAST_PATHS (b5g6r5)
+    FORMAT_AFFINE_FAST_PATHS (a1r5g5b5)
+    FORMAT_AFFINE_FAST_PATHS (x1r5g5b5)
+    FORMAT_AFFINE_FAST_PATHS (a1b5g5r5)
+    FORMAT_AFFINE_FAST_PATHS (x1b5g5r5)
+    FORMAT_AFFINE_FAST_PATHS (a4r4g4b4)
+    FORMAT_AFFINE_FAST_PATHS (x4r4g4b4)
+    FORMAT_AFFINE_FAST_PATHS (a4b4g4r4)
+    FORMAT_AFFINE_FAST_PATHS (x4b4g4r4)
+    FORMAT_AFFINE_FAST_PATHS (r3g3b2)
+    FORMAT_AFFINE_FAST_PATHS (b2g3r3)
+    FORMAT_AFFINE_FAST_PATHS (a2r2g2b2)
+    FORMAT_AFFINE_FAST_PATHS (a2b2g2r2)
+    FORMAT_AFFINE_FAST_PATHS (c8)
+    FORMAT_AFFINE_FAST_PATHS (g8)
+    FORMAT_AFFINE_FAST_PATHS (x4c4)
+    FORMAT_AFFINE_FAST_PATHS (x4g4)
+    FORMAT_AFFINE_FAST_PATHS (x4a4)
+    FORMAT_AFFINE_FAST_PATHS (a4)
+    FORMAT_AFFINE_FAST_PATHS (r1g2b1)
+    FORMAT_AFFINE_FAST_PATHS (b1g2r1)
+    FORMAT_AFFINE_FAST_PATHS (a1r1g1b1)
+    FORMAT_AFFINE_FAST_PATHS (a1b1g1r1)
+    FORMAT_AFFINE_FAST_PATHS (c4)
+    FORMAT_AFFINE_FAST_PATHS (g4)
+    FORMAT_AFFINE_FAST_PATHS (a1)
+    FORMAT_AFFINE_FAST_PATHS (g1)
+
+    /* Affine transformations are handled above, so these only get the
+     * projective ones.
+     */
+#define PROJECTIVE_FAST_PATH(name, format, repeat, filter, FILTER)	\
+    { PIXMAN_ ## format,						\
+      (FAST_PATH_NO_ALPHA_MAP | FAST_PATH_NO_ACCESSORS |		\
+       FAST_PATH_HAS_TRANSFORM | FAST_PATH_ ## FILTER ## _FILTER |	\
+       FAST_PATH_ ## repeat ## _REPEAT),				\
+      bits_image_fetch_ ## filter ## _projective_ ## name,		\
+      _pixman_image_get_scanline_generic_float				\
+    },
+
+#define PROJECTIVE_FAST_PATHS(name, format, repeat)			\
+    PROJECTIVE_FAST_PATH (name, format, repeat, bilinear, BILINEAR)	\
+    PROJECTIVE_FAST_PATH (name, format, repeat, nearest, NEAREST)
+
+    PROJECTIVE_FAST_PATHS (pad_a8r8g8b8, a8r8g8b8, PAD)
+    PROJECTIVE_FAST_PATHS (none_a8r8g8b8, a8r8g8b8, NONE)
+    PROJECTIVE_FAST_PATHS (reflect_a8r8g8b8, a8r8g8b8, REFLECT)
+    PROJECTIVE_FAST_PATHS (normal_a8r8g8b8, a8r8g8b8, NORMAL)
+    PROJECTIVE_FAST_PATHS (pad_x8r8g8b8, x8r8g8b8, PAD)
+    PROJECTIVE_FAST_PATHS (none_x8r8g8b8, x8r8g8b8, NONE)
+    PROJECTIVE_FAST_PATHS (reflect_x8r8g8b8, x8r8g8b8, REFLECT)
+    PROJECTIVE_FAST_PATHS (normal_x8r8g8b8, x8r8g8b8, NORMAL)
+
     /* Affine, no alpha */
     { PIXMAN_any,
       (FAST_PATH_NO_ALPHA_MAP | FAST_PATH_HAS_TRANSFORM | FAST_PATH_AFFINE_TRANSFORM),
@@ -1490,30 +1766,459 @@ bits_image_property_changed (pixman_image_t *image)
     _pixman_bits_image_setup_accessors (&image->bits);
 }
 
-void
-_pixman_bits_image_src_iter_init (pixman_image_t *image, pixman_iter_t *iter)
-{
-    pixman_format_code_t format = image->common.extended_format_code;
-    uint32_t flags = image->common.flags;
-    const fetcher_info_t *info;
+/*
+ * Two-pass scaling
+ *
+ * When the transformation only scales, the horizontal position in the
+ * source depends only on the destination column and the vertical position
+ * only on the destination row. The horizontal taps are then applied once
+ * to each source row that is needed, and each destination row is computed
+ * from those filtered rows with the vertical taps. That is
+ * O(taps_x + taps_y) per pixel instead of O(taps_x * taps_y). The filtered
+ * rows are kept in a ring buffer with one slot per vertical tap, so
+ * destination rows that share source rows reuse them.
+ *
+ * Bilinear filtering gives the same results as the one-pass fetchers.
+ * Separable convolutions don't round the product of the two coefficients
+ * of each tap, so they can be off by one from the one-pass fetchers.
+ */
+#define SCALER_MAX_EXTENDED_WIDTH	(1 << 20)
+#define SCALER_MAX_RING_SIZE		(16 << 20)
 
-    for (info = fetcher_info; info->format != PIXMAN_null; ++info)
+typedef struct
+{
+    pixman_bool_t		separable;
+    int				n_taps[2];
+    const int32_t *		weights[2];
+    int				phase_shift[2];
+    pixman_fixed_t		offset[2];
+    int32_t			bilinear_weights[2 * BILINEAR_INTERPOLATION_RANGE];
+
+    /* Horizontal pass */
+    const int32_t **		column_weights;
+    int32_t *			columns;
+    int				fetch_x;
+    int				fetch_width;
+    int				ext_width;
+    int32_t *			map;
+    uint32_t *			row;
+    uint32_t *			ext;
+
+    /* Vertical pass */
+    int32_t *			ring;
+    int32_t *			ring_rows;
+    const int32_t **		taps;
+} scaler_t;
+
+/* Finds the first source pixel and the weights of the taps for a
+ * position along axis 0 (x) or 1 (y).
+ */
+static force_inline void
+scaler_locate (const scaler_t *s, int axis, pixman_fixed_t v,
+	       int *first, const int32_t **weights)
+{
+    if (s->separable)
     {
-	if ((info->format == format || info->format == PIXMAN_any)	&&
-	    (info->flags & flags) == info->flags)
-	{
-	    if (iter->iter_flags & ITER_NARROW)
-	    {
-		iter->get_scanline = info->get_scanline_32;
-	    }
-	    else
-	    {
-		iter->data = info->get_scanline_32;
-		iter->get_scanline = info->get_scanline_float;
-	    }
-	    return;
-	}
-    }
+	int shift = s->phase_shift[axis];
+
+	/* Round to the middle of the closest phase, as the one-pass
+	 * fetchers do.
+	 */
+	v = ((v >> shift) << shift) + ((1 << shift) >> 1);
+
+	*first = pixman_fixed_to_int (v - pixman_fixed_e - s->offset[axis]);
+	*weights = s->weights[axis] + ((v & 0xffff) >> shift) * s->n_taps[axis];
+    }
+    else
+    {
+	v -= pixman_fixed_1 / 2;
+
+	*first = pixman_fixed_to_int (v);
+	*weights = s->bilinear_weights + 2 * pixman_fixed_to_bilinear_weight (v);
+    }
+}
+
+static void
+scaler_filter_row (scaler_t *s, pixman_image_t *image, int y, int width,
+		   int32_t *out)
+{
+    int i, j, k;
+
+    if (!repeat (image->common.repeat, &y, image->bits.height))
+    {
+	memset (out, 0, width * 4 * sizeof (int32_t));
+	return;
+    }
+
+    if (s->fetch_width > 0)
+    {
+	image->bits.fetch_scanline_32 (
+	    image, s->fetch_x, y, s->fetch_width, s->row, NULL);
+    }
+
+    for (i = 0; i < s->ext_width; ++i)
+	s->ext[i] = s->map[i] >= 0 ? s->row[s->map[i]] : 0;
+
+    if (!s->separable)
+    {
+	for (k = 0; k < width; ++k)
+	{
+	    const uint32_t *p = s->ext + s->columns[k];
+	    const int32_t *w = s->column_weights[k];
+	    uint32_t l = p[0], r = p[1];
+
+	    *out++ = (int32_t)ALPHA_8 (l) * w[0] + (int32_t)ALPHA_8 (r) * w[1];
+	    *out++ = (int32_t)RED_8 (l) * w[0] + (int32_t)RED_8 (r) * w[1];
+	    *out++ = (int32_t)GREEN_8 (l) * w[0] + (int32_t)GREEN_8 (r) * w[1];
+	    *out++ = (int32_t)BLUE_8 (l) * w[0] + (int32_t)BLUE_8 (r) * w[1];
+	}
+
+	return;
+    }
+
+    for (k = 0; k < width; ++k)
+    {
+	const uint32_t *p = s->ext + s->columns[k];
+	const int32_t *w = s->column_weights[k];
+	int32_t satot, srtot, sgtot, sbtot;
+
+	satot = srtot = sgtot = sbtot = 0;
+
+	for (j = 0; j < s->n_taps[0]; ++j)
+	{
+	    int32_t f = w[j];
+
+	    if (f)
+	    {
+		uint32_t pixel = p[j];
+
+		satot += (int32_t)ALPHA_8 (pixel) * f;
+		srtot += (int32_t)RED_8 (pixel) * f;
+		sgtot += (int32_t)GREEN_8 (pixel) * f;
+		sbtot += (int32_t)BLUE_8 (pixel) * f;
+	    }
+	}
+
+	*out++ = satot;
+	*out++ = srtot;
+	*out++ = sgtot;
+	*out++ = sbtot;
+    }
+}
+
+static uint32_t *
+scaler_get_scanline (pixman_iter_t *iter, const uint32_t *mask)
+{
+    pixman_image_t *image = iter->image;
+    scaler_t *s = iter->data;
+    int width = iter->width;
+    int n_taps = s->n_taps[1];
+    const int32_t *weights;
+    pixman_vector_t v;
+    int y1, i, k;
+
+    /* reference point is the center of the pixel */
+    v.vector[0] = pixman_int_to_fixed (iter->x) + pixman_fixed_1 / 2;
+    v.vector[1] = pixman_int_to_fixed (iter->y++) + pixman_fixed_1 / 2;
+    v.vector[2] = pixman_fixed_1;
+
+    if (!pixman_transform_point_3d (image->common.transform, &v))
+	return iter->buffer;
+
+    scaler_locate (s, 1, v.vector[1], &y1, &weights);
+
+    for (i = 0; i < n_taps; ++i)
+    {
+	int y = y1 + i;
+	int slot = MOD (y, n_taps);
+	int32_t *row = s->ring + slot * width * 4;
+
+	s->taps[i] = NULL;
+
+	if (!weights[i])
+	    continue;
+
+	if (s->ring_rows[slot] != y)
+	{
+	    scaler_filter_row (s, image, y, width, row);
+	    s->ring_rows[slot] = y;
+	}
+
+	s->taps[i] = row;
+    }
+
+    if (!s->separable)
+    {
+	/* The sums are exact, so this gives the same result as
+	 * bilinear_interpolation()
+	 */
+	const int32_t *top = s->taps[0], *bottom = s->taps[1];
+	int32_t wt = weights[0], wb = weights[1];
+	uint32_t *buffer = iter->buffer;
+
+	if (!bottom)
+	    bottom = top;
+
+	for (k = 0; k < width; ++k)
+	{
+	    if (!mask || mask[k])
+	    {
+		buffer[k] =
+		    (((top[0] * wt + bottom[0] * wb) & 0xff0000) << 8)	|
+		    (((top[1] * wt + bottom[1] * wb) & 0xff0000) >> 0)	|
+		    (((top[2] * wt + bottom[2] * wb) & 0xff0000) >> 8)	|
+		    (((top[3] * wt + bottom[3] * wb) & 0xff0000) >> 16);
+	    }
+
+	    top += 4;
+	    bottom += 4;
+	}
+
+	return iter->buffer;
+    }
+
+    for (k = 0; k < width; ++k)
+    {
+	int64_t satot, srtot, sgtot, sbtot;
+
+	if (mask && !mask[k])
+	    continue;
+
+	satot = srtot = sgtot = sbtot = 1LL << 31;
+
+	for (i = 0; i < n_taps; ++i)
+	{
+	    const int32_t *p = s->taps[i];
+
+	    if (p)
+	    {
+		int64_t f = weights[i];
+
+		p += 4 * k;
+
+		satot += p[0] * f;
+		srtot += p[1] * f;
+		sgtot += p[2] * f;
+		sbtot += p[3] * f;
+	    }
+	}
+
+	satot = CLIP (satot >> 32, 0, 0xff);
+	srtot = CLIP (srtot >> 32, 0, 0xff);
+	sgtot = CLIP (sgtot >> 32, 0, 0xff);
+	sbtot = CLIP (sbtot >> 32, 0, 0xff);
+
+	iter->buffer[k] = (uint32_t)((satot << 24) | (srtot << 16) |
+				     (sgtot << 8) | (sbtot << 0));
+    }
+
+    return iter->buffer;
+}
+
+static void
+scaler_fini (pixman_iter_t *iter)
+{
+    scaler_t *s = iter->data;
+
+    free (s->taps);
+    free (s);
+}
+
+#define SCALER_FLAGS							\
+    (FAST_PATH_NO_ALPHA_MAP		|				\
+     FAST_PATH_HAS_TRANSFORM		|				\
+     FAST_PATH_AFFINE_TRANSFORM		|				\
+     FAST_PATH_SCALE_TRANSFORM)
+
+static pixman_bool_t
+scaler_iter_init (pixman_image_t *image, pixman_iter_t *iter)
+{
+    uint32_t flags = image->common.flags;
+    pixman_fixed_t *params = image->common.filter_params;
+    int width = iter->width;
+    int x_min, x_max, src_min, src_max;
+    size_t ring_size;
+    pixman_fixed_t vx;
+    pixman_vector_t v;
+    scaler_t *s;
+    int i, k;
+
+    if (!(iter->iter_flags & ITER_NARROW)			||
+	iter->height < 2					||
+	(flags & SCALER_FLAGS) != SCALER_FLAGS)
+    {
+	return FALSE;
+    }
+
+    /* Bilinear filtering only has two taps, so there is only something
+     * to gain when source rows are used for more than one destination
+     * row, that is, when scaling up vertically.
+     */
+    if (!(flags & FAST_PATH_SEPARABLE_CONVOLUTION_FILTER)	&&
+	((flags & (FAST_PATH_BILINEAR_FILTER | FAST_PATH_NEAREST_FILTER)) !=
+	 FAST_PATH_BILINEAR_FILTER					||
+	 abs (image->common.transform->matrix[1][1]) >= pixman_fixed_1))
+    {
+	return FALSE;
+    }
+
+    v.vector[0] = pixman_int_to_fixed (iter->x) + pixman_fixed_1 / 2;
+    v.vector[1] = pixman_int_to_fixed (iter->y) + pixman_fixed_1 / 2;
+    v.vector[2] = pixman_fixed_1;
+
+    if (!pixman_transform_point_3d (image->common.transform, &v))
+	return FALSE;
+
+    s = malloc (sizeof (scaler_t) +
+		width * (sizeof (const int32_t *) + sizeof (int32_t)));
+    if (!s)
+	return FALSE;
+
+    s->column_weights = (const int32_t **)(s + 1);
+    s->columns = (int32_t *)(s->column_weights + width);
+
+    if (flags & FAST_PATH_SEPARABLE_CONVOLUTION_FILTER)
+    {
+	int x_phase_bits = pixman_fixed_to_int (params[2]);
+
+	s->separable = TRUE;
+	s->n_taps[0] = pixman_fixed_to_int (params[0]);
+	s->n_taps[1] = pixman_fixed_to_int (params[1]);
+	s->weights[0] = params + 4;
+	s->weights[1] = params + 4 + (1 << x_phase_bits) * s->n_taps[0];
+	s->phase_shift[0] = 16 - x_phase_bits;
+	s->phase_shift[1] = 16 - pixman_fixed_to_int (params[3]);
+	s->offset[0] = ((s->n_taps[0] << 16) - pixman_fixed_1) >> 1;
+	s->offset[1] = ((s->n_taps[1] << 16) - pixman_fixed_1) >> 1;
+    }
+    else
+    {
+	/* The same weights as bilinear_interpolation() uses */
+	s->separable = FALSE;
+	s->n_taps[0] = s->n_taps[1] = 2;
+
+	for (i = 0; i < BILINEAR_INTERPOLATION_RANGE; ++i)
+	{
+	    int d = i << (8 - BILINEAR_INTERPOLATION_BITS);
+
+	    s->bilinear_weights[2 * i] = 256 - d;
+	    s->bilinear_weights[2 * i + 1] = d;
+	}
+    }
+
+    /* Source columns of the horizontal taps */
+    x_min = INT32_MAX;
+    x_max = INT32_MIN;
+    vx = v.vector[0];
+
+    for (k = 0; k < width; ++k)
+    {
+	scaler_locate (s, 0, vx, &s->columns[k], &s->column_weights[k]);
+
+	if (s->columns[k] < x_min)
+	    x_min = s->columns[k];
+	if (s->columns[k] > x_max)
+	    x_max = s->columns[k];
+
+	vx += image->common.transform->matrix[0][0];
+    }
+
+    s->ext_width = x_max - x_min + s->n_taps[0];
+    ring_size = (size_t)s->n_taps[1] * width * 4 * sizeof (int32_t);
+
+    if (s->ext_width > SCALER_MAX_EXTENDED_WIDTH	||
+	ring_size > SCALER_MAX_RING_SIZE)
+    {
+	free (s);
+	return FALSE;
+    }
+
+    for (k = 0; k < width; ++k)
+	s->columns[k] -= x_min;
+
+    /* The source columns that the extended row is made of */
+    src_min = INT32_MAX;
+    src_max = INT32_MIN;
+
+    for (i = 0; i < s->ext_width; ++i)
+    {
+	int x = x_min + i;
+
+	if (repeat (image->common.repeat, &x, image->bits.width))
+	{
+	    if (x < src_min)
+		src_min = x;
+	    if (x > src_max)
+		src_max = x;
+	}
+    }
+
+    s->fetch_x = src_min;
+    s->fetch_width = src_max >= src_min ? src_max - src_min + 1 : 0;
+
+    s->taps = malloc (s->n_taps[1] * (sizeof (const int32_t *) + sizeof (int32_t)) +
+		      ring_size +
+		      s->ext_width * (sizeof (int32_t) + sizeof (uint32_t)) +
+		      s->fetch_width * sizeof (uint32_t));
+    if (!s->taps)
+    {
+	free (s);
+	return FALSE;
+    }
+
+    s->ring_rows = (int32_t *)(s->taps + s->n_taps[1]);
+    s->ring = s->ring_rows + s->n_taps[1];
+    s->map = s->ring + s->n_taps[1] * width * 4;
+    s->ext = (uint32_t *)(s->map + s->ext_width);
+    s->row = s->ext + s->ext_width;
+
+    for (i = 0; i < s->ext_width; ++i)
+    {
+	int x = x_min + i;
+
+	if (repeat (image->common.repeat, &x, image->bits.width))
+	    s->map[i] = x - src_min;
+	else
+	    s->map[i] = -1;
+    }
+
+    for (i = 0; i < s->n_taps[1]; ++i)
+	s->ring_rows[i] = INT32_MIN;
+
+    iter->data = s;
+    iter->get_scanline = scaler_get_scanline;
+    iter->fini = scaler_fini;
+
+    return TRUE;
+}
+
+void
+_pixman_bits_image_src_iter_init (pixman_image_t *image, pixman_iter_t *iter)
+{
+    pixman_format_code_t format = image->common.extended_format_code;
+    uint32_t flags = image->common.flags;
+    const fetcher_info_t *info;
+
+    if (scaler_iter_init (image, iter))
+	return;
+
+    for (info = fetcher_info; info->format != PIXMAN_null; ++info)
+    {
+	if ((info->format == format || info->format == PIXMAN_any)	&&
+	    (info->flags & flags) == info->flags)
+	{
+	    if (iter->iter_flags & ITER_NARROW)
+	    {
+		iter->get_scanline = info->get_scanline_32;
+	    }
+	    else
+	    {
+		iter->data = info->get_scanline_32;
+		iter->get_scanline = info->get_scanline_float;
+	    }
+	    return;
+	}
+    }
 
     /* Just in case we somehow didn't find a scanline function */
     iter->get_scanline = _pixman_iter_get_scanline_noop;
@@ -1663,12 +2368,17 @@ _pixman_bits_image_dest_iter_init (pixman_image_t *image, pixman_iter_t *iter)
     }
 }
 
+/* The stride is a multiple of 'alignment' bytes, which is a power of two.
+ * When it is more than the alignment of malloc(), the buffer has room to
+ * move its start to the next multiple of 'alignment'.
+ */
 static uint32_t *
 create_bits (pixman_format_code_t format,
              int                  width,
              int                  height,
              int *		  rowstride_bytes,
-	     pixman_bool_t	  clear)
+	     pixman_bool_t	  clear,
+	     int		  alignment)
 {
     int stride;
     size_t buf_size;
@@ -1676,7 +2386,7 @@ create_bits (pixman_format_code_t format,
 
     /* what follows is a long-winded way, avoiding any possibility of integer
      * overflows, of saying:
-     * stride = ((width * bpp + 0x1f) >> 5) * sizeof (uint32_t);
+     * stride = ((width * bpp + alignment * 8 - 1) / (alignment * 8)) * alignment;
      */
 
     bpp = PIXMAN_FORMAT_BPP (format);
@@ -1684,19 +2394,27 @@ create_bits (pixman_format_code_t format,
 	return NULL;
 
     stride = width * bpp;
-    if (_pixman_addition_overflows_int (stride, 0x1f))
+    if (_pixman_addition_overflows_int (stride, alignment * 8 - 1))
 	return NULL;
 
-    stride += 0x1f;
-    stride >>= 5;
+    stride += alignment * 8 - 1;
+    stride /= alignment * 8;
 
-    stride *= sizeof (uint32_t);
+    stride *= alignment;
 
     if (_pixman_multiply_overflows_size (height, stride))
 	return NULL;
 
     buf_size = height * stride;
 
+    if (alignment > (int) sizeof (uint32_t))
+    {
+	if (buf_size + alignment < buf_size)
+	    return NULL;
+
+	buf_size += alignment;
+    }
+
     if (rowstride_bytes)
 	*rowstride_bytes = stride;
 
@@ -1706,6 +2424,314 @@ create_bits (pixman_format_code_t format,
 	return malloc (buf_size);
 }
 
+/* Mipmaps
+ *
+ * With pixman_image_set_mipmap(), bilinear downscales by a factor of two
+ * or more sample a box filtered copy of the image, reduced by the largest
+ * power of two that keeps the remaining scale above one. This removes the
+ * aliasing, and the cost of the composite depends on the destination size
+ * rather than the source size. The levels are built on demand and chained
+ * through mip_level.
+ *
+ * Several threads may composite from the same image, so a level is never
+ * changed once it is in the chain. Each composite samples it through a
+ * copy of its header with its own transform, filter and repeat.
+ */
+#ifndef PIXMAN_NO_ATOMICS
+static pixman_spin_lock_t mip_level_lock;
+#endif
+
+static pixman_bool_t
+mipmap_format_supported (pixman_format_code_t format)
+{
+    switch (format)
+    {
+    case PIXMAN_a8r8g8b8:
+    case PIXMAN_x8r8g8b8:
+    case PIXMAN_a8b8g8r8:
+    case PIXMAN_x8b8g8r8:
+    case PIXMAN_b8g8r8a8:
+    case PIXMAN_b8g8r8x8:
+    case PIXMAN_r8g8b8a8:
+    case PIXMAN_r8g8b8x8:
+	return TRUE;
+
+    default:
+	return FALSE;
+    }
+}
+
+/* Averages four pixels, two channels at a time */
+static force_inline uint32_t
+mip_average (uint32_t p0, uint32_t p1, uint32_t p2, uint32_t p3)
+{
+    uint32_t rb, ag;
+
+    rb = (p0 & 0x00ff00ff) + (p1 & 0x00ff00ff) +
+	 (p2 & 0x00ff00ff) + (p3 & 0x00ff00ff) + 0x00020002;
+    ag = ((p0 >> 8) & 0x00ff00ff) + ((p1 >> 8) & 0x00ff00ff) +
+	 ((p2 >> 8) & 0x00ff00ff) + ((p3 >> 8) & 0x00ff00ff) + 0x00020002;
+
+    return ((rb >> 2) & 0x00ff00ff) | (((ag >> 2) & 0x00ff00ff) << 8);
+}
+
+/* Averages 2x2 blocks. For odd widths, the last column is averaged with
+ * itself when the edges are padded, and with transparent black otherwise.
+ * A NULL row1 stands for a row of transparent black. The bits in alpha
+ * are set in every pixel of the image before it is averaged.
+ */
+static void
+mip_reduce_scanline (uint32_t *       dst,
+		     const uint32_t * row0,
+		     const uint32_t * row1,
+		     int              src_width,
+		     pixman_bool_t    pad,
+		     uint32_t         alpha)
+{
+    uint32_t p0, p1, p2 = 0, p3 = 0;
+    int i;
+
+    for (i = 0; i < src_width >> 1; ++i)
+    {
+	p0 = row0[2 * i] | alpha;
+	p1 = row0[2 * i + 1] | alpha;
+	if (row1)
+	{
+	    p2 = row1[2 * i] | alpha;
+	    p3 = row1[2 * i + 1] | alpha;
+	}
+
+	dst[i] = mip_average (p0, p1, p2, p3);
+    }
+
+    if (src_width & 1)
+    {
+	p0 = row0[src_width - 1] | alpha;
+	if (row1)
+	    p2 = row1[src_width - 1] | alpha;
+
+	if (pad)
+	    dst[i] = mip_average (p0, p0, p2, p2);
+	else
+	    dst[i] = mip_average (p0, 0, p2, 0);
+    }
+}
+
+/* Levels of odd sized images without padding have transparent pixels at
+ * their edges, so they can't be stored in a format without alpha. Such
+ * levels get the matching format with alpha, and the alpha bits are set
+ * in the image before it is averaged.
+ */
+static pixman_format_code_t
+mip_level_format (bits_image_t *bits, pixman_bool_t pad, uint32_t *alpha)
+{
+    *alpha = 0;
+
+    if (pad || !((bits->width | bits->height) & 1))
+	return bits->format;
+
+    switch (bits->format)
+    {
+    case PIXMAN_x8r8g8b8:
+	*alpha = 0xff000000;
+	return PIXMAN_a8r8g8b8;
+
+    case PIXMAN_x8b8g8r8:
+	*alpha = 0xff000000;
+	return PIXMAN_a8b8g8r8;
+
+    case PIXMAN_b8g8r8x8:
+	*alpha = 0x000000ff;
+	return PIXMAN_b8g8r8a8;
+
+    case PIXMAN_r8g8b8x8:
+	*alpha = 0x000000ff;
+	return PIXMAN_r8g8b8a8;
+
+    default:
+	return bits->format;
+    }
+}
+
+static pixman_image_t *
+create_mip_level (bits_image_t *bits, pixman_bool_t pad)
+{
+    pixman_format_code_t format;
+    pixman_image_t *level;
+    uint32_t alpha;
+    int y;
+
+    format = mip_level_format (bits, pad, &alpha);
+
+    level = pixman_image_create_bits_no_clear (
+	format, (bits->width + 1) >> 1, (bits->height + 1) >> 1, NULL, 0);
+
+    if (level)
+    {
+	for (y = 0; y < level->bits.height; ++y)
+	{
+	    const uint32_t *row0 = bits->bits + 2 * y * bits->rowstride;
+	    const uint32_t *row1 = row0 + bits->rowstride;
+
+	    /* For odd heights, the last row is averaged with itself or
+	     * with a transparent row.
+	     */
+	    if (2 * y + 1 == bits->height)
+		row1 = pad ? row0 : NULL;
+
+	    mip_reduce_scanline (level->bits.bits + y * level->bits.rowstride,
+				 row0, row1, bits->width, pad, alpha);
+	}
+    }
+
+    return level;
+}
+
+/* Returns the next level of the chain, building it if necessary. Levels
+ * are built outside of the lock, so another thread may have added the
+ * same level in the meantime; the first one stays.
+ */
+static pixman_image_t *
+get_mip_level (bits_image_t *bits, pixman_bool_t pad)
+{
+#ifdef PIXMAN_NO_ATOMICS
+    return NULL;
+#else
+    pixman_image_t *level, *evicted = NULL;
+
+    PIXMAN_SPIN_LOCK (&mip_level_lock);
+    level = bits->mip_level;
+    PIXMAN_SPIN_UNLOCK (&mip_level_lock);
+
+    if (level)
+	return level;
+
+    if (!(level = create_mip_level (bits, pad)))
+	return NULL;
+
+    PIXMAN_SPIN_LOCK (&mip_level_lock);
+    if (bits->mip_level)
+    {
+	evicted = level;
+	level = bits->mip_level;
+    }
+    else
+    {
+	bits->mip_level = level;
+    }
+    PIXMAN_SPIN_UNLOCK (&mip_level_lock);
+
+    if (evicted)
+	pixman_image_unref (evicted);
+
+    return level;
+#endif
+}
+
+/* Returns the image to composite in place of image: either image itself,
+ * or header, which is then set up as a copy of a level with the transform
+ * adjusted to its size and stored in level_transform.
+ */
+pixman_image_t *
+_pixman_bits_image_select_mip_level (pixman_image_t *    image,
+				     pixman_image_t *    header,
+				     pixman_transform_t *level_transform)
+{
+    pixman_transform_t *transform = image->common.transform;
+    pixman_bool_t pad = image->common.repeat != PIXMAN_REPEAT_NONE;
+    pixman_image_t *level;
+    double scale;
+    int n, i, j;
+
+    if (image->type != BITS || !image->bits.mipmap)
+	return image;
+
+    if (!transform						||
+	transform->matrix[2][0] != 0				||
+	transform->matrix[2][1] != 0				||
+	transform->matrix[2][2] != pixman_fixed_1		||
+	!mipmap_format_supported (image->bits.format)		||
+	image->common.alpha_map					||
+	image->bits.read_func || image->bits.write_func		||
+	(image->common.clip_sources && image->common.client_clip))
+    {
+	return image;
+    }
+
+    if (image->common.filter != PIXMAN_FILTER_BILINEAR	&&
+	image->common.filter != PIXMAN_FILTER_GOOD		&&
+	image->common.filter != PIXMAN_FILTER_BEST)
+    {
+	return image;
+    }
+
+    /* The distance between the samples of adjacent destination pixels */
+    scale = MIN (
+	hypot (transform->matrix[0][0], transform->matrix[1][0]),
+	hypot (transform->matrix[0][1], transform->matrix[1][1])) / pixman_fixed_1;
+
+    level = image;
+    n = 0;
+
+    while (scale >= 2.0 && n < 16)
+    {
+	bits_image_t *bits = &level->bits;
+	pixman_image_t *next;
+
+	/* NORMAL and REFLECT need the levels to tile like the image */
+	if (image->common.repeat != PIXMAN_REPEAT_NONE	&&
+	    image->common.repeat != PIXMAN_REPEAT_PAD		&&
+	    ((bits->width | bits->height) & 1))
+	{
+	    break;
+	}
+
+	if (bits->width <= 1 && bits->height <= 1)
+	    break;
+
+	if (!(next = get_mip_level (bits, pad)))
+	    break;
+
+	level = next;
+	scale /= 2;
+	n++;
+    }
+
+    if (n == 0)
+	return image;
+
+    /* Level n pixel x covers the image pixels [x << n, (x + 1) << n) */
+    *level_transform = *transform;
+    for (i = 0; i < 2; ++i)
+    {
+	for (j = 0; j < 3; ++j)
+	{
+	    level_transform->matrix[i][j] =
+		(transform->matrix[i][j] + ((1 << n) >> 1)) >> n;
+	}
+    }
+
+    *header = *level;
+    header->common.transform = level_transform;
+    header->common.filter = image->common.filter;
+    header->common.repeat = image->common.repeat;
+    header->common.component_alpha = image->common.component_alpha;
+    header->common.dirty = TRUE;
+
+    return header;
+}
+
+void
+_pixman_bits_image_discard_mipmap (pixman_image_t *image)
+{
+    if (image->type == BITS && image->bits.mip_level)
+    {
+	pixman_image_unref (image->bits.mip_level);
+
+	image->bits.mip_level = NULL;
+    }
+}
+
 pixman_bool_t
 _pixman_bits_image_init (pixman_image_t *     image,
                          pixman_format_code_t format,
@@ -1721,7 +2747,8 @@ _pixman_bits_image_init (pixman_image_t *     image,
     {
 	int rowstride_bytes;
 
-	free_me = bits = create_bits (format, width, height, &rowstride_bytes, clear);
+	free_me = bits = create_bits (
+	    format, width, height, &rowstride_bytes, clear, sizeof (uint32_t));
 
 	if (!bits)
 	    return FALSE;
@@ -1741,6 +2768,8 @@ _pixman_bits_image_init (pixman_image_t *     image,
     image->bits.write_func = NULL;
     image->bits.rowstride = rowstride;
     image->bits.indexed = NULL;
+    image->bits.mipmap = FALSE;
+    image->bits.mip_level = NULL;
 
     image->common.property_changed = bits_image_property_changed;
 
@@ -1806,3 +2835,46 @@ pixman_image_create_bits_no_clear (pixman_format_code_t format,
     return create_bits_image_internal (
 	format, width, height, bits, rowstride_bytes, FALSE);
 }
+
+/* Rows of images created by pixman_image_create_bits_aligned() start on
+ * cache line boundaries.
+ */
+#define BITS_ALIGNMENT 64
+
+/* The buffer is allocated, initialized to 0 and freed by pixman. Its
+ * start and the stride are multiples of 64 bytes, so that SIMD code can
+ * use aligned loads and stores on every row.
+ */
+PIXMAN_EXPORT pixman_image_t *
+pixman_image_create_bits_aligned (pixman_format_code_t format,
+				  int                  width,
+				  int                  height)
+{
+    pixman_image_t *image;
+    uint32_t *free_me, *bits;
+    int rowstride_bytes;
+
+    return_val_if_fail (PIXMAN_FORMAT_BPP (format) >= PIXMAN_FORMAT_DEPTH (format), NULL);
+
+    free_me = create_bits (
+	format, width, height, &rowstride_bytes, TRUE, BITS_ALIGNMENT);
+
+    if (!free_me)
+	return NULL;
+
+    bits = (uint32_t *)(((uintptr_t)free_me + BITS_ALIGNMENT - 1) &
+			~(uintptr_t)(BITS_ALIGNMENT - 1));
+
+    image = create_bits_image_internal (
+	format, width, height, bits, rowstride_bytes, FALSE);
+
+    if (!image)
+    {
+	free (free_me);
+	return NULL;
+    }
+
+    image->bits.free_me = free_me;
+
+    return image;
+}
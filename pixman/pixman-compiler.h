@@ -224,3 +224,79 @@
 #    error "Unknown thread local support for this system. Pixman will not work with multiple threads. Define PIXMAN_NO_TLS to acknowledge and accept this limitation and compile pixman without thread-safety support."
 
 #endif
+
+/* Atomic reference counts and spin locks */
+#if defined(PIXMAN_NO_TLS)
+
+/* Without thread safety, nothing needs to be atomic */
+typedef int pixman_spin_lock_t;
+
+#   define PIXMAN_ATOMIC_INC(p)		(++*(p))
+#   define PIXMAN_ATOMIC_DEC(p)		(--*(p))
+#   define PIXMAN_SPIN_LOCK(p)		((void)(p))
+#   define PIXMAN_SPIN_UNLOCK(p)	((void)(p))
+
+#elif defined(__GNUC__)
+
+typedef volatile int pixman_spin_lock_t;
+
+#   define PIXMAN_ATOMIC_INC(p)		__sync_add_and_fetch ((p), 1)
+#   define PIXMAN_ATOMIC_DEC(p)		__sync_sub_and_fetch ((p), 1)
+#   if defined(__i386__) || defined(__x86_64__)
+#      define PIXMAN_CPU_RELAX()	__builtin_ia32_pause ()
+#   elif defined(__aarch64__) || (defined(__arm__) && defined(__ARM_ARCH) && __ARM_ARCH >= 7)
+#      define PIXMAN_CPU_RELAX()	__asm__ __volatile__ ("yield" ::: "memory")
+#   else
+#      define PIXMAN_CPU_RELAX()	__asm__ __volatile__ ("" ::: "memory")
+#   endif
+
+/* Wait on a plain read so that the cache line stays shared while the
+ * lock is held, and only retry the exchange once it looks free.
+ */
+#   define PIXMAN_SPIN_LOCK(p)					\
+    do								\
+    {								\
+	while (__sync_lock_test_and_set ((p), 1))		\
+	{							\
+	    while (*(p))					\
+		PIXMAN_CPU_RELAX ();				\
+	}							\
+    } while (0)
+#   define PIXMAN_SPIN_UNLOCK(p)	__sync_lock_release (p)
+
+#elif defined(_MSC_VER)
+
+#include <intrin.h>
+
+typedef volatile long pixman_spin_lock_t;
+
+#   define PIXMAN_ATOMIC_INC(p)		_InterlockedIncrement ((long volatile *)(p))
+#   define PIXMAN_ATOMIC_DEC(p)		_InterlockedDecrement ((long volatile *)(p))
+#   if defined(_M_IX86) || defined(_M_X64)
+#      define PIXMAN_CPU_RELAX()	_mm_pause ()
+#   elif defined(_M_ARM) || defined(_M_ARM64)
+#      define PIXMAN_CPU_RELAX()	__yield ()
+#   else
+#      define PIXMAN_CPU_RELAX()	_ReadWriteBarrier ()
+#   endif
+
+#   define PIXMAN_SPIN_LOCK(p)					\
+    do								\
+    {								\
+	while (_InterlockedExchange ((p), 1))			\
+	{							\
+	    while (*(p))					\
+		PIXMAN_CPU_RELAX ();				\
+	}							\
+    } while (0)
+#   define PIXMAN_SPIN_UNLOCK(p)	_InterlockedExchange ((p), 0)
+
+#else
+
+/* Data that would have to be shared between threads is kept private */
+#   define PIXMAN_NO_ATOMICS
+
+#   define PIXMAN_ATOMIC_INC(p)		(++*(p))
+#   define PIXMAN_ATOMIC_DEC(p)		(--*(p))
+
+#endif
@@ -952,6 +952,64 @@ fast_composite_add_1_1 (pixman_implementation_t *imp,
     }
 }
 
+static void
+fast_composite_add_n_1_8 (pixman_implementation_t *imp,
+			  pixman_composite_info_t *info)
+{
+    PIXMAN_COMPOSITE_ARGS (info);
+    uint8_t     *dst, *dst_line;
+    uint32_t    *mask, *mask_line;
+    int          mask_stride, dst_stride;
+    uint32_t     bitcache, bitmask;
+    uint32_t     src;
+    uint8_t      sa;
+    int32_t      w;
+
+    if (width <= 0)
+	return;
+
+    src = _pixman_image_get_solid (imp, src_image, dest_image->bits.format);
+    sa = src >> 24;
+    if (sa == 0)
+	return;
+
+    PIXMAN_IMAGE_GET_LINE (dest_image, dest_x, dest_y, uint8_t,
+                           dst_stride, dst_line, 1);
+    PIXMAN_IMAGE_GET_LINE (mask_image, 0, mask_y, uint32_t,
+                           mask_stride, mask_line, 1);
+    mask_line += mask_x >> 5;
+
+    while (height--)
+    {
+	dst = dst_line;
+	dst_line += dst_stride;
+	mask = mask_line;
+	mask_line += mask_stride;
+	w = width;
+
+	bitcache = *mask++;
+	bitmask = CREATE_BITMASK (mask_x & 31);
+
+	while (w--)
+	{
+	    if (bitmask == 0)
+	    {
+		bitcache = *mask++;
+		bitmask = CREATE_BITMASK (0);
+	    }
+	    if (bitcache & bitmask)
+	    {
+		uint16_t tmp;
+		uint32_t d = *dst;
+
+		*dst = ADD_UN8 (sa, d, tmp);
+	    }
+	    bitmask = UPDATE_BITMASK (bitmask);
+	    dst++;
+	}
+    }
+}
+
 static void
 fast_composite_over_n_1_8888 (pixman_implementation_t *imp,
                               pixman_composite_info_t *info)
@@ -1126,11 +1184,11 @@ fast_composite_over_n_1_0565 (pixman_implementation_t *imp,
  * Simple bitblt
  */
 
-static void
-fast_composite_solid_fill (pixman_implementation_t *imp,
-                           pixman_composite_info_t *info)
+static uint32_t
+solid_fill_pixel (pixman_implementation_t *imp,
+		  pixman_image_t *         src_image,
+		  pixman_image_t *         dest_image)
 {
-    PIXMAN_COMPOSITE_ARGS (info);
     uint32_t src;
 
     src = _pixman_image_get_solid (imp, src_image, dest_image->bits.format);
@@ -1149,6 +1207,18 @@ fast_composite_solid_fill (pixman_implementation_t *imp,
 	src = convert_8888_to_0565 (src);
     }
 
+    return src;
+}
+
+static void
+fast_composite_solid_fill (pixman_implementation_t *imp,
+                           pixman_composite_info_t *info)
+{
+    PIXMAN_COMPOSITE_ARGS (info);
+    uint32_t src;
+
+    src = solid_fill_pixel (imp, src_image, dest_image);
+
     pixman_fill (dest_image->bits.bits, dest_image->bits.rowstride,
                  PIXMAN_FORMAT_BPP (dest_image->bits.format),
                  dest_x, dest_y,
@@ -1156,6 +1226,29 @@ fast_composite_solid_fill (pixman_implementation_t *imp,
                  src);
 }
 
+static void
+fast_composite_solid_fill_boxes (pixman_implementation_t *imp,
+				 pixman_composite_info_t *info,
+				 const pixman_box32_t *   boxes,
+				 int                      n_boxes)
+{
+    pixman_image_t *dest_image = info->dest_image;
+    int bpp = PIXMAN_FORMAT_BPP (dest_image->bits.format);
+    uint32_t src;
+
+    src = solid_fill_pixel (imp, info->src_image, dest_image);
+
+    while (n_boxes--)
+    {
+	_pixman_implementation_fill (
+	    imp->toplevel, dest_image->bits.bits, dest_image->bits.rowstride,
+	    bpp, boxes->x1, boxes->y1,
+	    boxes->x2 - boxes->x1, boxes->y2 - boxes->y1, src);
+
+	boxes++;
+    }
+}
+
 static void
 fast_composite_src_memcpy (pixman_implementation_t *imp,
 			   pixman_composite_info_t *info)
@@ -1186,22 +1279,27 @@ FAST_NEAREST (8888_8888_cover, 8888, 8888, uint32_t, uint32_t, SRC, COVER)
 FAST_NEAREST (8888_8888_none, 8888, 8888, uint32_t, uint32_t, SRC, NONE)
 FAST_NEAREST (8888_8888_pad, 8888, 8888, uint32_t, uint32_t, SRC, PAD)
 FAST_NEAREST (8888_8888_normal, 8888, 8888, uint32_t, uint32_t, SRC, NORMAL)
+FAST_NEAREST (8888_8888_reflect, 8888, 8888, uint32_t, uint32_t, SRC, REFLECT)
 FAST_NEAREST (x888_8888_cover, x888, 8888, uint32_t, uint32_t, SRC, COVER)
 FAST_NEAREST (x888_8888_pad, x888, 8888, uint32_t, uint32_t, SRC, PAD)
 FAST_NEAREST (x888_8888_normal, x888, 8888, uint32_t, uint32_t, SRC, NORMAL)
+FAST_NEAREST (x888_8888_reflect, x888, 8888, uint32_t, uint32_t, SRC, REFLECT)
 FAST_NEAREST (8888_8888_cover, 8888, 8888, uint32_t, uint32_t, OVER, COVER)
 FAST_NEAREST (8888_8888_none, 8888, 8888, uint32_t, uint32_t, OVER, NONE)
 FAST_NEAREST (8888_8888_pad, 8888, 8888, uint32_t, uint32_t, OVER, PAD)
 FAST_NEAREST (8888_8888_normal, 8888, 8888, uint32_t, uint32_t, OVER, NORMAL)
+FAST_NEAREST (8888_8888_reflect, 8888, 8888, uint32_t, uint32_t, OVER, REFLECT)
 FAST_NEAREST (8888_565_cover, 8888, 0565, uint32_t, uint16_t, SRC, COVER)
 FAST_NEAREST (8888_565_none, 8888, 0565, uint32_t, uint16_t, SRC, NONE)
 FAST_NEAREST (8888_565_pad, 8888, 0565, uint32_t, uint16_t, SRC, PAD)
 FAST_NEAREST (8888_565_normal, 8888, 0565, uint32_t, uint16_t, SRC, NORMAL)
+FAST_NEAREST (8888_565_reflect, 8888, 0565, uint32_t, uint16_t, SRC, REFLECT)
 FAST_NEAREST (565_565_normal, 0565, 0565, uint16_t, uint16_t, SRC, NORMAL)
 FAST_NEAREST (8888_565_cover, 8888, 0565, uint32_t, uint16_t, OVER, COVER)
 FAST_NEAREST (8888_565_none, 8888, 0565, uint32_t, uint16_t, OVER, NONE)
 FAST_NEAREST (8888_565_pad, 8888, 0565, uint32_t, uint16_t, OVER, PAD)
 FAST_NEAREST (8888_565_normal, 8888, 0565, uint32_t, uint16_t, OVER, NORMAL)
+FAST_NEAREST (8888_565_reflect, 8888, 0565, uint32_t, uint16_t, OVER, REFLECT)
 
 #define REPEAT_MIN_WIDTH    32
 
@@ -1245,7 +1343,7 @@ fast_composite_tiled_repeat (pixman_implementation_t *imp,
 	src_image->common.extended_format_code, src_flags,
 	mask_format, mask_flags,
 	dest_image->common.extended_format_code, info->dest_flags,
-	&imp, &func);
+	&imp, &func, NULL);
 
     src_bpp = PIXMAN_FORMAT_BPP (src_image->bits.format);
 
@@ -1367,6 +1465,92 @@ fast_composite_tiled_repeat (pixman_implementation_t *imp,
 	_pixman_image_fini (&extended_src_image);
 }
 
+/* Gradients that have the same color along each row, such as vertical
+ * linear gradients, are composited as a series of solid rectangles, one
+ * for each run of rows with the same color. That way the solid fast
+ * paths of the implementations do the work instead of the general
+ * compositing code.
+ */
+static void
+fast_composite_row_constant (pixman_implementation_t *imp,
+			     pixman_composite_info_t *info)
+{
+    PIXMAN_COMPOSITE_ARGS (info);
+    pixman_composite_func_t func;
+    pixman_format_code_t mask_format;
+    uint32_t mask_flags;
+    pixman_image_t solid_image;
+    uint32_t solid, color, next;
+    pixman_iter_t src_iter;
+    pixman_composite_info_t info2 = *info;
+    int32_t h;
+
+    if (mask_image)
+    {
+	mask_format = mask_image->common.extended_format_code;
+	mask_flags = info->mask_flags;
+    }
+    else
+    {
+	mask_format = PIXMAN_null;
+	mask_flags = FAST_PATH_IS_OPAQUE;
+    }
+
+    /* Initialize/validate stack-allocated 1x1 repeating image. Use
+     * an alpha-less format for opaque gradients so that the solid
+     * image is known to be opaque too.
+     */
+    _pixman_bits_image_init (&solid_image,
+			     (info->src_flags & FAST_PATH_IS_OPAQUE) ?
+			     PIXMAN_x8r8g8b8 : PIXMAN_a8r8g8b8,
+			     1, 1, &solid, 1, FALSE);
+    solid_image.common.repeat = PIXMAN_REPEAT_NORMAL;
+    _pixman_image_validate (&solid_image);
+
+    _pixman_implementation_lookup_composite (
+	imp->toplevel, info->op,
+	solid_image.common.extended_format_code, solid_image.common.flags,
+	mask_format, mask_flags,
+	dest_image->common.extended_format_code, info->dest_flags,
+	&imp, &func, NULL);
+
+    _pixman_implementation_src_iter_init (
+	imp->toplevel, &src_iter, src_image, src_x, src_y, 1, height,
+	(uint8_t *)&color, ITER_NARROW, info->src_flags);
+
+    info2.src_image = &solid_image;
+    info2.src_x = 0;
+    info2.src_y = 0;
+
+    next = *src_iter.get_scanline (&src_iter, NULL);
+
+    while (height > 0)
+    {
+	solid = next;
+
+	for (h = 1; h < height; ++h)
+	{
+	    next = *src_iter.get_scanline (&src_iter, NULL);
+
+	    if (next != solid)
+		break;
+	}
+
+	info2.height = h;
+
+	func (imp, &info2);
+
+	height -= h;
+	info2.mask_y += h;
+	info2.dest_y += h;
+    }
+
+    if (src_iter.fini)
+	src_iter.fini (&src_iter);
+
+    _pixman_image_fini (&solid_image);
+}
+
 /* Use more unrolling for src_0565_0565 because it is typically CPU bound */
 static force_inline void
 scaled_nearest_scanline_565_565_SRC (uint16_t *       dst,
@@ -1415,6 +1599,9 @@ FAST_NEAREST_MAINLOOP (565_565_none_SRC,
 FAST_NEAREST_MAINLOOP (565_565_pad_SRC,
 		       scaled_nearest_scanline_565_565_SRC,
 		       uint16_t, uint16_t, PAD)
+FAST_NEAREST_MAINLOOP (565_565_reflect_SRC,
+		       scaled_nearest_scanline_565_565_SRC,
+		       uint16_t, uint16_t, REFLECT)
 
 static force_inline uint32_t
 fetch_nearest (pixman_repeat_t src_repeat,
@@ -1852,13 +2039,21 @@ static const pixman_fast_path_t c_fast_paths[] =
     PIXMAN_STD_FAST_PATH (ADD, a1, null, a1, fast_composite_add_1_1),
     PIXMAN_STD_FAST_PATH_CA (ADD, solid, a8r8g8b8, a8r8g8b8, fast_composite_add_n_8888_8888_ca),
     PIXMAN_STD_FAST_PATH (ADD, solid, a8, a8, fast_composite_add_n_8_8),
-    PIXMAN_STD_FAST_PATH (SRC, solid, null, a8r8g8b8, fast_composite_solid_fill),
-    PIXMAN_STD_FAST_PATH (SRC, solid, null, x8r8g8b8, fast_composite_solid_fill),
-    PIXMAN_STD_FAST_PATH (SRC, solid, null, a8b8g8r8, fast_composite_solid_fill),
-    PIXMAN_STD_FAST_PATH (SRC, solid, null, x8b8g8r8, fast_composite_solid_fill),
-    PIXMAN_STD_FAST_PATH (SRC, solid, null, a1, fast_composite_solid_fill),
-    PIXMAN_STD_FAST_PATH (SRC, solid, null, a8, fast_composite_solid_fill),
-    PIXMAN_STD_FAST_PATH (SRC, solid, null, r5g6b5, fast_composite_solid_fill),
+    PIXMAN_STD_FAST_PATH (ADD, solid, a1, a8, fast_composite_add_n_1_8),
+    PIXMAN_STD_FAST_PATH_BOXES (SRC, solid, null, a8r8g8b8, fast_composite_solid_fill,
+				fast_composite_solid_fill_boxes),
+    PIXMAN_STD_FAST_PATH_BOXES (SRC, solid, null, x8r8g8b8, fast_composite_solid_fill,
+				fast_composite_solid_fill_boxes),
+    PIXMAN_STD_FAST_PATH_BOXES (SRC, solid, null, a8b8g8r8, fast_composite_solid_fill,
+				fast_composite_solid_fill_boxes),
+    PIXMAN_STD_FAST_PATH_BOXES (SRC, solid, null, x8b8g8r8, fast_composite_solid_fill,
+				fast_composite_solid_fill_boxes),
+    PIXMAN_STD_FAST_PATH_BOXES (SRC, solid, null, a1, fast_composite_solid_fill,
+				fast_composite_solid_fill_boxes),
+    PIXMAN_STD_FAST_PATH_BOXES (SRC, solid, null, a8, fast_composite_solid_fill,
+				fast_composite_solid_fill_boxes),
+    PIXMAN_STD_FAST_PATH_BOXES (SRC, solid, null, r5g6b5, fast_composite_solid_fill,
+				fast_composite_solid_fill_boxes),
     PIXMAN_STD_FAST_PATH (SRC, x8r8g8b8, null, a8r8g8b8, fast_composite_src_x888_8888),
     PIXMAN_STD_FAST_PATH (SRC, x8b8g8r8, null, a8b8g8r8, fast_composite_src_x888_8888),
     PIXMAN_STD_FAST_PATH (SRC, a8r8g8b8, null, x8r8g8b8, fast_composite_src_memcpy),
@@ -1899,6 +2094,8 @@ static const pixman_fast_path_t c_fast_paths[] =
     SIMPLE_NEAREST_FAST_PATH_PAD (SRC, x8b8g8r8, a8b8g8r8, x888_8888),
     SIMPLE_NEAREST_FAST_PATH_NORMAL (SRC, x8r8g8b8, a8r8g8b8, x888_8888),
     SIMPLE_NEAREST_FAST_PATH_NORMAL (SRC, x8b8g8r8, a8b8g8r8, x888_8888),
+    SIMPLE_NEAREST_FAST_PATH_REFLECT (SRC, x8r8g8b8, a8r8g8b8, x888_8888),
+    SIMPLE_NEAREST_FAST_PATH_REFLECT (SRC, x8b8g8r8, a8b8g8r8, x888_8888),
 
     SIMPLE_NEAREST_FAST_PATH (OVER, a8r8g8b8, x8r8g8b8, 8888_8888),
     SIMPLE_NEAREST_FAST_PATH (OVER, a8b8g8r8, x8b8g8r8, 8888_8888),
@@ -1971,6 +2168,15 @@ static const pixman_fast_path_t c_fast_paths[] =
 	fast_composite_tiled_repeat
     },
 
+    /* Gradients with the same color along each row */
+    {	PIXMAN_OP_any,
+	PIXMAN_any,
+	(FAST_PATH_STANDARD_FLAGS | FAST_PATH_ROW_CONSTANT),
+	PIXMAN_any, 0,
+	PIXMAN_any, FAST_PATH_STD_DEST_FLAGS,
+	fast_composite_row_constant
+    },
+
     {   PIXMAN_OP_NONE	},
 };
 
@@ -295,6 +295,169 @@ create_1d_filter (int             *width,
     return params;
 }
 
+/* Cairo creates the parameters for every scaled paint, and integrating
+ * the kernels costs more than many small composites. The 1D filters are
+ * therefore kept in a process-wide cache of the FILTER_CACHE_SIZE most
+ * recently used ones, up to FILTER_CACHE_MAX_BYTES of coefficients in
+ * total. Horizontal and vertical filters share entries.
+ */
+#define FILTER_CACHE_SIZE	16
+#define FILTER_CACHE_MAX_BYTES	(1024 * 1024)
+
+#ifndef PIXMAN_NO_ATOMICS
+
+typedef struct
+{
+    pixman_link_t	mru_link;
+    pixman_kernel_t	reconstruct;
+    pixman_kernel_t	sample;
+    pixman_fixed_t	scale;
+    int			n_phases;
+    int			width;
+    pixman_fixed_t	params[1];
+} filter_cache_entry_t;
+
+static pixman_list_t filter_cache = { (pixman_link_t *)&filter_cache,
+				      (pixman_link_t *)&filter_cache };
+static int n_cached_filters;
+static size_t n_cached_bytes;
+static pixman_spin_lock_t filter_cache_lock;
+
+#define FILTER_BYTES(width, n_phases)					\
+    ((size_t)(width) * (n_phases) * sizeof (pixman_fixed_t))
+
+/* Must be called with the cache locked */
+static filter_cache_entry_t *
+lookup_filter (pixman_kernel_t reconstruct,
+	       pixman_kernel_t sample,
+	       pixman_fixed_t  scale,
+	       int             n_phases)
+{
+    pixman_link_t *link;
+
+    for (link = filter_cache.head;
+	 link != (pixman_link_t *)&filter_cache;
+	 link = link->next)
+    {
+	filter_cache_entry_t *entry =
+	    CONTAINER_OF (filter_cache_entry_t, mru_link, link);
+
+	if (entry->reconstruct == reconstruct	&&
+	    entry->sample == sample		&&
+	    entry->scale == scale		&&
+	    entry->n_phases == n_phases)
+	{
+	    pixman_list_move_to_front (&filter_cache, link);
+	    return entry;
+	}
+    }
+
+    return NULL;
+}
+
+#endif
+
+/* Like create_1d_filter(), but the result may come from the cache */
+static pixman_fixed_t *
+get_1d_filter (int             *width,
+	       pixman_kernel_t  reconstruct,
+	       pixman_kernel_t  sample,
+	       pixman_fixed_t   scale,
+	       int              n_phases)
+{
+    pixman_fixed_t *params;
+#ifndef PIXMAN_NO_ATOMICS
+    filter_cache_entry_t *entry, *evicted = NULL;
+    size_t n_bytes;
+
+    if (scale < 0)
+	scale = -scale;
+
+    params = NULL;
+
+    PIXMAN_SPIN_LOCK (&filter_cache_lock);
+    entry = lookup_filter (reconstruct, sample, scale, n_phases);
+    if (entry)
+    {
+	*width = entry->width;
+
+	params = malloc (FILTER_BYTES (entry->width, n_phases));
+	if (params)
+	    memcpy (params, entry->params, FILTER_BYTES (entry->width, n_phases));
+    }
+    PIXMAN_SPIN_UNLOCK (&filter_cache_lock);
+
+    if (entry)
+	return params;
+#endif
+
+    params = create_1d_filter (width, reconstruct, sample,
+			       fabs (pixman_fixed_to_double (scale)), n_phases);
+
+#ifndef PIXMAN_NO_ATOMICS
+    n_bytes = FILTER_BYTES (*width, n_phases);
+
+    if (!params || n_bytes > FILTER_CACHE_MAX_BYTES)
+	return params;
+
+    entry = malloc (offsetof (filter_cache_entry_t, params) + n_bytes);
+    if (!entry)
+	return params;
+
+    entry->reconstruct = reconstruct;
+    entry->sample = sample;
+    entry->scale = scale;
+    entry->n_phases = n_phases;
+    entry->width = *width;
+    memcpy (entry->params, params, n_bytes);
+
+    /* The filter was created without holding the lock, so another
+     * thread may have added the same one in the meantime.
+     */
+    PIXMAN_SPIN_LOCK (&filter_cache_lock);
+
+    if (lookup_filter (reconstruct, sample, scale, n_phases))
+    {
+	entry->mru_link.next = NULL;
+	evicted = entry;
+    }
+    else
+    {
+	pixman_list_prepend (&filter_cache, &entry->mru_link);
+	n_cached_filters++;
+	n_cached_bytes += n_bytes;
+
+	while (n_cached_filters > FILTER_CACHE_SIZE ||
+	       n_cached_bytes > FILTER_CACHE_MAX_BYTES)
+	{
+	    filter_cache_entry_t *tail = CONTAINER_OF (
+		filter_cache_entry_t, mru_link, filter_cache.tail);
+
+	    pixman_list_unlink (&tail->mru_link);
+	    n_cached_filters--;
+	    n_cached_bytes -= FILTER_BYTES (tail->width, tail->n_phases);
+
+	    /* Freed outside of the lock */
+	    tail->mru_link.next = (pixman_link_t *)evicted;
+	    evicted = tail;
+	}
+    }
+
+    PIXMAN_SPIN_UNLOCK (&filter_cache_lock);
+
+    while (evicted)
+    {
+	filter_cache_entry_t *next =
+	    (filter_cache_entry_t *)evicted->mru_link.next;
+
+	free (evicted);
+	evicted = next;
+    }
+#endif
+
+    return params;
+}
+
 /* Create the parameter list for a SEPARABLE_CONVOLUTION filter
  * with the given kernels and scale parameters
  */
@@ -309,8 +472,6 @@ pixman_filter_create_separable_convolution (int             *n_values,
 					    int              subsample_bits_x,
 					    int	             subsample_bits_y)
 {
-    double sx = fabs (pixman_fixed_to_double (scale_x));
-    double sy = fabs (pixman_fixed_to_double (scale_y));
     pixman_fixed_t *horz = NULL, *vert = NULL, *params = NULL;
     int subsample_x, subsample_y;
     int width, height;
@@ -318,8 +479,8 @@ pixman_filter_create_separable_convolution (int             *n_values,
     subsample_x = (1 << subsample_bits_x);
     subsample_y = (1 << subsample_bits_y);
 
-    horz = create_1d_filter (&width, reconstruct_x, sample_x, sx, subsample_x);
-    vert = create_1d_filter (&height, reconstruct_y, sample_y, sy, subsample_y);
+    horz = get_1d_filter (&width, reconstruct_x, sample_x, scale_x, subsample_x);
+    vert = get_1d_filter (&height, reconstruct_y, sample_y, scale_y, subsample_y);
 
     if (!horz || !vert)
         goto out;
@@ -33,6 +33,8 @@
 
 typedef struct glyph_metrics_t glyph_metrics_t;
 typedef struct glyph_t glyph_t;
+typedef struct run_t run_t;
+typedef struct run_glyph_t run_glyph_t;
 
 #define TOMBSTONE ((glyph_t *)0x1)
 
@@ -43,6 +45,19 @@ typedef struct glyph_t glyph_t;
 #define HASH_SIZE (2 * N_GLYPHS_HIGH_WATER)
 #define HASH_MASK (HASH_SIZE - 1)
 
+/* When a byte budget is set, the number of glyphs is only limited by
+ * the load factor of the hash table.
+ */
+#define N_GLYPHS_MAX	     (HASH_SIZE - HASH_SIZE / 4)
+
+/* Runs are kept in a smaller table of the same kind. When it is full,
+ * the least recently used runs are dropped.
+ */
+#define RUN_TOMBSTONE ((run_t *)0x1)
+#define RUN_HASH_SIZE (4096)
+#define RUN_HASH_MASK (RUN_HASH_SIZE - 1)
+#define N_RUNS_MAX    (RUN_HASH_SIZE - RUN_HASH_SIZE / 4)
+
 struct glyph_t
 {
     void *		font_key;
@@ -50,6 +65,37 @@ struct glyph_t
     int			origin_x;
     int			origin_y;
     pixman_image_t *	image;
+    uint64_t		n_bytes;
+    pixman_list_t	runs;
+    pixman_link_t	mru_link;
+};
+
+/* A glyph of a run. It is linked into the runs list of the glyph, so
+ * that removing the glyph finds the runs using it without a search.
+ */
+struct run_glyph_t
+{
+    glyph_t *		glyph;
+    int			x, y;
+    run_t *		run;
+    pixman_link_t	link;
+};
+
+/* A run is a mask composed by pixman_composite_glyphs() for a given
+ * sequence of glyphs. The glyph positions are stored relative to the
+ * origin of the mask, so a run can be reused when the whole string is
+ * moved.
+ */
+struct run_t
+{
+    uint32_t		hash;
+    pixman_format_code_t format;
+    int32_t		width;
+    int32_t		height;
+    int			n_glyphs;
+    run_glyph_t *	glyphs;
+    pixman_image_t *	mask;
+    uint64_t		n_bytes;
     pixman_link_t	mru_link;
 };
 
@@ -58,13 +104,95 @@ struct pixman_glyph_cache_t
     int			n_glyphs;
     int			n_tombstones;
     int			freeze_count;
+    uint64_t		n_bytes;
+    uint64_t		high_water_bytes;
+    uint64_t		low_water_bytes;
+    uint64_t		n_hits;
+    uint64_t		n_misses;
+    uint64_t		n_evictions;
     pixman_list_t	mru;
     glyph_t *		glyphs[HASH_SIZE];
+
+    uint64_t		run_n_bytes;
+    uint64_t		run_max_bytes;
+    uint64_t		n_run_hits;
+    uint64_t		n_run_misses;
+    pixman_list_t	run_mru;
+    int			n_runs;
+    int			n_run_tombstones;
+    run_t *		runs[RUN_HASH_SIZE];
 };
 
 static void
-free_glyph (glyph_t *glyph)
+remove_run (pixman_glyph_cache_t *cache,
+	    run_t                *run)
+{
+    unsigned idx;
+
+    idx = run->hash;
+    while (cache->runs[idx & RUN_HASH_MASK] != run)
+	idx++;
+
+    cache->runs[idx & RUN_HASH_MASK] = RUN_TOMBSTONE;
+    cache->n_run_tombstones++;
+    cache->n_runs--;
+
+    /* Eliminate tombstones if possible */
+    if (cache->runs[(idx + 1) & RUN_HASH_MASK] == NULL)
+    {
+	while (cache->runs[idx & RUN_HASH_MASK] == RUN_TOMBSTONE)
+	{
+	    cache->runs[idx & RUN_HASH_MASK] = NULL;
+	    cache->n_run_tombstones--;
+	    idx--;
+	}
+    }
+}
+
+static void
+free_run (pixman_glyph_cache_t *cache,
+	  run_t                *run)
+{
+    int i;
+
+    for (i = 0; i < run->n_glyphs; ++i)
+	pixman_list_unlink (&run->glyphs[i].link);
+
+    remove_run (cache, run);
+    cache->run_n_bytes -= run->n_bytes;
+
+    pixman_list_unlink (&run->mru_link);
+    pixman_image_unref (run->mask);
+    free (run->glyphs);
+    free (run);
+}
+
+static void
+clear_runs (pixman_glyph_cache_t *cache)
+{
+    while (cache->run_mru.head != (pixman_link_t *)&cache->run_mru)
+	free_run (cache, CONTAINER_OF (run_t, mru_link, cache->run_mru.head));
+}
+
+static void
+invalidate_runs (pixman_glyph_cache_t *cache,
+		 glyph_t              *glyph)
 {
+    while (glyph->runs.head != (pixman_link_t *)&glyph->runs)
+    {
+	run_glyph_t *run_glyph =
+	    CONTAINER_OF (run_glyph_t, link, glyph->runs.head);
+
+	free_run (cache, run_glyph->run);
+    }
+}
+
+static void
+free_glyph (pixman_glyph_cache_t *cache,
+	    glyph_t              *glyph)
+{
+    invalidate_runs (cache, glyph);
+
     pixman_list_unlink (&glyph->mru_link);
     pixman_image_unref (glyph->image);
     free (glyph);
@@ -133,6 +261,7 @@ insert_glyph (pixman_glyph_cache_t *cache,
     if (*loc == TOMBSTONE)
 	cache->n_tombstones--;
     cache->n_glyphs++;
+    cache->n_bytes += glyph->n_bytes;
 
     *loc = glyph;
 }
@@ -150,6 +279,7 @@ remove_glyph (pixman_glyph_cache_t *cache,
     cache->glyphs[idx & HASH_MASK] = TOMBSTONE;
     cache->n_tombstones++;
     cache->n_glyphs--;
+    cache->n_bytes -= glyph->n_bytes;
 
     /* Eliminate tombstones if possible */
     if (cache->glyphs[(idx + 1) & HASH_MASK] == NULL)
@@ -168,18 +298,21 @@ clear_table (pixman_glyph_cache_t *cache)
 {
     int i;
 
+    clear_runs (cache);
+
     for (i = 0; i < HASH_SIZE; ++i)
     {
 	glyph_t *glyph = cache->glyphs[i];
 
 	if (glyph && glyph != TOMBSTONE)
-	    free_glyph (glyph);
+	    free_glyph (cache, glyph);
 
 	cache->glyphs[i] = NULL;
     }
 
     cache->n_glyphs = 0;
     cache->n_tombstones = 0;
+    cache->n_bytes = 0;
 }
 
 PIXMAN_EXPORT pixman_glyph_cache_t *
@@ -194,8 +327,22 @@ pixman_glyph_cache_create (void)
     cache->n_glyphs = 0;
     cache->n_tombstones = 0;
     cache->freeze_count = 0;
+    cache->n_bytes = 0;
+    cache->high_water_bytes = 0;
+    cache->low_water_bytes = 0;
+    cache->n_hits = 0;
+    cache->n_misses = 0;
+    cache->n_evictions = 0;
+    cache->run_n_bytes = 0;
+    cache->run_max_bytes = 0;
+    cache->n_run_hits = 0;
+    cache->n_run_misses = 0;
+    memset (cache->runs, 0, sizeof (cache->runs));
+    cache->n_runs = 0;
+    cache->n_run_tombstones = 0;
 
     pixman_list_init (&cache->mru);
+    pixman_list_init (&cache->run_mru);
 
     return cache;
 }
@@ -216,27 +363,121 @@ pixman_glyph_cache_freeze (pixman_glyph_cache_t  *cache)
     cache->freeze_count++;
 }
 
+static void
+rehash_table (pixman_glyph_cache_t *cache)
+{
+    pixman_link_t *link;
+
+    memset (cache->glyphs, 0, sizeof (cache->glyphs));
+    cache->n_glyphs = 0;
+    cache->n_tombstones = 0;
+    cache->n_bytes = 0;
+
+    for (link = cache->mru.head;
+	 link != (pixman_link_t *)&cache->mru;
+	 link = link->next)
+    {
+	insert_glyph (cache, CONTAINER_OF (glyph_t, mru_link, link));
+    }
+}
+
+static pixman_bool_t
+cache_over_high_water (pixman_glyph_cache_t *cache)
+{
+    int n_entries = cache->n_glyphs + cache->n_tombstones;
+
+    if (cache->high_water_bytes)
+    {
+	return cache->n_bytes > cache->high_water_bytes ||
+	    n_entries > N_GLYPHS_MAX;
+    }
+
+    return n_entries > N_GLYPHS_HIGH_WATER;
+}
+
+static pixman_bool_t
+cache_over_low_water (pixman_glyph_cache_t *cache)
+{
+    if (cache->high_water_bytes)
+    {
+	return cache->n_bytes > cache->low_water_bytes ||
+	    cache->n_glyphs > N_GLYPHS_HIGH_WATER;
+    }
+
+    return cache->n_glyphs > N_GLYPHS_LOW_WATER;
+}
+
 PIXMAN_EXPORT void
 pixman_glyph_cache_thaw (pixman_glyph_cache_t  *cache)
 {
-    if (--cache->freeze_count == 0					&&
-	cache->n_glyphs + cache->n_tombstones > N_GLYPHS_HIGH_WATER)
+    if (--cache->freeze_count == 0 && cache_over_high_water (cache))
     {
-	if (cache->n_tombstones > N_GLYPHS_HIGH_WATER)
-	{
-	    /* More than half the entries are
-	     * tombstones. Just dump the whole table.
-	     */
-	    clear_table (cache);
-	}
-
-	while (cache->n_glyphs > N_GLYPHS_LOW_WATER)
+	while (cache->n_glyphs && cache_over_low_water (cache))
 	{
 	    glyph_t *glyph = CONTAINER_OF (glyph_t, mru_link, cache->mru.tail);
 
 	    remove_glyph (cache, glyph);
-	    free_glyph (glyph);
+	    free_glyph (cache, glyph);
+
+	    cache->n_evictions++;
 	}
+
+	/* Get rid of the tombstones left behind by the eviction
+	 * so that they don't count against the next high water check.
+	 */
+	if (cache->n_tombstones)
+	    rehash_table (cache);
+    }
+}
+
+/* Setting a non-zero high water mark makes eviction in
+ * pixman_glyph_cache_thaw() driven by the total number of bytes used by
+ * glyph images rather than by the number of glyphs. When the cache grows
+ * beyond high_water bytes, the least recently used glyphs are dropped
+ * until no more than low_water bytes remain. A high water mark of 0
+ * restores the default count based limits.
+ */
+PIXMAN_EXPORT void
+pixman_glyph_cache_set_limits (pixman_glyph_cache_t  *cache,
+			       uint64_t               high_water_bytes,
+			       uint64_t               low_water_bytes)
+{
+    if (low_water_bytes > high_water_bytes)
+	low_water_bytes = high_water_bytes;
+
+    cache->high_water_bytes = high_water_bytes;
+    cache->low_water_bytes = low_water_bytes;
+}
+
+PIXMAN_EXPORT void
+pixman_glyph_cache_get_stats (pixman_glyph_cache_t       *cache,
+			      pixman_glyph_cache_stats_t *stats)
+{
+    stats->n_glyphs = cache->n_glyphs;
+    stats->n_bytes = cache->n_bytes;
+    stats->n_hits = cache->n_hits;
+    stats->n_misses = cache->n_misses;
+    stats->n_evictions = cache->n_evictions;
+    stats->run_n_bytes = cache->run_n_bytes;
+    stats->n_run_hits = cache->n_run_hits;
+    stats->n_run_misses = cache->n_run_misses;
+}
+
+/* When enabled, pixman_composite_glyphs() keeps the masks it composes,
+ * so that compositing the same string of glyphs again only costs a
+ * single composite. At most max_bytes are used for the retained masks;
+ * 0, the default, disables the run cache. A run is dropped when any of
+ * its glyphs is removed from the cache.
+ */
+PIXMAN_EXPORT void
+pixman_glyph_cache_set_run_cache_limit (pixman_glyph_cache_t *cache,
+					uint64_t              max_bytes)
+{
+    cache->run_max_bytes = max_bytes;
+
+    while (cache->run_n_bytes > cache->run_max_bytes)
+    {
+	free_run (cache, CONTAINER_OF (run_t, mru_link, cache->run_mru.tail));
     }
 }
 
@@ -245,7 +486,14 @@ pixman_glyph_cache_lookup (pixman_glyph_cache_t  *cache,
 			   void                  *font_key,
 			   void                  *glyph_key)
 {
-    return lookup_glyph (cache, font_key, glyph_key);
+    glyph_t *glyph = lookup_glyph (cache, font_key, glyph_key);
+
+    if (glyph)
+	cache->n_hits++;
+    else
+	cache->n_misses++;
+
+    return glyph;
 }
 
 PIXMAN_EXPORT const void *
@@ -265,8 +513,18 @@ pixman_glyph_cache_insert (pixman_glyph_cache_t  *cache,
     width = image->bits.width;
     height = image->bits.height;
 
-    if (cache->n_glyphs >= HASH_SIZE)
-	return NULL;
+    /* Lookups and insertions probe until they find an empty slot, so the
+     * table must always keep one. Removals while the cache is frozen
+     * leave tombstones that take up slots as well.
+     */
+    if (cache->n_glyphs + cache->n_tombstones >= HASH_SIZE - 1)
+    {
+	if (cache->n_tombstones)
+	    rehash_table (cache);
+
+	if (cache->n_glyphs >= HASH_SIZE - 1)
+	    return NULL;
+    }
 
     if (!(glyph = malloc (sizeof *glyph)))
 	return NULL;
@@ -275,6 +533,7 @@ pixman_glyph_cache_insert (pixman_glyph_cache_t  *cache,
     glyph->glyph_key = glyph_key;
     glyph->origin_x = origin_x;
     glyph->origin_y = origin_y;
+    pixman_list_init (&glyph->runs);
 
     if (!(glyph->image = pixman_image_create_bits (
 	      image->bits.format, width, height, NULL, -1)))
@@ -287,6 +546,9 @@ pixman_glyph_cache_insert (pixman_glyph_cache_t  *cache,
 			      image, NULL, glyph->image, 0, 0, 0, 0, 0, 0,
 			      width, height);
 
+    glyph->n_bytes = sizeof (glyph_t) + sizeof (pixman_image_t) +
+	(uint64_t)glyph->image->bits.rowstride * 4 * height;
+
     if (PIXMAN_FORMAT_A   (glyph->image->bits.format) != 0	&&
 	PIXMAN_FORMAT_RGB (glyph->image->bits.format) != 0)
     {
@@ -312,7 +574,7 @@ pixman_glyph_cache_remove (pixman_glyph_cache_t  *cache,
     {
 	remove_glyph (cache, glyph);
 
-	free_glyph (glyph);
+	free_glyph (cache, glyph);
     }
 }
 
@@ -391,6 +653,43 @@ box32_intersect (pixman_box32_t *dest,
     return dest->x2 > dest->x1 && dest->y2 > dest->y1;
 }
 
+/* The glyph compositing functions keep the composite functions they
+ * have looked up for the glyph formats they have seen, so that runs
+ * mixing a small number of glyph formats (typically a1 and a8) don't
+ * need a fast path lookup each time the format changes.
+ */
+#define N_GLYPH_PATHS 4
+
+typedef struct
+{
+    pixman_format_code_t	format;
+    uint32_t			flags;
+    pixman_bool_t		white_src;
+    uint32_t			src_flags;
+    uint32_t			mask_flags;
+    pixman_implementation_t *	implementation;
+    pixman_composite_func_t	func;
+} glyph_path_t;
+
+/* Return the first box in [begin, end) whose y2 is greater than y, or
+ * end if there is no such box.
+ */
+static const pixman_box32_t *
+find_box_for_y (const pixman_box32_t *begin, const pixman_box32_t *end, int y)
+{
+    while (begin < end)
+    {
+	const pixman_box32_t *mid = begin + (end - begin) / 2;
+
+	if (mid->y2 > y)
+	    end = mid;
+	else
+	    begin = mid + 1;
+    }
+
+    return begin;
+}
+
 PIXMAN_EXPORT void
 pixman_composite_glyphs_no_mask (pixman_op_t            op,
 				 pixman_image_t        *src,
@@ -403,18 +702,19 @@ pixman_composite_glyphs_no_mask (pixman_op_t            op,
 				 int                    n_glyphs,
 				 const pixman_glyph_t  *glyphs)
 {
+    glyph_path_t paths[N_GLYPH_PATHS];
+    glyph_path_t *path = NULL;
+    int n_paths = 0;
     pixman_region32_t region;
-    pixman_format_code_t glyph_format = PIXMAN_null;
-    uint32_t glyph_flags = 0;
     pixman_format_code_t dest_format;
     uint32_t dest_flags;
-    pixman_composite_func_t func = NULL;
-    pixman_implementation_t *implementation = NULL;
+    const pixman_box32_t *extents, *boxes, *boxes_end;
     pixman_composite_info_t info;
-    int i;
+    int i, j, n_boxes;
 
     _pixman_image_validate (src);
     _pixman_image_validate (dest);
+    _pixman_bits_image_discard_mipmap (dest);
     
     dest_format = dest->common.extended_format_code;
     dest_flags = dest->common.flags;
@@ -429,6 +729,10 @@ pixman_composite_glyphs_no_mask (pixman_op_t            op,
 	goto out;
     }
 
+    extents = pixman_region32_extents (&region);
+    boxes = pixman_region32_rectangles (&region, &n_boxes);
+    boxes_end = boxes + n_boxes;
+
     info.op = op;
     info.src_image = src;
     info.dest_image = dest;
@@ -440,55 +744,88 @@ pixman_composite_glyphs_no_mask (pixman_op_t            op,
 	glyph_t *glyph = (glyph_t *)glyphs[i].glyph;
 	pixman_image_t *glyph_img = glyph->image;
 	pixman_box32_t glyph_box;
-	pixman_box32_t *pbox;
-	uint32_t extra = FAST_PATH_SAMPLES_COVER_CLIP_NEAREST;
 	pixman_box32_t composite_box;
-	int n;
+	const pixman_box32_t *pbox;
+
+	pixman_list_move_to_front (&cache->mru, &glyph->mru_link);
 
 	glyph_box.x1 = dest_x + glyphs[i].x - glyph->origin_x;
 	glyph_box.y1 = dest_y + glyphs[i].y - glyph->origin_y;
-	glyph_box.x2 = glyph_box.x1 + glyph->image->bits.width;
-	glyph_box.y2 = glyph_box.y1 + glyph->image->bits.height;
-	
-	pbox = pixman_region32_rectangles (&region, &n);
-	
-	info.mask_image = glyph_img;
-
-	while (n--)
+	glyph_box.x2 = glyph_box.x1 + glyph_img->bits.width;
+	glyph_box.y2 = glyph_box.y1 + glyph_img->bits.height;
+
+	/* Reject glyphs outside the composite region as a whole
+	 * before looking at the individual boxes.
+	 */
+	if (!box32_intersect (&composite_box, &glyph_box, extents))
+	    continue;
+
+	if (!path							||
+	    glyph_img->common.extended_format_code != path->format	||
+	    glyph_img->common.flags != path->flags)
 	{
-	    if (box32_intersect (&composite_box, pbox, &glyph_box))
+	    pixman_format_code_t glyph_format;
+	    uint32_t glyph_flags;
+
+	    glyph_format = glyph_img->common.extended_format_code;
+	    glyph_flags = glyph_img->common.flags;
+
+	    for (j = 0; j < n_paths; ++j)
 	    {
-		if (glyph_img->common.extended_format_code != glyph_format	||
-		    glyph_img->common.flags != glyph_flags)
+		if (paths[j].format == glyph_format &&
+		    paths[j].flags == glyph_flags)
 		{
-		    glyph_format = glyph_img->common.extended_format_code;
-		    glyph_flags = glyph_img->common.flags;
-
-		    _pixman_implementation_lookup_composite (
-			get_implementation(), op,
-			src->common.extended_format_code, src->common.flags,
-			glyph_format, glyph_flags | extra,
-			dest_format, dest_flags,
-			&implementation, &func);
+		    break;
 		}
+	    }
 
-		info.src_x = src_x + composite_box.x1 - dest_x;
-		info.src_y = src_y + composite_box.y1 - dest_y;
-		info.mask_x = composite_box.x1 - (dest_x + glyphs[i].x - glyph->origin_x);
-		info.mask_y = composite_box.y1 - (dest_y + glyphs[i].y - glyph->origin_y);
-		info.dest_x = composite_box.x1;
-		info.dest_y = composite_box.y1;
-		info.width = composite_box.x2 - composite_box.x1;
-		info.height = composite_box.y2 - composite_box.y1;
+	    if (j == N_GLYPH_PATHS)
+		j = n_paths = 0;
 
-		info.mask_flags = glyph_flags;
+	    path = &paths[j];
 
-		func (implementation, &info);
+	    if (j == n_paths)
+	    {
+		path->format = glyph_format;
+		path->flags = glyph_flags;
+		path->white_src = FALSE;
+		path->src_flags = info.src_flags;
+		path->mask_flags =
+		    glyph_flags | FAST_PATH_SAMPLES_COVER_CLIP_NEAREST;
+
+		_pixman_implementation_lookup_composite (
+		    get_implementation(), op,
+		    src->common.extended_format_code, path->src_flags,
+		    glyph_format, path->mask_flags,
+		    dest_format, dest_flags,
+		    &path->implementation, &path->func, NULL);
+
+		n_paths++;
 	    }
 
-	    pbox++;
+	    info.mask_flags = glyph_flags;
+	}
+
+	info.mask_image = glyph_img;
+
+	for (pbox = find_box_for_y (boxes, boxes_end, glyph_box.y1);
+	     pbox != boxes_end && pbox->y1 < glyph_box.y2;
+	     pbox++)
+	{
+	    if (!box32_intersect (&composite_box, pbox, &glyph_box))
+		continue;
+
+	    info.src_x = src_x + composite_box.x1 - dest_x;
+	    info.src_y = src_y + composite_box.y1 - dest_y;
+	    info.mask_x = composite_box.x1 - glyph_box.x1;
+	    info.mask_y = composite_box.y1 - glyph_box.y1;
+	    info.dest_x = composite_box.x1;
+	    info.dest_y = composite_box.y1;
+	    info.width = composite_box.x2 - composite_box.x1;
+	    info.height = composite_box.y2 - composite_box.y1;
+
+	    path->func (path->implementation, &info);
 	}
-	pixman_list_move_to_front (&cache->mru, &glyph->mru_link);
     }
 
 out:
@@ -501,17 +838,15 @@ add_glyphs (pixman_glyph_cache_t *cache,
 	    int off_x, int off_y,
 	    int n_glyphs, const pixman_glyph_t *glyphs)
 {
-    pixman_format_code_t glyph_format = PIXMAN_null;
-    uint32_t glyph_flags = 0;
-    pixman_composite_func_t func = NULL;
-    pixman_implementation_t *implementation = NULL;
+    glyph_path_t paths[N_GLYPH_PATHS];
+    glyph_path_t *path = NULL;
+    int n_paths = 0;
     pixman_format_code_t dest_format;
     uint32_t dest_flags;
     pixman_box32_t dest_box;
     pixman_composite_info_t info;
     pixman_image_t *white_img = NULL;
-    pixman_bool_t white_src = FALSE;
-    int i;
+    int i, j;
 
     _pixman_image_validate (dest);
 
@@ -536,77 +871,105 @@ add_glyphs (pixman_glyph_cache_t *cache,
 	pixman_box32_t glyph_box;
 	pixman_box32_t composite_box;
 
-	if (glyph_img->common.extended_format_code != glyph_format	||
-	    glyph_img->common.flags != glyph_flags)
+	glyph_box.x1 = glyphs[i].x - glyph->origin_x + off_x;
+	glyph_box.y1 = glyphs[i].y - glyph->origin_y + off_y;
+	glyph_box.x2 = glyph_box.x1 + glyph_img->bits.width;
+	glyph_box.y2 = glyph_box.y1 + glyph_img->bits.height;
+
+	if (!box32_intersect (&composite_box, &glyph_box, &dest_box))
+	    continue;
+
+	if (!path							||
+	    glyph_img->common.extended_format_code != path->format	||
+	    glyph_img->common.flags != path->flags)
 	{
-	    pixman_format_code_t src_format, mask_format;
+	    pixman_format_code_t glyph_format, src_format, mask_format;
+	    uint32_t glyph_flags;
 
 	    glyph_format = glyph_img->common.extended_format_code;
 	    glyph_flags = glyph_img->common.flags;
 
-	    if (glyph_format == dest->bits.format)
-	    {
-		src_format = glyph_format;
-		mask_format = PIXMAN_null;
-		info.src_flags = glyph_flags | FAST_PATH_SAMPLES_COVER_CLIP_NEAREST;
-		info.mask_flags = FAST_PATH_IS_OPAQUE;
-		info.mask_image = NULL;
-		white_src = FALSE;
-	    }
-	    else
+	    for (j = 0; j < n_paths; ++j)
 	    {
-		if (!white_img)
+		if (paths[j].format == glyph_format &&
+		    paths[j].flags == glyph_flags)
 		{
-		    static const pixman_color_t white = { 0xffff, 0xffff, 0xffff, 0xffff };
+		    break;
+		}
+	    }
+
+	    if (j == N_GLYPH_PATHS)
+		j = n_paths = 0;
 
-		    if (!(white_img = pixman_image_create_solid_fill (&white)))
-			goto out;
+	    path = &paths[j];
 
-		    _pixman_image_validate (white_img);
+	    if (j == n_paths)
+	    {
+		path->format = glyph_format;
+		path->flags = glyph_flags;
+
+		if (glyph_format == dest->bits.format)
+		{
+		    src_format = glyph_format;
+		    mask_format = PIXMAN_null;
+		    path->src_flags =
+			glyph_flags | FAST_PATH_SAMPLES_COVER_CLIP_NEAREST;
+		    path->mask_flags = FAST_PATH_IS_OPAQUE;
+		    path->white_src = FALSE;
+		}
+		else
+		{
+		    if (!white_img)
+		    {
+			static const pixman_color_t white = { 0xffff, 0xffff, 0xffff, 0xffff };
+
+			if (!(white_img = pixman_image_create_solid_fill (&white)))
+			    goto out;
+
+			_pixman_image_validate (white_img);
+		    }
+
+		    src_format = PIXMAN_solid;
+		    mask_format = glyph_format;
+		    path->src_flags = white_img->common.flags;
+		    path->mask_flags =
+			glyph_flags | FAST_PATH_SAMPLES_COVER_CLIP_NEAREST;
+		    path->white_src = TRUE;
 		}
 
-		src_format = PIXMAN_solid;
-		mask_format = glyph_format;
-		info.src_flags = white_img->common.flags;
-		info.mask_flags = glyph_flags | FAST_PATH_SAMPLES_COVER_CLIP_NEAREST;
-		info.src_image = white_img;
-		white_src = TRUE;
+		_pixman_implementation_lookup_composite (
+		    get_implementation(), PIXMAN_OP_ADD,
+		    src_format, path->src_flags,
+		    mask_format, path->mask_flags,
+		    dest_format, dest_flags,
+		    &path->implementation, &path->func, NULL);
+
+		n_paths++;
 	    }
 
-	    _pixman_implementation_lookup_composite (
-		get_implementation(), PIXMAN_OP_ADD,
-		src_format, info.src_flags,
-		mask_format, info.mask_flags,
-		dest_format, dest_flags,
-		&implementation, &func);
+	    info.src_flags = path->src_flags;
+	    info.mask_flags = path->mask_flags;
+	    if (path->white_src)
+		info.src_image = white_img;
+	    else
+		info.mask_image = NULL;
 	}
 
-	glyph_box.x1 = glyphs[i].x - glyph->origin_x + off_x;
-	glyph_box.y1 = glyphs[i].y - glyph->origin_y + off_y;
-	glyph_box.x2 = glyph_box.x1 + glyph->image->bits.width;
-	glyph_box.y2 = glyph_box.y1 + glyph->image->bits.height;
-	
-	if (box32_intersect (&composite_box, &glyph_box, &dest_box))
-	{
-	    int src_x = composite_box.x1 - glyph_box.x1;
-	    int src_y = composite_box.y1 - glyph_box.y1;
+	if (path->white_src)
+	    info.mask_image = glyph_img;
+	else
+	    info.src_image = glyph_img;
 
-	    if (white_src)
-		info.mask_image = glyph_img;
-	    else
-		info.src_image = glyph_img;
+	info.mask_x = info.src_x = composite_box.x1 - glyph_box.x1;
+	info.mask_y = info.src_y = composite_box.y1 - glyph_box.y1;
+	info.dest_x = composite_box.x1;
+	info.dest_y = composite_box.y1;
+	info.width = composite_box.x2 - composite_box.x1;
+	info.height = composite_box.y2 - composite_box.y1;
 
-	    info.mask_x = info.src_x = src_x;
-	    info.mask_y = info.src_y = src_y;
-	    info.dest_x = composite_box.x1;
-	    info.dest_y = composite_box.y1;
-	    info.width = composite_box.x2 - composite_box.x1;
-	    info.height = composite_box.y2 - composite_box.y1;
+	path->func (path->implementation, &info);
 
-	    func (implementation, &info);
-
-	    pixman_list_move_to_front (&cache->mru, &glyph->mru_link);
-	}
+	pixman_list_move_to_front (&cache->mru, &glyph->mru_link);
     }
 
 out:
@@ -614,6 +977,169 @@ out:
 	pixman_image_unref (white_img);
 }
 
+static uint32_t
+hash_run (pixman_format_code_t  format,
+	  int32_t               off_x,
+	  int32_t               off_y,
+	  int32_t               width,
+	  int32_t               height,
+	  int                   n_glyphs,
+	  const pixman_glyph_t *glyphs)
+{
+    uint32_t h = hash ((void *)(uintptr_t)format,
+		       (void *)(uintptr_t)((width << 16) ^ height));
+    int i;
+
+    for (i = 0; i < n_glyphs; ++i)
+    {
+	h = (h * 31) ^ hash (glyphs[i].glyph, (void *)(uintptr_t)n_glyphs);
+	h = (h * 31) ^ (uint32_t)(glyphs[i].x + off_x);
+	h = (h * 31) ^ (uint32_t)(glyphs[i].y + off_y);
+    }
+
+    return h;
+}
+
+static run_t *
+lookup_run (pixman_glyph_cache_t *cache,
+	    uint32_t              h,
+	    pixman_format_code_t  format,
+	    int32_t               off_x,
+	    int32_t               off_y,
+	    int32_t               width,
+	    int32_t               height,
+	    int                   n_glyphs,
+	    const pixman_glyph_t *glyphs)
+{
+    unsigned idx;
+    run_t *run;
+    int i;
+
+    idx = h;
+    while ((run = cache->runs[idx++ & RUN_HASH_MASK]))
+    {
+	if (run == RUN_TOMBSTONE		||
+	    run->hash != h			||
+	    run->format != format		||
+	    run->width != width			||
+	    run->height != height		||
+	    run->n_glyphs != n_glyphs)
+	{
+	    continue;
+	}
+
+	for (i = 0; i < n_glyphs; ++i)
+	{
+	    if (run->glyphs[i].glyph != glyphs[i].glyph		||
+		run->glyphs[i].x != glyphs[i].x + off_x		||
+		run->glyphs[i].y != glyphs[i].y + off_y)
+	    {
+		break;
+	    }
+	}
+
+	if (i == n_glyphs)
+	    return run;
+    }
+
+    return NULL;
+}
+
+static void
+rehash_runs (pixman_glyph_cache_t *cache)
+{
+    pixman_link_t *link;
+    unsigned idx;
+
+    memset (cache->runs, 0, sizeof (cache->runs));
+    cache->n_run_tombstones = 0;
+
+    for (link = cache->run_mru.head;
+	 link != (pixman_link_t *)&cache->run_mru;
+	 link = link->next)
+    {
+	run_t *run = CONTAINER_OF (run_t, mru_link, link);
+
+	idx = run->hash;
+	while (cache->runs[idx & RUN_HASH_MASK])
+	    idx++;
+
+	cache->runs[idx & RUN_HASH_MASK] = run;
+    }
+}
+
+static void
+insert_run (pixman_glyph_cache_t *cache,
+	    uint32_t              h,
+	    pixman_format_code_t  format,
+	    int32_t               off_x,
+	    int32_t               off_y,
+	    int32_t               width,
+	    int32_t               height,
+	    int                   n_glyphs,
+	    const pixman_glyph_t *glyphs,
+	    pixman_image_t       *mask)
+{
+    run_t *run, **loc;
+    unsigned idx;
+    int i;
+
+    if (!(run = malloc (sizeof *run)))
+	return;
+
+    if (!(run->glyphs = pixman_malloc_ab (n_glyphs, sizeof (run_glyph_t))))
+    {
+	free (run);
+	return;
+    }
+
+    while (cache->n_runs >= N_RUNS_MAX)
+	free_run (cache, CONTAINER_OF (run_t, mru_link, cache->run_mru.tail));
+
+    if (cache->n_runs + cache->n_run_tombstones >= N_RUNS_MAX)
+	rehash_runs (cache);
+
+    run->hash = h;
+    run->format = format;
+    run->width = width;
+    run->height = height;
+    run->n_glyphs = n_glyphs;
+    run->mask = pixman_image_ref (mask);
+    run->n_bytes = sizeof (run_t) + sizeof (pixman_image_t) +
+	(uint64_t)n_glyphs * sizeof (run_glyph_t) +
+	(uint64_t)mask->bits.rowstride * 4 * height;
+
+    for (i = 0; i < n_glyphs; ++i)
+    {
+	glyph_t *glyph = (glyph_t *)glyphs[i].glyph;
+
+	run->glyphs[i].glyph = glyph;
+	run->glyphs[i].x = glyphs[i].x + off_x;
+	run->glyphs[i].y = glyphs[i].y + off_y;
+	run->glyphs[i].run = run;
+
+	pixman_list_prepend (&glyph->runs, &run->glyphs[i].link);
+    }
+
+    idx = h;
+    do
+    {
+	loc = &cache->runs[idx++ & RUN_HASH_MASK];
+    } while (*loc && *loc != RUN_TOMBSTONE);
+
+    if (*loc == RUN_TOMBSTONE)
+	cache->n_run_tombstones--;
+    cache->n_runs++;
+
+    *loc = run;
+
+    pixman_list_prepend (&cache->run_mru, &run->mru_link);
+    cache->run_n_bytes += run->n_bytes;
+
+    while (cache->run_n_bytes > cache->run_max_bytes)
+	free_run (cache, CONTAINER_OF (run_t, mru_link, cache->run_mru.tail));
+}
+
 /* Conceptually, for each glyph, (white IN glyph) is PIXMAN_OP_ADDed to an
  * infinitely big mask image at the position such that the glyph origin point
  * is positioned at the (glyphs[i].x, glyphs[i].y) point.
@@ -648,6 +1174,41 @@ pixman_composite_glyphs (pixman_op_t            op,
 			 const pixman_glyph_t  *glyphs)
 {
     pixman_image_t *mask;
+    uint32_t h = 0;
+    run_t *run;
+    int i;
+
+    if (cache->run_max_bytes)
+    {
+	h = hash_run (mask_format, - mask_x, - mask_y, width, height,
+		      n_glyphs, glyphs);
+
+	run = lookup_run (cache, h, mask_format, - mask_x, - mask_y,
+			  width, height, n_glyphs, glyphs);
+
+	if (run)
+	{
+	    cache->n_run_hits++;
+
+	    for (i = 0; i < n_glyphs; ++i)
+	    {
+		glyph_t *glyph = (glyph_t *)glyphs[i].glyph;
+
+		pixman_list_move_to_front (&cache->mru, &glyph->mru_link);
+	    }
+
+	    pixman_list_move_to_front (&cache->run_mru, &run->mru_link);
+
+	    pixman_image_composite32 (op, src, run->mask, dest,
+				      src_x, src_y,
+				      0, 0,
+				      dest_x, dest_y,
+				      width, height);
+	    return;
+	}
+
+	cache->n_run_misses++;
+    }
 
     if (!(mask = pixman_image_create_bits (mask_format, width, height, NULL, -1)))
 	return;
@@ -666,5 +1227,11 @@ pixman_composite_glyphs (pixman_op_t            op,
 			      dest_x, dest_y,
 			      width, height);
 
+    if (cache->run_max_bytes)
+    {
+	insert_run (cache, h, mask_format, - mask_x, - mask_y,
+		    width, height, n_glyphs, glyphs, mask);
+    }
+
     pixman_image_unref (mask);
 }
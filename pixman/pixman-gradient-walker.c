@@ -26,6 +26,8 @@
 #ifdef HAVE_CONFIG_H
 #include <config.h>
 #endif
+#include <stdlib.h>
+#include <string.h>
 #include "pixman-private.h"
 
 void
@@ -43,6 +45,7 @@ _pixman_gradient_walker_init (pixman_gradient_walker_t *walker,
     walker->right_ag  = 0;
     walker->right_rb  = 0;
     walker->repeat    = repeat;
+    walker->ramp      = _pixman_gradient_get_ramp (gradient, repeat);
 
     walker->need_reset = TRUE;
 }
@@ -138,6 +141,40 @@ gradient_walker_reset (pixman_gradient_walker_t *walker,
     walker->need_reset = FALSE;
 }
 
+static uint32_t
+gradient_ramp_pixel (const uint32_t *ramp,
+		     pixman_repeat_t repeat,
+		     pixman_fixed_48_16_t pos)
+{
+    switch (repeat)
+    {
+    case PIXMAN_REPEAT_NONE:
+	if (pos < 0 || pos >= pixman_fixed_1)
+	    return 0;
+	break;
+
+    case PIXMAN_REPEAT_PAD:
+	if (pos < 0)
+	    pos = 0;
+	else if (pos > pixman_fixed_1)
+	    pos = pixman_fixed_1;
+	break;
+
+    case PIXMAN_REPEAT_NORMAL:
+	pos &= pixman_fixed_1_minus_e;
+	break;
+
+    case PIXMAN_REPEAT_REFLECT:
+	if (pos & pixman_fixed_1)
+	    pos = pixman_fixed_1 - (pos & pixman_fixed_1_minus_e);
+	else
+	    pos &= pixman_fixed_1_minus_e;
+	break;
+    }
+
+    return ramp[(pos * GRADIENT_RAMP_SIZE + pixman_fixed_1 / 2) >> 16];
+}
+
 uint32_t
 _pixman_gradient_walker_pixel (pixman_gradient_walker_t *walker,
                                pixman_fixed_48_16_t      x)
@@ -145,6 +182,9 @@ _pixman_gradient_walker_pixel (pixman_gradient_walker_t *walker,
     int dist, idist;
     uint32_t t1, t2, a, color;
 
+    if (walker->ramp)
+	return gradient_ramp_pixel (walker->ramp, walker->repeat, x);
+
     if (walker->need_reset || x < walker->left_x || x >= walker->right_x)
 	gradient_walker_reset (walker, x);
 
@@ -170,3 +210,232 @@ _pixman_gradient_walker_pixel (pixman_gradient_walker_t *walker,
     return (color | (t1 & 0xff00ff) | (t2 & 0xff00));
 }
 
+
+/* Returns the ramp to use for fetching @gradient with @repeat, or NULL
+ * if the colors have to be computed exactly.
+ */
+const uint32_t *
+_pixman_gradient_get_ramp (gradient_t      *gradient,
+			   pixman_repeat_t  repeat)
+{
+    /* PIXMAN_FILTER_BEST asks for the exact colors */
+    if (gradient->ramp					&&
+	gradient->ramp->repeat == repeat		&&
+	gradient->common.filter != PIXMAN_FILTER_BEST)
+    {
+	return gradient->ramp->colors;
+    }
+
+    return NULL;
+}
+
+/* Sampling the gradient in a table of premultiplied colors makes
+ * fetching a pixel a matter of indexing the table, rather than finding
+ * the stops around it and interpolating between them. The colors can be
+ * off by up to half a ramp entry in position, so an image with
+ * PIXMAN_FILTER_BEST doesn't get a ramp and uses the exact walker.
+ *
+ * The ramp only depends on the stops and the repeat mode, so it is
+ * recomputed only when the repeat mode changes. Applications tend to
+ * create a new gradient for every drawing operation, usually with the
+ * same stops, so the ramps are also kept in a process-wide cache and
+ * shared between all the gradients with the same stops and repeat mode.
+ * The cache holds a reference to the RAMP_CACHE_SIZE most recently used
+ * ramps, and each gradient holds a reference to its own.
+ */
+#define RAMP_CACHE_SIZE 64
+
+#ifndef PIXMAN_NO_ATOMICS
+static pixman_list_t ramp_cache = { (pixman_link_t *)&ramp_cache,
+				    (pixman_link_t *)&ramp_cache };
+static int n_cached_ramps;
+static pixman_spin_lock_t ramp_cache_lock;
+#endif
+
+static uint32_t
+hash_ramp_key (const pixman_gradient_stop_t *stops,
+	       int                           n_stops,
+	       pixman_repeat_t               repeat)
+{
+    const uint8_t *bytes = (const uint8_t *)stops;
+    uint32_t hash = 2166136261u ^ repeat;
+    size_t i;
+
+    /* FNV-1a */
+    for (i = 0; i < n_stops * sizeof (pixman_gradient_stop_t); ++i)
+    {
+	hash ^= bytes[i];
+	hash *= 16777619u;
+    }
+
+    return hash;
+}
+
+static void
+ramp_unref (gradient_ramp_t *ramp)
+{
+    if (ramp && PIXMAN_ATOMIC_DEC (&ramp->ref_count) == 0)
+	free (ramp);
+}
+
+#ifndef PIXMAN_NO_ATOMICS
+
+/* Must be called with the cache locked. Returns a new reference. */
+static gradient_ramp_t *
+lookup_ramp (uint32_t                      hash,
+	     const pixman_gradient_stop_t *stops,
+	     int                           n_stops,
+	     pixman_repeat_t               repeat)
+{
+    pixman_link_t *link;
+
+    for (link = ramp_cache.head;
+	 link != (pixman_link_t *)&ramp_cache;
+	 link = link->next)
+    {
+	gradient_ramp_t *ramp = CONTAINER_OF (gradient_ramp_t, mru_link, link);
+
+	if (ramp->hash == hash			&&
+	    ramp->repeat == repeat		&&
+	    ramp->n_stops == n_stops		&&
+	    memcmp (ramp->stops, stops,
+		    n_stops * sizeof (pixman_gradient_stop_t)) == 0)
+	{
+	    pixman_list_move_to_front (&ramp_cache, link);
+	    PIXMAN_ATOMIC_INC (&ramp->ref_count);
+	    return ramp;
+	}
+    }
+
+    return NULL;
+}
+
+#endif
+
+static gradient_ramp_t *
+create_ramp (gradient_t      *gradient,
+	     uint32_t         hash,
+	     pixman_repeat_t  repeat)
+{
+    pixman_gradient_walker_t walker;
+    gradient_ramp_t *ramp;
+    int i;
+
+    ramp = malloc (sizeof (gradient_ramp_t) +
+		   gradient->n_stops * sizeof (pixman_gradient_stop_t));
+    if (!ramp)
+	return NULL;
+
+    ramp->ref_count = 1;
+    ramp->hash = hash;
+    ramp->repeat = repeat;
+    ramp->n_stops = gradient->n_stops;
+    ramp->stops = (pixman_gradient_stop_t *)(ramp + 1);
+    memcpy (ramp->stops, gradient->stops,
+	    gradient->n_stops * sizeof (pixman_gradient_stop_t));
+
+    _pixman_gradient_walker_init (&walker, gradient, repeat);
+    walker.ramp = NULL;
+
+    for (i = 0; i <= GRADIENT_RAMP_SIZE; ++i)
+    {
+	pixman_fixed_48_16_t pos = i << (16 - GRADIENT_RAMP_BITS);
+
+	/* With NORMAL repeat, 1.0 is the same as 0.0, and with NONE it
+	 * is already outside the gradient, so the last entry is sampled
+	 * just before it instead.
+	 */
+	if ((repeat == PIXMAN_REPEAT_NORMAL || repeat == PIXMAN_REPEAT_NONE) &&
+	    i == GRADIENT_RAMP_SIZE)
+	    pos = pixman_fixed_1_minus_e;
+
+	ramp->colors[i] = _pixman_gradient_walker_pixel (&walker, pos);
+    }
+
+    return ramp;
+}
+
+void
+_pixman_gradient_update_ramp (gradient_t *gradient)
+{
+    pixman_repeat_t repeat = gradient->common.repeat;
+    gradient_ramp_t *ramp = NULL;
+    uint32_t hash;
+    int i;
+
+    if (gradient->common.filter == PIXMAN_FILTER_BEST)
+	return;
+
+    if (gradient->ramp && gradient->ramp->repeat == repeat)
+	return;
+
+    /* The ramp can't represent stops outside of [0, 1] */
+    for (i = 0; i < gradient->n_stops; ++i)
+    {
+	if (gradient->stops[i].x < 0 || gradient->stops[i].x > pixman_fixed_1)
+	{
+	    _pixman_gradient_release_ramp (gradient);
+	    return;
+	}
+    }
+
+    hash = hash_ramp_key (gradient->stops, gradient->n_stops, repeat);
+
+#ifndef PIXMAN_NO_ATOMICS
+    PIXMAN_SPIN_LOCK (&ramp_cache_lock);
+    ramp = lookup_ramp (hash, gradient->stops, gradient->n_stops, repeat);
+    PIXMAN_SPIN_UNLOCK (&ramp_cache_lock);
+#endif
+
+    if (!ramp)
+    {
+	/* The ramp is computed without holding the lock, so another
+	 * thread may have added the same one in the meantime.
+	 */
+	ramp = create_ramp (gradient, hash, repeat);
+
+#ifndef PIXMAN_NO_ATOMICS
+	if (ramp)
+	{
+	    gradient_ramp_t *cached, *evicted = NULL;
+
+	    PIXMAN_SPIN_LOCK (&ramp_cache_lock);
+
+	    cached = lookup_ramp (hash, gradient->stops, gradient->n_stops, repeat);
+	    if (!cached)
+	    {
+		PIXMAN_ATOMIC_INC (&ramp->ref_count);
+		pixman_list_prepend (&ramp_cache, &ramp->mru_link);
+
+		if (++n_cached_ramps > RAMP_CACHE_SIZE)
+		{
+		    evicted = CONTAINER_OF (
+			gradient_ramp_t, mru_link, ramp_cache.tail);
+		    pixman_list_unlink (&evicted->mru_link);
+		    n_cached_ramps--;
+		}
+	    }
+
+	    PIXMAN_SPIN_UNLOCK (&ramp_cache_lock);
+
+	    if (cached)
+	    {
+		free (ramp);
+		ramp = cached;
+	    }
+
+	    ramp_unref (evicted);
+	}
+#endif
+    }
+
+    _pixman_gradient_release_ramp (gradient);
+    gradient->ramp = ramp;
+}
+
+void
+_pixman_gradient_release_ramp (gradient_t *gradient)
+{
+    ramp_unref (gradient->ramp);
+    gradient->ramp = NULL;
+}
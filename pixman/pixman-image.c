@@ -73,6 +73,8 @@ gradient_property_changed (pixman_image_t *image)
 	end->color = stops[n - 1].color;
 	break;
     }
+
+    _pixman_gradient_update_ramp (gradient);
 }
 
 pixman_bool_t
@@ -100,6 +102,7 @@ _pixman_init_gradient (gradient_t *                  gradient,
     gradient->stops += 1;
     memcpy (gradient->stops, stops, n_stops * sizeof (pixman_gradient_stop_t));
     gradient->n_stops = n_stops;
+    gradient->ramp = NULL;
 
     gradient->common.property_changed = gradient_property_changed;
 
@@ -161,6 +164,8 @@ _pixman_image_fini (pixman_image_t *image)
 		free (image->gradient.stops - 1);
 	    }
 
+	    _pixman_gradient_release_ramp (&image->gradient);
+
 	    /* This will trigger if someone adds a property_changed
 	     * method to the linear/radial/conical gradient overwriting
 	     * the general one.
@@ -169,6 +174,8 @@ _pixman_image_fini (pixman_image_t *image)
 		image->common.property_changed == gradient_property_changed);
 	}
 
+	_pixman_bits_image_discard_mipmap (image);
+
 	if (image->type == BITS && image->bits.free_me)
 	    free (image->bits.free_me);
 
@@ -306,6 +313,14 @@ compute_image_info (pixman_image_t *image)
 		else if (m01 == pixman_fixed_1 && m10 == -pixman_fixed_1)
 		    flags |= FAST_PATH_ROTATE_270_TRANSFORM;
 	    }
+	    else if (image->common.transform->matrix[0][0] ==
+		     image->common.transform->matrix[1][1]		&&
+		     image->common.transform->matrix[0][1] ==
+		     -image->common.transform->matrix[1][0])
+	    {
+		/* Rotation by any other angle, possibly with a uniform scale */
+		flags |= FAST_PATH_ROTATE_TRANSFORM;
+	    }
 	}
 
 	if (image->common.transform->matrix[0][0] > 0)
@@ -460,6 +475,13 @@ compute_image_info (pixman_image_t *image)
 
 	if (PIXMAN_FORMAT_IS_WIDE (image->bits.format))
 	    flags &= ~FAST_PATH_NARROW_FORMAT;
+
+	/* Every row starts on a 16 byte boundary */
+	if (((uintptr_t)image->bits.bits & 15) == 0	&&
+	    (image->bits.rowstride & 3) == 0)
+	{
+	    flags |= FAST_PATH_ALIGNED_ROWS;
+	}
 	break;
 
     case RADIAL:
@@ -495,6 +517,27 @@ compute_image_info (pixman_image_t *image)
 		}
 	    }
 	}
+
+	/* A linear gradient whose direction is perpendicular to the
+	 * x axis of the source space has the same color along each row.
+	 */
+	if (image->type == LINEAR && (flags & FAST_PATH_AFFINE_TRANSFORM))
+	{
+	    pixman_fixed_48_16_t dx, dy;
+	    pixman_fixed_48_16_t ux = pixman_fixed_1, uy = 0;
+
+	    dx = image->linear.p2.x - image->linear.p1.x;
+	    dy = image->linear.p2.y - image->linear.p1.y;
+
+	    if (image->common.transform)
+	    {
+		ux = image->common.transform->matrix[0][0];
+		uy = image->common.transform->matrix[1][0];
+	    }
+
+	    if (dx * ux + dy * uy == 0)
+		flags |= FAST_PATH_ROW_CONSTANT;
+	}
 	break;
 
     default:
@@ -667,6 +710,13 @@ pixman_image_set_repeat (pixman_image_t *image,
     if (image->common.repeat == repeat)
 	return;
 
+    /* The edges of odd sized levels depend on whether the image repeats */
+    if (image->common.repeat == PIXMAN_REPEAT_NONE ||
+	repeat == PIXMAN_REPEAT_NONE)
+    {
+	_pixman_bits_image_discard_mipmap (image);
+    }
+
     image->common.repeat = repeat;
 
     image_property_changed (image);
@@ -821,6 +871,26 @@ pixman_image_get_component_alpha   (pixman_image_t       *image)
     return image->common.component_alpha;
 }
 
+/* Bilinear downscales of a bits image with mipmap set sample box filtered
+ * copies of it at power of two sizes. pixman discards the copies when the
+ * image is the destination of a composite, fill, glyph, trapezoid, trap or
+ * triangle operation, or of pixman_rasterize_edges(); when the bits are
+ * changed in any other way, setting mipmap again discards them. Only
+ * formats with four 8 bit channels are supported. Odd sized images only
+ * use the copies with PIXMAN_REPEAT_NONE or PIXMAN_REPEAT_PAD.
+ */
+PIXMAN_EXPORT void
+pixman_image_set_mipmap (pixman_image_t *image,
+                         pixman_bool_t   mipmap)
+{
+    if (image->type != BITS)
+	return;
+
+    _pixman_bits_image_discard_mipmap (image);
+
+    image->bits.mipmap = mipmap;
+}
+
 PIXMAN_EXPORT void
 pixman_image_set_accessors (pixman_image_t *           image,
                             pixman_read_memory_func_t  read_func,
@@ -924,6 +994,9 @@ _pixman_image_get_solid (pixman_implementation_t *imp,
 	    ITER_NARROW, image->common.flags);
 	
 	result = *iter.get_scanline (&iter, NULL);
+
+	if (iter.fini)
+	    iter.fini (&iter);
     }
 
     /* If necessary, convert RGB <--> BGR. */
@@ -53,14 +53,23 @@ _pixman_implementation_create (pixman_implementation_t *fallback,
 }
 
 #define N_CACHED_FAST_PATHS 8
+#define N_DIRECT_FAST_PATHS 64
 
 typedef struct
 {
-    struct
-    {
-	pixman_implementation_t *	imp;
-	pixman_fast_path_t		fast_path;
-    } cache [N_CACHED_FAST_PATHS];
+    pixman_implementation_t *	imp;
+    pixman_fast_path_t		fast_path;
+} cache_entry_t;
+
+/* Lookups first check a direct-mapped table indexed by a hash of the
+ * operator, formats and flags, which costs a single comparison when the
+ * same kinds of composites come back, as they do for glyphs and small
+ * rectangles. Misses fall back to the list of recently used fast paths.
+ */
+typedef struct
+{
+    cache_entry_t direct [N_DIRECT_FAST_PATHS];
+    cache_entry_t cache [N_CACHED_FAST_PATHS];
 } cache_t;
 
 PIXMAN_DEFINE_THREAD_LOCAL (cache_t, fast_path_cache);
@@ -71,6 +80,32 @@ dummy_composite_rect (pixman_implementation_t *imp,
 {
 }
 
+static force_inline uint32_t
+hash_fast_path (pixman_op_t          op,
+		pixman_format_code_t src_format,
+		uint32_t             src_flags,
+		pixman_format_code_t mask_format,
+		uint32_t             mask_flags,
+		pixman_format_code_t dest_format,
+		uint32_t             dest_flags)
+{
+    uint32_t h;
+
+    h = op;
+    h = h * 31 + src_format;
+    h = h * 31 + mask_format;
+    h = h * 31 + dest_format;
+    h = h * 31 + src_flags;
+    h = h * 31 + mask_flags;
+    h = h * 31 + dest_flags;
+
+    h ^= h >> 16;
+    h *= 0x45d9f3b;
+    h ^= h >> 16;
+
+    return h & (N_DIRECT_FAST_PATHS - 1);
+}
+
 void
 _pixman_implementation_lookup_composite (pixman_implementation_t  *toplevel,
 					 pixman_op_t               op,
@@ -81,15 +116,41 @@ _pixman_implementation_lookup_composite (pixman_implementation_t  *toplevel,
 					 pixman_format_code_t      dest_format,
 					 uint32_t                  dest_flags,
 					 pixman_implementation_t **out_imp,
-					 pixman_composite_func_t  *out_func)
+					 pixman_composite_func_t  *out_func,
+					 pixman_composite_boxes_func_t *out_boxes_func)
 {
+    pixman_composite_boxes_func_t boxes_func;
     pixman_implementation_t *imp;
+    cache_entry_t *direct;
     cache_t *cache;
     int i;
 
     /* Check cache for fast paths */
     cache = PIXMAN_GET_THREAD_LOCAL (fast_path_cache);
 
+    direct = &cache->direct[hash_fast_path (op,
+					    src_format, src_flags,
+					    mask_format, mask_flags,
+					    dest_format, dest_flags)];
+
+    if (direct->fast_path.op == op			&&
+	direct->fast_path.src_format == src_format	&&
+	direct->fast_path.mask_format == mask_format	&&
+	direct->fast_path.dest_format == dest_format	&&
+	direct->fast_path.src_flags == src_flags	&&
+	direct->fast_path.mask_flags == mask_flags	&&
+	direct->fast_path.dest_flags == dest_flags	&&
+	direct->fast_path.func)
+    {
+	*out_imp = direct->imp;
+	*out_func = direct->fast_path.func;
+
+	if (out_boxes_func)
+	    *out_boxes_func = direct->fast_path.boxes_func;
+
+	return;
+    }
+
     for (i = 0; i < N_CACHED_FAST_PATHS; ++i)
     {
 	const pixman_fast_path_t *info = &(cache->cache[i].fast_path);
@@ -110,6 +171,7 @@ _pixman_implementation_lookup_composite (pixman_implementation_t  *toplevel,
 	{
 	    *out_imp = cache->cache[i].imp;
 	    *out_func = cache->cache[i].fast_path.func;
+	    boxes_func = cache->cache[i].fast_path.boxes_func;
 
 	    goto update_cache;
 	}
@@ -136,6 +198,7 @@ _pixman_implementation_lookup_composite (pixman_implementation_t  *toplevel,
 	    {
 		*out_imp = imp;
 		*out_func = info->func;
+		boxes_func = info->boxes_func;
 
 		/* Set i to the last spot in the cache so that the
 		 * move-to-front code below will work
@@ -153,6 +216,7 @@ _pixman_implementation_lookup_composite (pixman_implementation_t  *toplevel,
     _pixman_log_error (FUNC, "No known composite function\n");
     *out_imp = NULL;
     *out_func = dummy_composite_rect;
+    boxes_func = NULL;
 
 update_cache:
     if (i)
@@ -169,7 +233,14 @@ update_cache:
 	cache->cache[0].fast_path.dest_format = dest_format;
 	cache->cache[0].fast_path.dest_flags = dest_flags;
 	cache->cache[0].fast_path.func = *out_func;
+	cache->cache[0].fast_path.boxes_func = boxes_func;
     }
+
+    direct->imp = *out_imp;
+    direct->fast_path = cache->cache[0].fast_path;
+
+    if (out_boxes_func)
+	*out_boxes_func = boxes_func;
 }
 
 static void
@@ -298,6 +369,7 @@ _pixman_implementation_src_iter_init (pixman_implementation_t	*imp,
     iter->height = height;
     iter->iter_flags = iter_flags;
     iter->image_flags = image_flags;
+    iter->fini = NULL;
 
     while (imp)
     {
@@ -330,6 +402,7 @@ _pixman_implementation_dest_iter_init (pixman_implementation_t	*imp,
     iter->height = height;
     iter->iter_flags = iter_flags;
     iter->image_flags = image_flags;
+    iter->fini = NULL;
 
     while (imp)
     {
@@ -431,6 +431,7 @@ fast_composite_scaled_nearest  ## scale_func_name (pixman_implementation_t *imp,
     pixman_fixed_t vx, vy;									\
     pixman_fixed_t unit_x, unit_y;								\
     int32_t left_pad, right_pad;								\
+    int64_t reflect_period = 0, reflect_x = 0;							\
 												\
     src_type_t *src;										\
     dst_type_t *dst;										\
@@ -486,6 +487,15 @@ fast_composite_scaled_nearest  ## scale_func_name (pixman_implementation_t *imp,
 	vx += left_pad * unit_x;								\
     }												\
 												\
+    if (PIXMAN_REPEAT_ ## repeat_mode == PIXMAN_REPEAT_REFLECT)					\
+    {												\
+	/* The image and its mirror image repeat with this period */				\
+	reflect_period = 2 * (int64_t)src_width_fixed;						\
+	reflect_x = vx % reflect_period;							\
+	if (reflect_x < 0)									\
+	    reflect_x += reflect_period;							\
+    }												\
+												\
     while (--height >= 0)									\
     {												\
 	dst = dst_line;										\
@@ -551,6 +561,47 @@ fast_composite_scaled_nearest  ## scale_func_name (pixman_implementation_t *imp,
 			       -pixman_fixed_e, 0, src_width_fixed, TRUE);			\
 	    }											\
 	}											\
+	else if (PIXMAN_REPEAT_ ## repeat_mode == PIXMAN_REPEAT_REFLECT)			\
+	{											\
+	    int64_t x = reflect_x;								\
+	    int32_t width_remain = width;							\
+	    int32_t num_pixels;									\
+												\
+	    repeat (PIXMAN_REPEAT_REFLECT, &y, src_image->bits.height);				\
+	    src = src_first_line + src_stride * y;						\
+												\
+	    while (width_remain > 0)								\
+	    {											\
+		if (x < src_width_fixed)							\
+		{										\
+		    /* Forward run through the image itself */					\
+		    num_pixels = MIN (width_remain,						\
+				      (src_width_fixed - x + unit_x - 1) / unit_x);		\
+		    scanline_func (mask, dst, src + src_image->bits.width, num_pixels,		\
+				   x - src_width_fixed, unit_x, src_width_fixed, FALSE);	\
+		}										\
+		else										\
+		{										\
+		    /* Backward run through the image for the mirrored copy. The		\
+		     * integer part of (period - e - x) is the reflected index.			\
+		     */										\
+		    num_pixels = MIN (width_remain,						\
+				      (reflect_period - x + unit_x - 1) / unit_x);		\
+		    scanline_func (mask, dst, src + src_image->bits.width, num_pixels,		\
+				   reflect_period - pixman_fixed_e - x - src_width_fixed,	\
+				   -unit_x, src_width_fixed, FALSE);				\
+		}										\
+												\
+		dst += num_pixels;								\
+		if (have_mask && !mask_is_solid)						\
+		    mask += num_pixels;								\
+		width_remain -= num_pixels;							\
+												\
+		x += (int64_t)num_pixels * unit_x;						\
+		if (x >= reflect_period)							\
+		    x %= reflect_period;							\
+	    }											\
+	}											\
 	else											\
 	{											\
 	    src = src_first_line + src_stride * y;						\
@@ -617,6 +668,17 @@ fast_composite_scaled_nearest  ## scale_func_name (pixman_implementation_t *imp,
 	fast_composite_scaled_nearest_ ## func ## _normal ## _ ## op,	\
     }
 
+#define SIMPLE_NEAREST_FAST_PATH_REFLECT(op,s,d,func)			\
+    {   PIXMAN_OP_ ## op,						\
+	PIXMAN_ ## s,							\
+	(SCALED_NEAREST_FLAGS		|				\
+	 FAST_PATH_REFLECT_REPEAT	|				\
+	 FAST_PATH_X_UNIT_POSITIVE),					\
+	PIXMAN_null, 0,							\
+	PIXMAN_ ## d, FAST_PATH_STD_DEST_FLAGS,				\
+	fast_composite_scaled_nearest_ ## func ## _reflect ## _ ## op,	\
+    }
+
 #define SIMPLE_NEAREST_FAST_PATH_PAD(op,s,d,func)			\
     {   PIXMAN_OP_ ## op,						\
 	PIXMAN_ ## s,							\
@@ -659,6 +721,17 @@ fast_composite_scaled_nearest  ## scale_func_name (pixman_implementation_t *imp,
 	fast_composite_scaled_nearest_ ## func ## _normal ## _ ## op,	\
     }
 
+#define SIMPLE_NEAREST_A8_MASK_FAST_PATH_REFLECT(op,s,d,func)		\
+    {   PIXMAN_OP_ ## op,						\
+	PIXMAN_ ## s,							\
+	(SCALED_NEAREST_FLAGS		|				\
+	 FAST_PATH_REFLECT_REPEAT	|				\
+	 FAST_PATH_X_UNIT_POSITIVE),					\
+	PIXMAN_a8, MASK_FLAGS (a8, FAST_PATH_UNIFIED_ALPHA),		\
+	PIXMAN_ ## d, FAST_PATH_STD_DEST_FLAGS,				\
+	fast_composite_scaled_nearest_ ## func ## _reflect ## _ ## op,	\
+    }
+
 #define SIMPLE_NEAREST_A8_MASK_FAST_PATH_PAD(op,s,d,func)		\
     {   PIXMAN_OP_ ## op,						\
 	PIXMAN_ ## s,							\
@@ -701,6 +774,17 @@ fast_composite_scaled_nearest  ## scale_func_name (pixman_implementation_t *imp,
 	fast_composite_scaled_nearest_ ## func ## _normal ## _ ## op,	\
     }
 
+#define SIMPLE_NEAREST_SOLID_MASK_FAST_PATH_REFLECT(op,s,d,func)	\
+    {   PIXMAN_OP_ ## op,						\
+	PIXMAN_ ## s,							\
+	(SCALED_NEAREST_FLAGS		|				\
+	 FAST_PATH_REFLECT_REPEAT	|				\
+	 FAST_PATH_X_UNIT_POSITIVE),					\
+	PIXMAN_solid, MASK_FLAGS (solid, FAST_PATH_UNIFIED_ALPHA),	\
+	PIXMAN_ ## d, FAST_PATH_STD_DEST_FLAGS,				\
+	fast_composite_scaled_nearest_ ## func ## _reflect ## _ ## op,	\
+    }
+
 #define SIMPLE_NEAREST_SOLID_MASK_FAST_PATH_PAD(op,s,d,func)		\
     {   PIXMAN_OP_ ## op,						\
 	PIXMAN_ ## s,							\
@@ -737,7 +821,8 @@ fast_composite_scaled_nearest  ## scale_func_name (pixman_implementation_t *imp,
     SIMPLE_NEAREST_FAST_PATH_COVER (op,s,d,func),			\
     SIMPLE_NEAREST_FAST_PATH_NONE (op,s,d,func),			\
     SIMPLE_NEAREST_FAST_PATH_PAD (op,s,d,func),				\
-    SIMPLE_NEAREST_FAST_PATH_NORMAL (op,s,d,func)
+    SIMPLE_NEAREST_FAST_PATH_NORMAL (op,s,d,func),			\
+    SIMPLE_NEAREST_FAST_PATH_REFLECT (op,s,d,func)
 
 #define SIMPLE_NEAREST_A8_MASK_FAST_PATH(op,s,d,func)			\
     SIMPLE_NEAREST_A8_MASK_FAST_PATH_COVER (op,s,d,func),		\
@@ -850,6 +935,7 @@ fast_composite_scaled_bilinear ## scale_func_name (pixman_implementation_t *imp,
     pixman_fixed_t src_width_fixed;								\
     int max_x;											\
     pixman_bool_t need_src_extension;								\
+    int64_t reflect_period = 0, reflect_x = 0;							\
 												\
     PIXMAN_IMAGE_GET_LINE (dest_image, dest_x, dest_y, dst_type_t, dst_stride, dst_line, 1);	\
     if (flags & FLAG_HAVE_SOLID_MASK)								\
@@ -923,6 +1009,15 @@ fast_composite_scaled_bilinear ## scale_func_name (pixman_implementation_t *imp,
 	src_width_fixed = pixman_int_to_fixed (src_width);					\
     }												\
 												\
+    if (PIXMAN_REPEAT_ ## repeat_mode == PIXMAN_REPEAT_REFLECT)					\
+    {												\
+	/* The image and its mirror image repeat with this period */				\
+	reflect_period = 2 * (int64_t)pixman_int_to_fixed (src_image->bits.width);		\
+	reflect_x = v.vector[0] % reflect_period;						\
+	if (reflect_x < 0)									\
+	    reflect_x += reflect_period;							\
+    }												\
+												\
     while (--height >= 0)									\
     {												\
 	int weight1, weight2;									\
@@ -1169,6 +1264,79 @@ fast_composite_scaled_bilinear ## scale_func_name (pixman_implementation_t *imp,
 		}										\
 	    }											\
 	}											\
+	else if (PIXMAN_REPEAT_ ## repeat_mode == PIXMAN_REPEAT_REFLECT)			\
+	{											\
+	    int32_t	    src_w = src_image->bits.width;					\
+	    int64_t	    x = reflect_x;							\
+	    int64_t	    end;								\
+	    int32_t	    num_pixels;								\
+	    int32_t	    width_remain;							\
+	    src_type_t *    src1;								\
+	    src_type_t *    src2;								\
+	    src_type_t	    buf1[2];								\
+	    src_type_t	    buf2[2];								\
+	    int		    k, x1, x2;								\
+												\
+	    repeat (PIXMAN_REPEAT_REFLECT, &y1, src_image->bits.height);			\
+	    repeat (PIXMAN_REPEAT_REFLECT, &y2, src_image->bits.height);			\
+	    src1 = src_first_line + src_stride * y1;						\
+	    src2 = src_first_line + src_stride * y2;						\
+												\
+	    width_remain = width;								\
+												\
+	    while (width_remain > 0)								\
+	    {											\
+		k = x >> 16;									\
+												\
+		if (k < src_w - 1)								\
+		{										\
+		    /* Both pixels are in the image itself */					\
+		    end = (int64_t)(src_w - 1) << 16;						\
+		    num_pixels = MIN (width_remain, (end - x + unit_x - 1) / unit_x);		\
+		    scanline_func (dst, mask, src1, src2, num_pixels,				\
+				   weight1, weight2, x, unit_x, 0, FALSE);			\
+		}										\
+		else if (k > src_w && k < 2 * src_w - 1)					\
+		{										\
+		    /* Both pixels are in the mirrored copy. The pairs are walked		\
+		     * backwards from the mirrored position, rounded such that			\
+		     * the complement of its weight is the original weight.			\
+		     */										\
+		    end = reflect_period - pixman_fixed_1;					\
+		    num_pixels = MIN (width_remain, (end - x + unit_x - 1) / unit_x);		\
+		    scanline_func (dst, mask, src1, src2, num_pixels,				\
+				   weight1, weight2,						\
+				   end - x + (pixman_fixed_1 >> BILINEAR_INTERPOLATION_BITS) - 1, \
+				   -unit_x, 0, FALSE);						\
+		}										\
+		else										\
+		{										\
+		    /* The pair straddles an edge of the image or its mirror */			\
+		    x1 = k;									\
+		    x2 = k + 1;									\
+		    repeat (PIXMAN_REPEAT_REFLECT, &x1, src_w);					\
+		    repeat (PIXMAN_REPEAT_REFLECT, &x2, src_w);					\
+		    buf1[0] = src1[x1];								\
+		    buf1[1] = src1[x2];								\
+		    buf2[0] = src2[x1];								\
+		    buf2[1] = src2[x2];								\
+												\
+		    end = (int64_t)(k + 1) << 16;						\
+		    num_pixels = MIN (width_remain, (end - x + unit_x - 1) / unit_x);		\
+		    scanline_func (dst, mask, buf1, buf2, num_pixels,				\
+				   weight1, weight2, pixman_fixed_frac (x), unit_x, 0, FALSE);	\
+		}										\
+												\
+		width_remain -= num_pixels;							\
+		dst += num_pixels;								\
+		if (flags & FLAG_HAVE_NON_SOLID_MASK)						\
+		    mask += num_pixels;								\
+												\
+		x += (int64_t)num_pixels * unit_x;						\
+		if (x >= reflect_period)							\
+		    x %= reflect_period;							\
+	    }											\
+	}											\
 	else											\
 	{											\
 	    scanline_func (dst, mask, src_first_line + src_stride * y1,				\
@@ -1233,6 +1401,17 @@ fast_composite_scaled_bilinear ## scale_func_name (pixman_implementation_t *imp,
 	fast_composite_scaled_bilinear_ ## func ## _normal ## _ ## op,	\
     }
 
+#define SIMPLE_BILINEAR_FAST_PATH_REFLECT(op,s,d,func)			\
+    {   PIXMAN_OP_ ## op,						\
+	PIXMAN_ ## s,							\
+	(SCALED_BILINEAR_FLAGS		|				\
+	 FAST_PATH_REFLECT_REPEAT	|				\
+	 FAST_PATH_X_UNIT_POSITIVE),					\
+	PIXMAN_null, 0,							\
+	PIXMAN_ ## d, FAST_PATH_STD_DEST_FLAGS,				\
+	fast_composite_scaled_bilinear_ ## func ## _reflect ## _ ## op,	\
+    }
+
 #define SIMPLE_BILINEAR_A8_MASK_FAST_PATH_PAD(op,s,d,func)		\
     {   PIXMAN_OP_ ## op,						\
 	PIXMAN_ ## s,							\
@@ -1275,6 +1454,17 @@ fast_composite_scaled_bilinear ## scale_func_name (pixman_implementation_t *imp,
 	fast_composite_scaled_bilinear_ ## func ## _normal ## _ ## op,	\
     }
 
+#define SIMPLE_BILINEAR_A8_MASK_FAST_PATH_REFLECT(op,s,d,func)		\
+    {   PIXMAN_OP_ ## op,						\
+	PIXMAN_ ## s,							\
+	(SCALED_BILINEAR_FLAGS		|				\
+	 FAST_PATH_REFLECT_REPEAT	|				\
+	 FAST_PATH_X_UNIT_POSITIVE),					\
+	PIXMAN_a8, MASK_FLAGS (a8, FAST_PATH_UNIFIED_ALPHA),		\
+	PIXMAN_ ## d, FAST_PATH_STD_DEST_FLAGS,				\
+	fast_composite_scaled_bilinear_ ## func ## _reflect ## _ ## op,	\
+    }
+
 #define SIMPLE_BILINEAR_SOLID_MASK_FAST_PATH_PAD(op,s,d,func)		\
     {   PIXMAN_OP_ ## op,						\
 	PIXMAN_ ## s,							\
@@ -1317,6 +1507,17 @@ fast_composite_scaled_bilinear ## scale_func_name (pixman_implementation_t *imp,
 	fast_composite_scaled_bilinear_ ## func ## _normal ## _ ## op,	\
     }
 
+#define SIMPLE_BILINEAR_SOLID_MASK_FAST_PATH_REFLECT(op,s,d,func)	\
+    {   PIXMAN_OP_ ## op,						\
+	PIXMAN_ ## s,							\
+	(SCALED_BILINEAR_FLAGS		|				\
+	 FAST_PATH_REFLECT_REPEAT	|				\
+	 FAST_PATH_X_UNIT_POSITIVE),					\
+	PIXMAN_solid, MASK_FLAGS (solid, FAST_PATH_UNIFIED_ALPHA),	\
+	PIXMAN_ ## d, FAST_PATH_STD_DEST_FLAGS,				\
+	fast_composite_scaled_bilinear_ ## func ## _reflect ## _ ## op,	\
+    }
+
 /* Prefer the use of 'cover' variant, because it is faster */
 #define SIMPLE_BILINEAR_FAST_PATH(op,s,d,func)				\
     SIMPLE_BILINEAR_FAST_PATH_COVER (op,s,d,func),			\
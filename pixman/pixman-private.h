@@ -41,6 +41,7 @@ typedef struct linear_gradient linear_gradient_t;
 typedef struct horizontal_gradient horizontal_gradient_t;
 typedef struct vertical_gradient vertical_gradient_t;
 typedef struct conical_gradient conical_gradient_t;
+typedef struct gradient_ramp gradient_ramp_t;
 typedef struct radial_gradient radial_gradient_t;
 typedef struct bits_image bits_image_t;
 typedef struct circle circle_t;
@@ -132,6 +133,9 @@ struct gradient
     image_common_t	    common;
     int                     n_stops;
     pixman_gradient_stop_t *stops;
+
+    /* Precomputed colors, see _pixman_gradient_update_ramp() */
+    gradient_ramp_t *	    ramp;
 };
 
 struct linear_gradient
@@ -190,6 +194,12 @@ struct bits_image
     /* Used for indirect access to the bits */
     pixman_read_memory_func_t  read_func;
     pixman_write_memory_func_t write_func;
+
+    /* Half size copy of the image, built on demand when mipmap is set.
+     * It is never changed once set, only discarded.
+     */
+    pixman_bool_t              mipmap;
+    pixman_image_t *           mip_level;
 };
 
 union pixman_image
@@ -207,6 +217,7 @@ union pixman_image
 typedef struct pixman_iter_t pixman_iter_t;
 typedef uint32_t *(* pixman_iter_get_scanline_t) (pixman_iter_t *iter, const uint32_t *mask);
 typedef void      (* pixman_iter_write_back_t)   (pixman_iter_t *iter);
+typedef void      (* pixman_iter_fini_t)         (pixman_iter_t *iter);
 
 typedef enum
 {
@@ -246,6 +257,7 @@ struct pixman_iter_t
     /* These function pointers are initialized by the implementation */
     pixman_iter_get_scanline_t	get_scanline;
     pixman_iter_write_back_t	write_back;
+    pixman_iter_fini_t		fini;
 
     /* These fields are scratch data that implementations can use */
     void *			data;
@@ -262,6 +274,14 @@ _pixman_bits_image_src_iter_init (pixman_image_t *image, pixman_iter_t *iter);
 void
 _pixman_bits_image_dest_iter_init (pixman_image_t *image, pixman_iter_t *iter);
 
+pixman_image_t *
+_pixman_bits_image_select_mip_level (pixman_image_t *    image,
+				     pixman_image_t *    header,
+				     pixman_transform_t *level_transform);
+
+void
+_pixman_bits_image_discard_mipmap (pixman_image_t *image);
+
 void
 _pixman_linear_gradient_iter_init (pixman_image_t *image, pixman_iter_t  *iter);
 
@@ -285,6 +305,10 @@ _pixman_bits_image_init (pixman_image_t *     image,
 pixman_bool_t
 _pixman_image_fini (pixman_image_t *image);
 
+void
+_pixman_image_init_solid_fill (pixman_image_t *      image,
+                               const pixman_color_t *color);
+
 pixman_image_t *
 _pixman_image_allocate (void);
 
@@ -312,9 +336,75 @@ _pixman_image_validate (pixman_image_t *image);
 	    ((type *) __bits__) + (out_stride) * (y) + (mul) * (x);	\
     } while (0)
 
+/* Doubly linked lists */
+typedef struct pixman_link_t pixman_link_t;
+struct pixman_link_t
+{
+    pixman_link_t *next;
+    pixman_link_t *prev;
+};
+
+typedef struct pixman_list_t pixman_list_t;
+struct pixman_list_t
+{
+    pixman_link_t *head;
+    pixman_link_t *tail;
+};
+
+static force_inline void
+pixman_list_init (pixman_list_t *list)
+{
+    list->head = (pixman_link_t *)list;
+    list->tail = (pixman_link_t *)list;
+}
+
+static force_inline void
+pixman_list_prepend (pixman_list_t *list, pixman_link_t *link)
+{
+    link->next = list->head;
+    link->prev = (pixman_link_t *)list;
+    list->head->prev = link;
+    list->head = link;
+}
+
+static force_inline void
+pixman_list_unlink (pixman_link_t *link)
+{
+    link->prev->next = link->next;
+    link->next->prev = link->prev;
+}
+
+static force_inline void
+pixman_list_move_to_front (pixman_list_t *list, pixman_link_t *link)
+{
+    pixman_list_unlink (link);
+    pixman_list_prepend (list, link);
+}
+
 /*
  * Gradient walker
  */
+
+/* A gradient ramp holds GRADIENT_RAMP_SIZE + 1 premultiplied colors,
+ * sampled at i / GRADIENT_RAMP_SIZE for i in [0, GRADIENT_RAMP_SIZE].
+ */
+#define GRADIENT_RAMP_BITS 10
+#define GRADIENT_RAMP_SIZE (1 << GRADIENT_RAMP_BITS)
+
+/* Ramps are shared between gradients with the same stops and repeat
+ * mode, see _pixman_gradient_update_ramp().
+ */
+struct gradient_ramp
+{
+    int				ref_count;
+    uint32_t			hash;
+    pixman_repeat_t		repeat;
+    int				n_stops;
+    pixman_gradient_stop_t *	stops;
+    pixman_link_t		mru_link;
+    uint32_t			colors[GRADIENT_RAMP_SIZE + 1];
+};
+
 typedef struct
 {
     uint32_t                left_ag;
@@ -329,6 +419,8 @@ typedef struct
     int                     num_stops;
     pixman_repeat_t	    repeat;
 
+    const uint32_t *	    ramp;
+
     pixman_bool_t           need_reset;
 } pixman_gradient_walker_t;
 
@@ -345,6 +437,16 @@ uint32_t
 _pixman_gradient_walker_pixel (pixman_gradient_walker_t *walker,
                                pixman_fixed_48_16_t      x);
 
+const uint32_t *
+_pixman_gradient_get_ramp (gradient_t      *gradient,
+			   pixman_repeat_t  repeat);
+
+void
+_pixman_gradient_update_ramp (gradient_t *gradient);
+
+void
+_pixman_gradient_release_ramp (gradient_t *gradient);
+
 /*
  * Edges
  */
@@ -431,6 +533,16 @@ typedef void (*pixman_combine_float_func_t) (pixman_implementation_t *imp,
 
 typedef void (*pixman_composite_func_t) (pixman_implementation_t *imp,
 					 pixman_composite_info_t *info);
+
+/* Composites a list of boxes in destination coordinates, so that work
+ * that is the same for every box only has to be done once. The source
+ * and mask positions of a box are offset from its destination position
+ * by info->src_x - info->dest_x and so on.
+ */
+typedef void (*pixman_composite_boxes_func_t) (pixman_implementation_t *imp,
+					       pixman_composite_info_t *info,
+					       const pixman_box32_t *   boxes,
+					       int                      n_boxes);
 typedef pixman_bool_t (*pixman_blt_func_t) (pixman_implementation_t *imp,
 					    uint32_t *               src_bits,
 					    uint32_t *               dst_bits,
@@ -469,6 +581,7 @@ typedef struct
     pixman_format_code_t    dest_format;
     uint32_t		    dest_flags;
     pixman_composite_func_t func;
+    pixman_composite_boxes_func_t boxes_func;
 } pixman_fast_path_t;
 
 struct pixman_implementation_t
@@ -507,7 +620,8 @@ _pixman_implementation_lookup_composite (pixman_implementation_t  *toplevel,
 					 pixman_format_code_t      dest_format,
 					 uint32_t                  dest_flags,
 					 pixman_implementation_t **out_imp,
-					 pixman_composite_func_t  *out_func);
+					 pixman_composite_func_t  *out_func,
+					 pixman_composite_boxes_func_t *out_boxes_func);
 
 pixman_combine_32_func_t
 _pixman_implementation_lookup_combiner (pixman_implementation_t *imp,
@@ -685,6 +799,9 @@ _pixman_iter_get_scanline_noop (pixman_iter_t *iter, const uint32_t *mask);
 #define FAST_PATH_SAMPLES_COVER_CLIP_BILINEAR	(1 << 24)
 #define FAST_PATH_BITS_IMAGE			(1 << 25)
 #define FAST_PATH_SEPARABLE_CONVOLUTION_FILTER  (1 << 26)
+#define FAST_PATH_ROW_CONSTANT			(1 << 27)
+#define FAST_PATH_ROTATE_TRANSFORM		(1 << 28)
+#define FAST_PATH_ALIGNED_ROWS			(1 << 29)
 
 #define FAST_PATH_PAD_REPEAT						\
     (FAST_PATH_NO_NONE_REPEAT		|				\
@@ -743,6 +860,15 @@ _pixman_iter_get_scanline_noop (pixman_iter_t *iter, const uint32_t *mask);
 	    dest, FAST_PATH_STD_DEST_FLAGS,				\
 	    func) }
 
+/* A fast path that also has a function for lists of boxes */
+#define PIXMAN_STD_FAST_PATH_BOXES(op, src, mask, dest, func, boxes_func) \
+    { FAST_PATH (							\
+	    op,								\
+	    src,  SOURCE_FLAGS (src),					\
+	    mask, MASK_FLAGS (mask, FAST_PATH_UNIFIED_ALPHA),		\
+	    dest, FAST_PATH_STD_DEST_FLAGS,				\
+	    func), boxes_func }
+
 #define PIXMAN_STD_FAST_PATH_CA(op, src, mask, dest, func)		\
     { FAST_PATH (							\
 	    op,								\
@@ -806,51 +932,6 @@ pixman_bool_t
 pixman_region16_copy_from_region32 (pixman_region16_t *dst,
                                     pixman_region32_t *src);
 
-/* Doubly linked lists */
-typedef struct pixman_link_t pixman_link_t;
-struct pixman_link_t
-{
-    pixman_link_t *next;
-    pixman_link_t *prev;
-};
-
-typedef struct pixman_list_t pixman_list_t;
-struct pixman_list_t
-{
-    pixman_link_t *head;
-    pixman_link_t *tail;
-};
-
-static force_inline void
-pixman_list_init (pixman_list_t *list)
-{
-    list->head = (pixman_link_t *)list;
-    list->tail = (pixman_link_t *)list;
-}
-
-static force_inline void
-pixman_list_prepend (pixman_list_t *list, pixman_link_t *link)
-{
-    link->next = list->head;
-    link->prev = (pixman_link_t *)list;
-    list->head->prev = link;
-    list->head = link;
-}
-
-static force_inline void
-pixman_list_unlink (pixman_link_t *link)
-{
-    link->prev->next = link->next;
-    link->next->prev = link->prev;
-}
-
-static force_inline void
-pixman_list_move_to_front (pixman_list_t *list, pixman_link_t *link)
-{
-    pixman_list_unlink (link);
-    pixman_list_prepend (list, link);
-}
-
 /* Misc macros */
 
 #ifndef FALSE
@@ -985,6 +1066,123 @@ unorm_to_unorm (uint32_t val, int from_bits, int to_bits)
     return result;
 }
 
+/* Conversion of pixels between formats described by their format codes */
+
+static force_inline void
+get_shifts (pixman_format_code_t  format,
+	    int			 *a,
+	    int			 *r,
+	    int                  *g,
+	    int                  *b)
+{
+    switch (PIXMAN_FORMAT_TYPE (format))
+    {
+    case PIXMAN_TYPE_A:
+	*b = 0;
+	*g = 0;
+	*r = 0;
+	*a = 0;
+	break;
+
+    case PIXMAN_TYPE_ARGB:
+    case PIXMAN_TYPE_ARGB_SRGB:
+	*b = 0;
+	*g = *b + PIXMAN_FORMAT_B (format);
+	*r = *g + PIXMAN_FORMAT_G (format);
+	*a = *r + PIXMAN_FORMAT_R (format);
+	break;
+
+    case PIXMAN_TYPE_ABGR:
+	*r = 0;
+	*g = *r + PIXMAN_FORMAT_R (format);
+	*b = *g + PIXMAN_FORMAT_G (format);
+	*a = *b + PIXMAN_FORMAT_B (format);
+	break;
+
+    case PIXMAN_TYPE_BGRA:
+	/* With BGRA formats we start counting at the high end of the pixel */
+	*b = PIXMAN_FORMAT_BPP (format) - PIXMAN_FORMAT_B (format);
+	*g = *b - PIXMAN_FORMAT_B (format);
+	*r = *g - PIXMAN_FORMAT_G (format);
+	*a = *r - PIXMAN_FORMAT_R (format);
+	break;
+
+    case PIXMAN_TYPE_RGBA:
+	/* With BGRA formats we start counting at the high end of the pixel */
+	*r = PIXMAN_FORMAT_BPP (format) - PIXMAN_FORMAT_R (format);
+	*g = *r - PIXMAN_FORMAT_R (format);
+	*b = *g - PIXMAN_FORMAT_G (format);
+	*a = *b - PIXMAN_FORMAT_B (format);
+	break;
+
+    default:
+	assert (0);
+	break;
+    }
+}
+
+static force_inline uint32_t
+convert_channel (uint32_t pixel, uint32_t def_value,
+		 int n_from_bits, int from_shift,
+		 int n_to_bits, int to_shift)
+{
+    uint32_t v;
+
+    if (n_from_bits && n_to_bits)
+	v  = unorm_to_unorm (pixel >> from_shift, n_from_bits, n_to_bits);
+    else if (n_to_bits)
+	v = def_value;
+    else
+	v = 0;
+
+    return (v & ((1 << n_to_bits) - 1)) << to_shift;
+}
+
+static force_inline uint32_t
+convert_pixel (pixman_format_code_t from, pixman_format_code_t to, uint32_t pixel)
+{
+    int a_from_shift, r_from_shift, g_from_shift, b_from_shift;
+    int a_to_shift, r_to_shift, g_to_shift, b_to_shift;
+    uint32_t a, r, g, b;
+
+    get_shifts (from, &a_from_shift, &r_from_shift, &g_from_shift, &b_from_shift);
+    get_shifts (to, &a_to_shift, &r_to_shift, &g_to_shift, &b_to_shift);
+
+    a = convert_channel (pixel, ~0,
+			 PIXMAN_FORMAT_A (from), a_from_shift,
+			 PIXMAN_FORMAT_A (to), a_to_shift);
+
+    r = convert_channel (pixel, 0,
+			 PIXMAN_FORMAT_R (from), r_from_shift,
+			 PIXMAN_FORMAT_R (to), r_to_shift);
+
+    g = convert_channel (pixel, 0,
+			 PIXMAN_FORMAT_G (from), g_from_shift,
+			 PIXMAN_FORMAT_G (to), g_to_shift);
+
+    b = convert_channel (pixel, 0,
+			 PIXMAN_FORMAT_B (from), b_from_shift,
+			 PIXMAN_FORMAT_B (to), b_to_shift);
+
+    return a | r | g | b;
+}
+
+static force_inline uint32_t
+convert_pixel_to_a8r8g8b8 (pixman_image_t *image,
+			   pixman_format_code_t format,
+			   uint32_t pixel)
+{
+    if (PIXMAN_FORMAT_TYPE (format) == PIXMAN_TYPE_GRAY		||
+	PIXMAN_FORMAT_TYPE (format) == PIXMAN_TYPE_COLOR)
+    {
+	return image->bits.indexed->rgba[pixel];
+    }
+    else
+    {
+	return convert_pixel (format, PIXMAN_a8r8g8b8, pixel);
+    }
+}
+
 uint16_t pixman_float_to_unorm (float f, int n_bits);
 float pixman_unorm_to_float (uint16_t u, int n_bits);
 
@@ -49,6 +49,15 @@ color_to_float (const pixman_color_t *color)
     return result;
 }
 
+void
+_pixman_image_init_solid_fill (pixman_image_t *image, const pixman_color_t *color)
+{
+    image->type = SOLID;
+    image->solid.color = *color;
+    image->solid.color_32 = color_to_uint32 (color);
+    image->solid.color_float = color_to_float (color);
+}
+
 PIXMAN_EXPORT pixman_image_t *
 pixman_image_create_solid_fill (const pixman_color_t *color)
 {
@@ -57,10 +66,7 @@ pixman_image_create_solid_fill (const pixman_color_t *color)
     if (!img)
 	return NULL;
 
-    img->type = SOLID;
-    img->solid.color = *color;
-    img->solid.color_32 = color_to_uint32 (color);
-    img->solid.color_float = color_to_float (color);
+    _pixman_image_init_solid_fill (img, color);
 
     return img;
 }
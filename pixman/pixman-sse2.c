@@ -30,6 +30,8 @@
 #include <config.h>
 #endif
 
+#include <math.h>
+#include <float.h>
 #include <xmmintrin.h> /* for _mm_shuffle_pi16 and _MM_SHUFFLE */
 #include <emmintrin.h> /* for SSE2 intrinsics */
 #include "pixman-private.h"
@@ -2384,29 +2386,18 @@ create_mask_2x32_128 (uint32_t mask0,
 }
 #endif
 
-static void
-sse2_composite_over_n_8888 (pixman_implementation_t *imp,
-                            pixman_composite_info_t *info)
+static force_inline void
+over_n_8888_rect_sse2 (uint32_t *dst_line,
+		       int       dst_stride,
+		       int32_t   width,
+		       int32_t   height,
+		       __m128i   xmm_src,
+		       __m128i   xmm_alpha)
 {
-    PIXMAN_COMPOSITE_ARGS (info);
-    uint32_t src;
-    uint32_t    *dst_line, *dst, d;
+    uint32_t *dst, d;
     int32_t w;
-    int dst_stride;
-    __m128i xmm_src, xmm_alpha;
     __m128i xmm_dst, xmm_dst_lo, xmm_dst_hi;
 
-    src = _pixman_image_get_solid (imp, src_image, dest_image->bits.format);
-
-    if (src == 0)
-	return;
-
-    PIXMAN_IMAGE_GET_LINE (
-	dest_image, dest_x, dest_y, uint32_t, dst_stride, dst_line, 1);
-
-    xmm_src = expand_pixel_32_1x128 (src);
-    xmm_alpha = expand_alpha_1x128 (xmm_src);
-
     while (height--)
     {
 	dst = dst_line;
@@ -2453,6 +2444,64 @@ sse2_composite_over_n_8888 (pixman_implementation_t *imp,
     }
 }
 
+static void
+sse2_composite_over_n_8888 (pixman_implementation_t *imp,
+                            pixman_composite_info_t *info)
+{
+    PIXMAN_COMPOSITE_ARGS (info);
+    uint32_t src;
+    uint32_t    *dst_line;
+    int dst_stride;
+    __m128i xmm_src, xmm_alpha;
+
+    src = _pixman_image_get_solid (imp, src_image, dest_image->bits.format);
+
+    if (src == 0)
+	return;
+
+    PIXMAN_IMAGE_GET_LINE (
+	dest_image, dest_x, dest_y, uint32_t, dst_stride, dst_line, 1);
+
+    xmm_src = expand_pixel_32_1x128 (src);
+    xmm_alpha = expand_alpha_1x128 (xmm_src);
+
+    over_n_8888_rect_sse2 (dst_line, dst_stride, width, height,
+			   xmm_src, xmm_alpha);
+}
+
+static void
+sse2_composite_over_n_8888_boxes (pixman_implementation_t *imp,
+				  pixman_composite_info_t *info,
+				  const pixman_box32_t *   boxes,
+				  int                      n_boxes)
+{
+    pixman_image_t *dest_image = info->dest_image;
+    uint32_t src;
+    uint32_t    *dst_line;
+    int dst_stride;
+    __m128i xmm_src, xmm_alpha;
+
+    src = _pixman_image_get_solid (imp, info->src_image, dest_image->bits.format);
+
+    if (src == 0)
+	return;
+
+    xmm_src = expand_pixel_32_1x128 (src);
+    xmm_alpha = expand_alpha_1x128 (xmm_src);
+
+    while (n_boxes--)
+    {
+	PIXMAN_IMAGE_GET_LINE (
+	    dest_image, boxes->x1, boxes->y1, uint32_t, dst_stride, dst_line, 1);
+
+	over_n_8888_rect_sse2 (dst_line, dst_stride,
+			       boxes->x2 - boxes->x1, boxes->y2 - boxes->y1,
+			       xmm_src, xmm_alpha);
+
+	boxes++;
+    }
+}
+
 static void
 sse2_composite_over_n_0565 (pixman_implementation_t *imp,
                             pixman_composite_info_t *info)
@@ -4218,6 +4267,90 @@ sse2_composite_in_n_8 (pixman_implementation_t *imp,
 
 }
 
+static void
+sse2_composite_over_n_8 (pixman_implementation_t *imp,
+			 pixman_composite_info_t *info)
+{
+    PIXMAN_COMPOSITE_ARGS (info);
+    uint8_t     *dst_line, *dst;
+    int dst_stride;
+    uint32_t src;
+    int32_t w;
+
+    __m128i xmm_src, xmm_ialpha;
+    __m128i xmm_dst, xmm_dst_lo, xmm_dst_hi;
+
+    PIXMAN_IMAGE_GET_LINE (
+	dest_image, dest_x, dest_y, uint8_t, dst_stride, dst_line, 1);
+
+    src = _pixman_image_get_solid (imp, src_image, dest_image->bits.format);
+
+    xmm_ialpha = negate_1x128 (expand_alpha_1x128 (expand_pixel_32_1x128 (src)));
+
+    src >>= 24;
+
+    if (src == 0x00)
+	return;
+
+    if (src == 0xff)
+    {
+	pixman_fill (dest_image->bits.bits, dest_image->bits.rowstride,
+		     8, dest_x, dest_y, width, height, 0xff);
+
+	return;
+    }
+
+    /* src + dest * (1 - src) never exceeds 0xff, so the additions can't
+     * saturate.
+     */
+    xmm_src = _mm_set1_epi8 ((char)src);
+
+    while (height--)
+    {
+	dst = dst_line;
+	dst_line += dst_stride;
+	w = width;
+
+	while (w && ((uintptr_t)dst & 15))
+	{
+	    *dst = (uint8_t)(src + pack_1x128_32 (
+				 pix_multiply_1x128 (
+				     xmm_ialpha,
+				     unpack_32_1x128 (*dst))));
+	    dst++;
+	    w--;
+	}
+
+	while (w >= 16)
+	{
+	    xmm_dst = load_128_aligned ((__m128i*)dst);
+
+	    unpack_128_2x128 (xmm_dst, &xmm_dst_lo, &xmm_dst_hi);
+
+	    pix_multiply_2x128 (&xmm_ialpha, &xmm_ialpha,
+				&xmm_dst_lo, &xmm_dst_hi,
+				&xmm_dst_lo, &xmm_dst_hi);
+
+	    save_128_aligned (
+		(__m128i*)dst,
+		_mm_adds_epu8 (xmm_src, pack_2x128_128 (xmm_dst_lo, xmm_dst_hi)));
+
+	    dst += 16;
+	    w -= 16;
+	}
+
+	while (w)
+	{
+	    *dst = (uint8_t)(src + pack_1x128_32 (
+				 pix_multiply_1x128 (
+				     xmm_ialpha,
+				     unpack_32_1x128 (*dst))));
+	    dst++;
+	    w--;
+	}
+    }
+}
+
 static void
 sse2_composite_in_8_8 (pixman_implementation_t *imp,
                        pixman_composite_info_t *info)
@@ -4375,6 +4508,94 @@ sse2_composite_add_n_8_8 (pixman_implementation_t *imp,
 
 }
 
+static void
+sse2_composite_add_n_1_8 (pixman_implementation_t *imp,
+			  pixman_composite_info_t *info)
+{
+    PIXMAN_COMPOSITE_ARGS (info);
+    uint8_t     *dst_line, *dst;
+    uint8_t     *mask_line;
+    const uint8_t *m;
+    int dst_stride, mask_stride;
+    int32_t w, x;
+    uint32_t src, bits;
+    uint16_t t;
+
+    __m128i xmm_src, xmm_bit, xmm_mask;
+
+    src = _pixman_image_get_solid (imp, src_image, dest_image->bits.format);
+
+    src >>= 24;
+
+    if (src == 0x00)
+	return;
+
+    PIXMAN_IMAGE_GET_LINE (
+	dest_image, dest_x, dest_y, uint8_t, dst_stride, dst_line, 1);
+    PIXMAN_IMAGE_GET_LINE (
+	mask_image, 0, mask_y, uint8_t, mask_stride, mask_line, 1);
+
+    xmm_src = _mm_set1_epi8 ((char)src);
+    xmm_bit = _mm_set_epi8 (-128, 64, 32, 16, 8, 4, 2, 1,
+			    -128, 64, 32, 16, 8, 4, 2, 1);
+
+    while (height--)
+    {
+	dst = dst_line;
+	dst_line += dst_stride;
+	x = mask_x;
+	w = width;
+
+	while (w >= 16)
+	{
+	    /* Fetch the next 16 bits of the mask. The third byte is
+	     * only touched when the bits actually straddle it.
+	     */
+	    m = mask_line + (x >> 3);
+	    bits = m[0] | (m[1] << 8);
+	    if (x & 7)
+		bits = (bits >> (x & 7)) | (m[2] << (16 - (x & 7)));
+
+	    if (bits & 0xffff)
+	    {
+		/* Broadcast byte i / 8 of the bits to byte i, then turn
+		 * each set bit into a 0xff byte
+		 */
+		xmm_mask = _mm_cvtsi32_si128 (bits);
+		xmm_mask = _mm_unpacklo_epi8 (xmm_mask, xmm_mask);
+		xmm_mask = _mm_unpacklo_epi16 (xmm_mask, xmm_mask);
+		xmm_mask = _mm_unpacklo_epi32 (xmm_mask, xmm_mask);
+		xmm_mask = _mm_cmpeq_epi8 (
+		    _mm_and_si128 (xmm_mask, xmm_bit), xmm_bit);
+
+		save_128_unaligned (
+		    (__m128i*)dst,
+		    _mm_adds_epu8 (load_128_unaligned ((__m128i*)dst),
+				   _mm_and_si128 (xmm_mask, xmm_src)));
+	    }
+
+	    dst += 16;
+	    x += 16;
+	    w -= 16;
+	}
+
+	while (w)
+	{
+	    if (mask_line[x >> 3] & (1 << (x & 7)))
+	    {
+		t = (*dst) + src;
+		*dst = t | (0 - (t >> 8));
+	    }
+
+	    dst++;
+	    x++;
+	    w--;
+	}
+
+	mask_line += mask_stride;
+    }
+}
+
 static void
 sse2_composite_add_n_8 (pixman_implementation_t *imp,
 			pixman_composite_info_t *info)
@@ -5426,6 +5647,9 @@ FAST_NEAREST_MAINLOOP (sse2_8888_8888_pad_OVER,
 FAST_NEAREST_MAINLOOP (sse2_8888_8888_normal_OVER,
 		       scaled_nearest_scanline_sse2_8888_8888_OVER,
 		       uint32_t, uint32_t, NORMAL)
+FAST_NEAREST_MAINLOOP (sse2_8888_8888_reflect_OVER,
+		       scaled_nearest_scanline_sse2_8888_8888_OVER,
+		       uint32_t, uint32_t, REFLECT)
 
 static force_inline void
 scaled_nearest_scanline_sse2_8888_n_8888_OVER (const uint32_t * mask,
@@ -5553,6 +5777,9 @@ FAST_NEAREST_MAINLOOP_COMMON (sse2_8888_n_8888_none_OVER,
 FAST_NEAREST_MAINLOOP_COMMON (sse2_8888_n_8888_normal_OVER,
 			      scaled_nearest_scanline_sse2_8888_n_8888_OVER,
 			      uint32_t, uint32_t, uint32_t, NORMAL, TRUE, TRUE)
+FAST_NEAREST_MAINLOOP_COMMON (sse2_8888_n_8888_reflect_OVER,
+			      scaled_nearest_scanline_sse2_8888_n_8888_OVER,
+			      uint32_t, uint32_t, uint32_t, REFLECT, TRUE, TRUE)
 
 #define BMSK ((1 << BILINEAR_INTERPOLATION_BITS) - 1)
 
@@ -5677,6 +5904,10 @@ FAST_BILINEAR_MAINLOOP_COMMON (sse2_8888_8888_normal_SRC,
 			       scaled_bilinear_scanline_sse2_8888_8888_SRC,
 			       uint32_t, uint32_t, uint32_t,
 			       NORMAL, FLAG_NONE)
+FAST_BILINEAR_MAINLOOP_COMMON (sse2_8888_8888_reflect_SRC,
+			       scaled_bilinear_scanline_sse2_8888_8888_SRC,
+			       uint32_t, uint32_t, uint32_t,
+			       REFLECT, FLAG_NONE)
 
 static force_inline void
 scaled_bilinear_scanline_sse2_8888_8888_OVER (uint32_t *       dst,
@@ -5777,82 +6008,591 @@ FAST_BILINEAR_MAINLOOP_COMMON (sse2_8888_8888_normal_OVER,
 			       scaled_bilinear_scanline_sse2_8888_8888_OVER,
 			       uint32_t, uint32_t, uint32_t,
 			       NORMAL, FLAG_NONE)
+FAST_BILINEAR_MAINLOOP_COMMON (sse2_8888_8888_reflect_OVER,
+			       scaled_bilinear_scanline_sse2_8888_8888_OVER,
+			       uint32_t, uint32_t, uint32_t,
+			       REFLECT, FLAG_NONE)
+
+/* Bilinear upscaling, where successive destination rows mostly sample the
+ * same pair of source rows. The source rows are interpolated horizontally
+ * first and the two most recent ones are cached, keyed by their source y,
+ * so most destination rows only need the vertical interpolation. The sums
+ * are the same as those of the scanline functions above, so the results
+ * are identical.
+ */
+typedef struct
+{
+    const uint32_t *	src_first_line;
+    int			src_stride;
+    const int32_t *	left;
+    const int32_t *	right;
+    const uint32_t *	weights;
+    int			width;
+    int			row_y[2];
+    int16_t *		rows[2];
+} sse2_bilinear_rows_t;
 
-static force_inline void
-scaled_bilinear_scanline_sse2_8888_8_8888_OVER (uint32_t *       dst,
-						const uint8_t  * mask,
-						const uint32_t * src_top,
-						const uint32_t * src_bottom,
-						int32_t          w,
-						int              wt,
-						int              wb,
-						pixman_fixed_t   vx,
-						pixman_fixed_t   unit_x,
-						pixman_fixed_t   max_vx,
-						pixman_bool_t    zero_src)
+static void
+sse2_bilinear_filter_row (int16_t *	    row,
+			  const uint32_t *  src,
+			  const int32_t *   left,
+			  const int32_t *   right,
+			  const uint32_t *  weights,
+			  int		    width)
 {
-    BILINEAR_DECLARE_VARIABLES;
-    uint32_t pix1, pix2, pix3, pix4;
-    uint32_t m;
+    const __m128i xmm_zero = _mm_setzero_si128 ();
+    int i;
 
-    while (w && ((uintptr_t)dst & 15))
+    for (i = 0; i < width; i += 2)
     {
-	uint32_t sa;
+	__m128i xmm_p0, xmm_p1;
 
-	m = (uint32_t) *mask++;
+	/* Interleave the channels of the left and right pixels */
+	xmm_p0 = _mm_unpacklo_epi8 (_mm_cvtsi32_si128 (src[left[i]]),
+				    _mm_cvtsi32_si128 (src[right[i]]));
+	xmm_p0 = _mm_madd_epi16 (_mm_unpacklo_epi8 (xmm_p0, xmm_zero),
+				 _mm_set1_epi32 (weights[i]));
 
-	if (m)
+	if (i + 1 == width)
 	{
-	    BILINEAR_INTERPOLATE_ONE_PIXEL (pix1);
-	    sa = pix1 >> 24;
+	    _mm_storel_epi64 ((__m128i *)(row + 4 * i),
+			      _mm_packs_epi32 (xmm_p0, xmm_p0));
+	    break;
+	}
 
-	    if (sa == 0xff && m == 0xff)
-	    {
-		*dst = pix1;
-	    }
-	    else
-	    {
-		__m128i ms, md, ma, msa;
+	xmm_p1 = _mm_unpacklo_epi8 (_mm_cvtsi32_si128 (src[left[i + 1]]),
+				    _mm_cvtsi32_si128 (src[right[i + 1]]));
+	xmm_p1 = _mm_madd_epi16 (_mm_unpacklo_epi8 (xmm_p1, xmm_zero),
+				 _mm_set1_epi32 (weights[i + 1]));
 
-		pix2 = *dst;
-		ma = expand_alpha_rev_1x128 (load_32_1x128 (m));
-		ms = unpack_32_1x128 (pix1);
-		md = unpack_32_1x128 (pix2);
+	save_128_unaligned ((__m128i *)(row + 4 * i),
+			    _mm_packs_epi32 (xmm_p0, xmm_p1));
+    }
+}
 
-		msa = expand_alpha_rev_1x128 (load_32_1x128 (sa));
+static int16_t *
+sse2_bilinear_get_row (sse2_bilinear_rows_t *rows, int y, int keep)
+{
+    int slot;
 
-		*dst = pack_1x128_32 (in_over_1x128 (&ms, &msa, &ma, &md));
-	    }
-	}
-	else
-	{
-	    BILINEAR_SKIP_ONE_PIXEL ();
-	}
+    if (rows->row_y[0] == y)
+	return rows->rows[0];
+    if (rows->row_y[1] == y)
+	return rows->rows[1];
 
-	w--;
-	dst++;
-    }
+    /* Replace the row that is not needed for the other weight */
+    slot = (rows->row_y[0] == keep) ? 1 : 0;
 
-    while (w >= 4)
+    if (y < 0)
     {
-	__m128i xmm_src, xmm_src_lo, xmm_src_hi, xmm_srca_lo, xmm_srca_hi;
-	__m128i xmm_dst, xmm_dst_lo, xmm_dst_hi;
-	__m128i xmm_mask, xmm_mask_lo, xmm_mask_hi;
+	memset (rows->rows[slot], 0, rows->width * 4 * sizeof (int16_t));
+    }
+    else
+    {
+	sse2_bilinear_filter_row (rows->rows[slot],
+				  rows->src_first_line + rows->src_stride * y,
+				  rows->left, rows->right, rows->weights,
+				  rows->width);
+    }
 
-	m = *(uint32_t*)mask;
+    rows->row_y[slot] = y;
 
-	if (m)
-	{
-	    BILINEAR_INTERPOLATE_ONE_PIXEL (pix1);
-	    BILINEAR_INTERPOLATE_ONE_PIXEL (pix2);
-	    BILINEAR_INTERPOLATE_ONE_PIXEL (pix3);
-	    BILINEAR_INTERPOLATE_ONE_PIXEL (pix4);
+    return rows->rows[slot];
+}
 
-	    xmm_src = _mm_set_epi32 (pix4, pix3, pix2, pix1);
+/* Interpolates two pixels from each of the rows vertically */
+static force_inline __m128i
+sse2_bilinear_lerp_rows (__m128i xmm_top, __m128i xmm_bottom, __m128i xmm_w)
+{
+    __m128i xmm_lo, xmm_hi;
 
-	    if (m == 0xffffffff && is_opaque (xmm_src))
-	    {
-		save_128_aligned ((__m128i *)dst, xmm_src);
+    xmm_lo = _mm_madd_epi16 (_mm_unpacklo_epi16 (xmm_top, xmm_bottom), xmm_w);
+    xmm_hi = _mm_madd_epi16 (_mm_unpackhi_epi16 (xmm_top, xmm_bottom), xmm_w);
+
+    xmm_lo = _mm_srli_epi32 (xmm_lo, BILINEAR_INTERPOLATION_BITS * 2);
+    xmm_hi = _mm_srli_epi32 (xmm_hi, BILINEAR_INTERPOLATION_BITS * 2);
+
+    return _mm_packs_epi32 (xmm_lo, xmm_hi);
+}
+
+static void
+sse2_bilinear_lerp_scanline (uint32_t *	     dst,
+			     const int16_t * top,
+			     const int16_t * bottom,
+			     int	     wt,
+			     int	     wb,
+			     int	     width)
+{
+    const __m128i xmm_w = _mm_set1_epi32 (wt | (wb << 16));
+    __m128i xmm_a, xmm_b;
+    int i;
+
+    for (i = 0; i + 4 <= width; i += 4)
+    {
+	xmm_a = sse2_bilinear_lerp_rows (
+	    load_128_unaligned ((__m128i *)(top + 4 * i)),
+	    load_128_unaligned ((__m128i *)(bottom + 4 * i)), xmm_w);
+	xmm_b = sse2_bilinear_lerp_rows (
+	    load_128_unaligned ((__m128i *)(top + 4 * i + 8)),
+	    load_128_unaligned ((__m128i *)(bottom + 4 * i + 8)), xmm_w);
+
+	save_128_unaligned ((__m128i *)(dst + i), _mm_packus_epi16 (xmm_a, xmm_b));
+    }
+
+    for (; i < width; ++i)
+    {
+	xmm_a = sse2_bilinear_lerp_rows (
+	    _mm_loadl_epi64 ((__m128i *)(top + 4 * i)),
+	    _mm_loadl_epi64 ((__m128i *)(bottom + 4 * i)), xmm_w);
+
+	dst[i] = _mm_cvtsi128_si32 (_mm_packus_epi16 (xmm_a, xmm_a));
+    }
+}
+
+static pixman_bool_t
+sse2_composite_scaled_bilinear_upscale (pixman_implementation_t *imp,
+					pixman_composite_info_t *info,
+					pixman_repeat_t          repeat_mode)
+{
+    PIXMAN_COMPOSITE_ARGS (info);
+    pixman_fixed_t unit_x, unit_y;
+    pixman_fixed_t vx, vy;
+    pixman_vector_t v;
+    sse2_bilinear_rows_t rows;
+    uint32_t *dst_line, *buffer;
+    uint32_t *weights;
+    int32_t *left, *right;
+    int src_width = src_image->bits.width;
+    int src_height = src_image->bits.height;
+    int dst_stride;
+    int i;
+
+    unit_x = src_image->common.transform->matrix[0][0];
+    unit_y = src_image->common.transform->matrix[1][1];
+
+    /* Only worth it when destination rows share source rows. The cached
+     * rows would overflow with 8 bit weights.
+     */
+    if (BILINEAR_INTERPOLATION_BITS > 7			||
+	height < 2					||
+	unit_y <= -pixman_fixed_1 || unit_y >= pixman_fixed_1 ||
+	width > (INT32_MAX - 16) / 32)
+    {
+	return FALSE;
+    }
+
+    /* reference point is the center of the pixel */
+    v.vector[0] = pixman_int_to_fixed (src_x) + pixman_fixed_1 / 2;
+    v.vector[1] = pixman_int_to_fixed (src_y) + pixman_fixed_1 / 2;
+    v.vector[2] = pixman_fixed_1;
+
+    if (!pixman_transform_point_3d (src_image->common.transform, &v))
+	return TRUE;
+
+    vx = v.vector[0] - pixman_fixed_1 / 2;
+    vy = v.vector[1] - pixman_fixed_1 / 2;
+
+    /* Two rows of 16 bit channels, the column map and a scanline for OVER */
+    buffer = malloc (width * 32 + 16);
+    if (!buffer)
+	return FALSE;
+
+    rows.rows[0] = (int16_t *)buffer;
+    rows.rows[1] = rows.rows[0] + width * 4;
+    left = (int32_t *)(rows.rows[1] + width * 4);
+    right = left + width;
+    weights = (uint32_t *)(right + width);
+
+    for (i = 0; i < width; ++i)
+    {
+	int x1 = pixman_fixed_to_int (vx);
+	int x2 = x1 + 1;
+	int wr = pixman_fixed_to_bilinear_weight (vx);
+	int wl = BILINEAR_INTERPOLATION_RANGE - wr;
+
+	/* Pixels outside of a NONE repeat image get a zero weight */
+	if (!repeat (repeat_mode, &x1, src_width))
+	    x1 = wl = 0;
+	if (!repeat (repeat_mode, &x2, src_width))
+	    x2 = wr = 0;
+
+	left[i] = x1;
+	right[i] = x2;
+	weights[i] = wl | (wr << 16);
+
+	vx += unit_x;
+    }
+
+    PIXMAN_IMAGE_GET_LINE (dest_image, dest_x, dest_y, uint32_t, dst_stride, dst_line, 1);
+    PIXMAN_IMAGE_GET_LINE (src_image, 0, 0, uint32_t, rows.src_stride, rows.src_first_line, 1);
+
+    rows.left = left;
+    rows.right = right;
+    rows.weights = weights;
+    rows.width = width;
+    rows.row_y[0] = rows.row_y[1] = -2;
+
+    while (--height >= 0)
+    {
+	int16_t *top, *bottom;
+	int y1, y2, wt, wb;
+
+	y1 = pixman_fixed_to_int (vy);
+	y2 = y1 + 1;
+	wb = pixman_fixed_to_bilinear_weight (vy);
+	wt = BILINEAR_INTERPOLATION_RANGE - wb;
+	if (!wb)
+	    y2 = y1;
+	vy += unit_y;
+
+	/* Rows outside of a NONE repeat image are cached as -1 */
+	if (!repeat (repeat_mode, &y1, src_height))
+	    y1 = -1;
+	if (!repeat (repeat_mode, &y2, src_height))
+	    y2 = -1;
+
+	top = sse2_bilinear_get_row (&rows, y1, y2);
+	bottom = sse2_bilinear_get_row (&rows, y2, y1);
+
+	if (op == PIXMAN_OP_SRC)
+	{
+	    sse2_bilinear_lerp_scanline (dst_line, top, bottom, wt, wb, width);
+	}
+	else
+	{
+	    sse2_bilinear_lerp_scanline (weights + width, top, bottom, wt, wb, width);
+	    core_combine_over_u_sse2_no_mask (dst_line, weights + width, width);
+	}
+
+	dst_line += dst_stride;
+    }
+
+    free (buffer);
+
+    return TRUE;
+}
+
+#define SSE2_BILINEAR_UPSCALE_MAINLOOP(repeat_name, repeat_mode, op)		\
+static void									\
+fast_composite_scaled_bilinear_sse2_8888_8888_upscale_ ## repeat_name ## _ ## op (	\
+    pixman_implementation_t *imp, pixman_composite_info_t *info)		\
+{										\
+    if (!sse2_composite_scaled_bilinear_upscale (				\
+	    imp, info, PIXMAN_REPEAT_ ## repeat_mode))				\
+    {										\
+	fast_composite_scaled_bilinear_sse2_8888_8888_ ## repeat_name ## _ ## op (	\
+	    imp, info);								\
+    }										\
+}
+
+/* The samples are within the image for COVER, so padding never changes them */
+SSE2_BILINEAR_UPSCALE_MAINLOOP (cover, PAD, SRC)
+SSE2_BILINEAR_UPSCALE_MAINLOOP (pad, PAD, SRC)
+SSE2_BILINEAR_UPSCALE_MAINLOOP (none, NONE, SRC)
+SSE2_BILINEAR_UPSCALE_MAINLOOP (normal, NORMAL, SRC)
+SSE2_BILINEAR_UPSCALE_MAINLOOP (reflect, REFLECT, SRC)
+SSE2_BILINEAR_UPSCALE_MAINLOOP (cover, PAD, OVER)
+SSE2_BILINEAR_UPSCALE_MAINLOOP (pad, PAD, OVER)
+SSE2_BILINEAR_UPSCALE_MAINLOOP (none, NONE, OVER)
+SSE2_BILINEAR_UPSCALE_MAINLOOP (normal, NORMAL, OVER)
+SSE2_BILINEAR_UPSCALE_MAINLOOP (reflect, REFLECT, OVER)
+
+/* Arbitrary rotations step diagonally through the source, so that every
+ * destination scanline touches as many source rows as it has pixels.
+ * Compositing the destination in tiles keeps the part of the source that
+ * a tile samples in the cache until all of its rows are done.
+ */
+#define ROTATE_TILE_SIZE 64
+
+static force_inline uint32_t
+sse2_rotate_fetch_pixel (const bits_image_t *bits,
+			 int		     x,
+			 int		     y,
+			 pixman_repeat_t     repeat_mode,
+			 uint32_t	     alpha)
+{
+    if (!repeat (repeat_mode, &x, bits->width)	||
+	!repeat (repeat_mode, &y, bits->height))
+    {
+	return 0;
+    }
+
+    return bits->bits[y * bits->rowstride + x] | alpha;
+}
+
+static void
+sse2_rotate_nearest_row (uint32_t *	    dst,
+			 int		    width,
+			 const bits_image_t *bits,
+			 pixman_fixed_t	    vx,
+			 pixman_fixed_t	    vy,
+			 pixman_fixed_t	    ux,
+			 pixman_fixed_t	    uy,
+			 uint32_t	    alpha)
+{
+    pixman_repeat_t repeat_mode = bits->common.repeat;
+    int i;
+
+    for (i = 0; i < width; ++i)
+    {
+	int x0 = pixman_fixed_to_int (vx - pixman_fixed_e);
+	int y0 = pixman_fixed_to_int (vy - pixman_fixed_e);
+
+	if ((unsigned)x0 < (unsigned)bits->width &&
+	    (unsigned)y0 < (unsigned)bits->height)
+	{
+	    dst[i] = bits->bits[y0 * bits->rowstride + x0] | alpha;
+	}
+	else
+	{
+	    dst[i] = sse2_rotate_fetch_pixel (bits, x0, y0, repeat_mode, alpha);
+	}
+
+	vx += ux;
+	vy += uy;
+    }
+}
+
+/* The low halves of xmm_top and xmm_bottom hold the two pixels of the
+ * top and bottom rows.
+ */
+static force_inline uint32_t
+sse2_bilinear_interpolate (__m128i xmm_top, __m128i xmm_bottom,
+			   int	   distx,   int	    disty)
+{
+    const __m128i xmm_zero = _mm_setzero_si128 ();
+    __m128i xmm_l, xmm_r, xmm_lr;
+
+    xmm_top = _mm_unpacklo_epi8 (xmm_top, xmm_zero);
+    xmm_bottom = _mm_unpacklo_epi8 (xmm_bottom, xmm_zero);
+
+    /* Vertically, to 16 bit channels of the left and right columns */
+    xmm_lr = _mm_set1_epi32 (
+	(BILINEAR_INTERPOLATION_RANGE - disty) | (disty << 16));
+    xmm_l = _mm_madd_epi16 (_mm_unpacklo_epi16 (xmm_top, xmm_bottom), xmm_lr);
+    xmm_r = _mm_madd_epi16 (_mm_unpackhi_epi16 (xmm_top, xmm_bottom), xmm_lr);
+    xmm_lr = _mm_packs_epi32 (xmm_l, xmm_r);
+
+    /* Then horizontally */
+    xmm_lr = _mm_madd_epi16 (
+	_mm_unpacklo_epi16 (xmm_lr, _mm_srli_si128 (xmm_lr, 8)),
+	_mm_set1_epi32 ((BILINEAR_INTERPOLATION_RANGE - distx) | (distx << 16)));
+    xmm_lr = _mm_srli_epi32 (xmm_lr, BILINEAR_INTERPOLATION_BITS * 2);
+    xmm_lr = _mm_packs_epi32 (xmm_lr, xmm_lr);
+
+    return _mm_cvtsi128_si32 (_mm_packus_epi16 (xmm_lr, xmm_lr));
+}
+
+static void
+sse2_rotate_bilinear_row (uint32_t *	     dst,
+			  int		     width,
+			  const bits_image_t *bits,
+			  pixman_fixed_t     vx,
+			  pixman_fixed_t     vy,
+			  pixman_fixed_t     ux,
+			  pixman_fixed_t     uy,
+			  uint32_t	     alpha)
+{
+    pixman_repeat_t repeat_mode = bits->common.repeat;
+    const __m128i xmm_alpha = _mm_set1_epi32 (alpha);
+    int i;
+
+    for (i = 0; i < width; ++i)
+    {
+	pixman_fixed_t x = vx - pixman_fixed_1 / 2;
+	pixman_fixed_t y = vy - pixman_fixed_1 / 2;
+	int x1 = pixman_fixed_to_int (x);
+	int y1 = pixman_fixed_to_int (y);
+	__m128i xmm_top, xmm_bottom;
+
+	if ((unsigned)x1 < (unsigned)bits->width - 1 &&
+	    (unsigned)y1 < (unsigned)bits->height - 1)
+	{
+	    const uint32_t *row = bits->bits + y1 * bits->rowstride + x1;
+
+	    xmm_top = _mm_or_si128 (
+		_mm_loadl_epi64 ((__m128i *)row), xmm_alpha);
+	    xmm_bottom = _mm_or_si128 (
+		_mm_loadl_epi64 ((__m128i *)(row + bits->rowstride)), xmm_alpha);
+	}
+	else
+	{
+	    /* Pixels outside of a NONE repeat image are transparent */
+	    xmm_top = _mm_unpacklo_epi32 (
+		_mm_cvtsi32_si128 (sse2_rotate_fetch_pixel (
+				       bits, x1, y1, repeat_mode, alpha)),
+		_mm_cvtsi32_si128 (sse2_rotate_fetch_pixel (
+				       bits, x1 + 1, y1, repeat_mode, alpha)));
+	    xmm_bottom = _mm_unpacklo_epi32 (
+		_mm_cvtsi32_si128 (sse2_rotate_fetch_pixel (
+				       bits, x1, y1 + 1, repeat_mode, alpha)),
+		_mm_cvtsi32_si128 (sse2_rotate_fetch_pixel (
+				       bits, x1 + 1, y1 + 1, repeat_mode, alpha)));
+	}
+
+	dst[i] = sse2_bilinear_interpolate (
+	    xmm_top, xmm_bottom,
+	    pixman_fixed_to_bilinear_weight (x),
+	    pixman_fixed_to_bilinear_weight (y));
+
+	vx += ux;
+	vy += uy;
+    }
+}
+
+static force_inline void
+sse2_composite_rotate (pixman_implementation_t *imp,
+		       pixman_composite_info_t *info,
+		       pixman_bool_t            bilinear)
+{
+    PIXMAN_COMPOSITE_ARGS (info);
+    pixman_transform_t *transform = src_image->common.transform;
+    uint32_t buffer[ROTATE_TILE_SIZE];
+    uint32_t *dst_line, *dst;
+    pixman_fixed_t ux, uy;
+    pixman_vector_t v;
+    uint32_t alpha;
+    int dst_stride;
+    int tx, ty, y;
+
+    /* reference point is the center of the pixel */
+    v.vector[0] = pixman_int_to_fixed (src_x) + pixman_fixed_1 / 2;
+    v.vector[1] = pixman_int_to_fixed (src_y) + pixman_fixed_1 / 2;
+    v.vector[2] = pixman_fixed_1;
+
+    if (!pixman_transform_point_3d (transform, &v))
+	return;
+
+    ux = transform->matrix[0][0];
+    uy = transform->matrix[1][0];
+
+    alpha = PIXMAN_FORMAT_A (src_image->bits.format)? 0 : 0xff000000;
+
+    PIXMAN_IMAGE_GET_LINE (dest_image, dest_x, dest_y, uint32_t, dst_stride, dst_line, 1);
+
+    for (ty = 0; ty < height; ty += ROTATE_TILE_SIZE)
+    {
+	int th = MIN (ROTATE_TILE_SIZE, height - ty);
+
+	for (tx = 0; tx < width; tx += ROTATE_TILE_SIZE)
+	{
+	    int tw = MIN (ROTATE_TILE_SIZE, width - tx);
+
+	    for (y = ty; y < ty + th; ++y)
+	    {
+		/* The same coordinates as when stepping from the row start */
+		pixman_fixed_t vx = v.vector[0] + tx * ux + y * transform->matrix[0][1];
+		pixman_fixed_t vy = v.vector[1] + tx * uy + y * transform->matrix[1][1];
+
+		dst = dst_line + y * dst_stride + tx;
+
+		if (bilinear)
+		{
+		    sse2_rotate_bilinear_row (op == PIXMAN_OP_SRC ? dst : buffer, tw,
+					      &src_image->bits, vx, vy, ux, uy, alpha);
+		}
+		else
+		{
+		    sse2_rotate_nearest_row (op == PIXMAN_OP_SRC ? dst : buffer, tw,
+					     &src_image->bits, vx, vy, ux, uy, alpha);
+		}
+
+		if (op == PIXMAN_OP_OVER)
+		    core_combine_over_u_sse2_no_mask (dst, buffer, tw);
+	    }
+	}
+    }
+}
+
+static void
+sse2_composite_rotate_nearest_8888_8888 (pixman_implementation_t *imp,
+					 pixman_composite_info_t *info)
+{
+    sse2_composite_rotate (imp, info, FALSE);
+}
+
+static void
+sse2_composite_rotate_bilinear_8888_8888 (pixman_implementation_t *imp,
+					  pixman_composite_info_t *info)
+{
+    sse2_composite_rotate (imp, info, TRUE);
+}
+
+static force_inline void
+scaled_bilinear_scanline_sse2_8888_8_8888_OVER (uint32_t *       dst,
+						const uint8_t  * mask,
+						const uint32_t * src_top,
+						const uint32_t * src_bottom,
+						int32_t          w,
+						int              wt,
+						int              wb,
+						pixman_fixed_t   vx,
+						pixman_fixed_t   unit_x,
+						pixman_fixed_t   max_vx,
+						pixman_bool_t    zero_src)
+{
+    BILINEAR_DECLARE_VARIABLES;
+    uint32_t pix1, pix2, pix3, pix4;
+    uint32_t m;
+
+    while (w && ((uintptr_t)dst & 15))
+    {
+	uint32_t sa;
+
+	m = (uint32_t) *mask++;
+
+	if (m)
+	{
+	    BILINEAR_INTERPOLATE_ONE_PIXEL (pix1);
+	    sa = pix1 >> 24;
+
+	    if (sa == 0xff && m == 0xff)
+	    {
+		*dst = pix1;
+	    }
+	    else
+	    {
+		__m128i ms, md, ma, msa;
+
+		pix2 = *dst;
+		ma = expand_alpha_rev_1x128 (load_32_1x128 (m));
+		ms = unpack_32_1x128 (pix1);
+		md = unpack_32_1x128 (pix2);
+
+		msa = expand_alpha_rev_1x128 (load_32_1x128 (sa));
+
+		*dst = pack_1x128_32 (in_over_1x128 (&ms, &msa, &ma, &md));
+	    }
+	}
+	else
+	{
+	    BILINEAR_SKIP_ONE_PIXEL ();
+	}
+
+	w--;
+	dst++;
+    }
+
+    while (w >= 4)
+    {
+	__m128i xmm_src, xmm_src_lo, xmm_src_hi, xmm_srca_lo, xmm_srca_hi;
+	__m128i xmm_dst, xmm_dst_lo, xmm_dst_hi;
+	__m128i xmm_mask, xmm_mask_lo, xmm_mask_hi;
+
+	m = *(uint32_t*)mask;
+
+	if (m)
+	{
+	    BILINEAR_INTERPOLATE_ONE_PIXEL (pix1);
+	    BILINEAR_INTERPOLATE_ONE_PIXEL (pix2);
+	    BILINEAR_INTERPOLATE_ONE_PIXEL (pix3);
+	    BILINEAR_INTERPOLATE_ONE_PIXEL (pix4);
+
+	    xmm_src = _mm_set_epi32 (pix4, pix3, pix2, pix1);
+
+	    if (m == 0xffffffff && is_opaque (xmm_src))
+	    {
+		save_128_aligned ((__m128i *)dst, xmm_src);
 	    }
 	    else
 	    {
@@ -5941,6 +6681,10 @@ FAST_BILINEAR_MAINLOOP_COMMON (sse2_8888_8_8888_normal_OVER,
 			       scaled_bilinear_scanline_sse2_8888_8_8888_OVER,
 			       uint32_t, uint8_t, uint32_t,
 			       NORMAL, FLAG_HAVE_NON_SOLID_MASK)
+FAST_BILINEAR_MAINLOOP_COMMON (sse2_8888_8_8888_reflect_OVER,
+			       scaled_bilinear_scanline_sse2_8888_8_8888_OVER,
+			       uint32_t, uint8_t, uint32_t,
+			       REFLECT, FLAG_HAVE_NON_SOLID_MASK)
 
 static force_inline void
 scaled_bilinear_scanline_sse2_8888_n_8888_OVER (uint32_t *       dst,
@@ -6056,16 +6800,27 @@ FAST_BILINEAR_MAINLOOP_COMMON (sse2_8888_n_8888_normal_OVER,
 			       scaled_bilinear_scanline_sse2_8888_n_8888_OVER,
 			       uint32_t, uint32_t, uint32_t,
 			       NORMAL, FLAG_HAVE_SOLID_MASK)
+FAST_BILINEAR_MAINLOOP_COMMON (sse2_8888_n_8888_reflect_OVER,
+			       scaled_bilinear_scanline_sse2_8888_n_8888_OVER,
+			       uint32_t, uint32_t, uint32_t,
+			       REFLECT, FLAG_HAVE_SOLID_MASK)
 
 static const pixman_fast_path_t sse2_fast_paths[] =
 {
     /* PIXMAN_OP_OVER */
     PIXMAN_STD_FAST_PATH (OVER, solid, a8, r5g6b5, sse2_composite_over_n_8_0565),
     PIXMAN_STD_FAST_PATH (OVER, solid, a8, b5g6r5, sse2_composite_over_n_8_0565),
-    PIXMAN_STD_FAST_PATH (OVER, solid, null, a8r8g8b8, sse2_composite_over_n_8888),
-    PIXMAN_STD_FAST_PATH (OVER, solid, null, x8r8g8b8, sse2_composite_over_n_8888),
+    PIXMAN_STD_FAST_PATH_BOXES (OVER, solid, null, a8r8g8b8, sse2_composite_over_n_8888,
+				sse2_composite_over_n_8888_boxes),
+    PIXMAN_STD_FAST_PATH_BOXES (OVER, solid, null, x8r8g8b8, sse2_composite_over_n_8888,
+				sse2_composite_over_n_8888_boxes),
+    PIXMAN_STD_FAST_PATH_BOXES (OVER, solid, null, a8b8g8r8, sse2_composite_over_n_8888,
+				sse2_composite_over_n_8888_boxes),
+    PIXMAN_STD_FAST_PATH_BOXES (OVER, solid, null, x8b8g8r8, sse2_composite_over_n_8888,
+				sse2_composite_over_n_8888_boxes),
     PIXMAN_STD_FAST_PATH (OVER, solid, null, r5g6b5, sse2_composite_over_n_0565),
     PIXMAN_STD_FAST_PATH (OVER, solid, null, b5g6r5, sse2_composite_over_n_0565),
+    PIXMAN_STD_FAST_PATH (OVER, solid, null, a8, sse2_composite_over_n_8),
     PIXMAN_STD_FAST_PATH (OVER, a8r8g8b8, null, a8r8g8b8, sse2_composite_over_8888_8888),
     PIXMAN_STD_FAST_PATH (OVER, a8r8g8b8, null, x8r8g8b8, sse2_composite_over_8888_8888),
     PIXMAN_STD_FAST_PATH (OVER, a8b8g8r8, null, a8b8g8r8, sse2_composite_over_8888_8888),
@@ -6118,6 +6873,7 @@ static const pixman_fast_path_t sse2_fast_paths[] =
     PIXMAN_STD_FAST_PATH (ADD, a8r8g8b8, null, a8r8g8b8, sse2_composite_add_8888_8888),
     PIXMAN_STD_FAST_PATH (ADD, a8b8g8r8, null, a8b8g8r8, sse2_composite_add_8888_8888),
     PIXMAN_STD_FAST_PATH (ADD, solid, a8, a8, sse2_composite_add_n_8_8),
+    PIXMAN_STD_FAST_PATH (ADD, solid, a1, a8, sse2_composite_add_n_1_8),
     PIXMAN_STD_FAST_PATH (ADD, solid, null, a8, sse2_composite_add_n_8),
     PIXMAN_STD_FAST_PATH (ADD, solid, null, x8r8g8b8, sse2_composite_add_n_8888),
     PIXMAN_STD_FAST_PATH (ADD, solid, null, a8r8g8b8, sse2_composite_add_n_8888),
@@ -6169,6 +6925,10 @@ static const pixman_fast_path_t sse2_fast_paths[] =
     SIMPLE_NEAREST_FAST_PATH_NORMAL (OVER, a8b8g8r8, x8b8g8r8, sse2_8888_8888),
     SIMPLE_NEAREST_FAST_PATH_NORMAL (OVER, a8r8g8b8, a8r8g8b8, sse2_8888_8888),
     SIMPLE_NEAREST_FAST_PATH_NORMAL (OVER, a8b8g8r8, a8b8g8r8, sse2_8888_8888),
+    SIMPLE_NEAREST_FAST_PATH_REFLECT (OVER, a8r8g8b8, x8r8g8b8, sse2_8888_8888),
+    SIMPLE_NEAREST_FAST_PATH_REFLECT (OVER, a8b8g8r8, x8b8g8r8, sse2_8888_8888),
+    SIMPLE_NEAREST_FAST_PATH_REFLECT (OVER, a8r8g8b8, a8r8g8b8, sse2_8888_8888),
+    SIMPLE_NEAREST_FAST_PATH_REFLECT (OVER, a8b8g8r8, a8b8g8r8, sse2_8888_8888),
 
     SIMPLE_NEAREST_SOLID_MASK_FAST_PATH (OVER, a8r8g8b8, a8r8g8b8, sse2_8888_n_8888),
     SIMPLE_NEAREST_SOLID_MASK_FAST_PATH (OVER, a8b8g8r8, a8b8g8r8, sse2_8888_n_8888),
@@ -6178,29 +6938,86 @@ static const pixman_fast_path_t sse2_fast_paths[] =
     SIMPLE_NEAREST_SOLID_MASK_FAST_PATH_NORMAL (OVER, a8b8g8r8, a8b8g8r8, sse2_8888_n_8888),
     SIMPLE_NEAREST_SOLID_MASK_FAST_PATH_NORMAL (OVER, a8r8g8b8, x8r8g8b8, sse2_8888_n_8888),
     SIMPLE_NEAREST_SOLID_MASK_FAST_PATH_NORMAL (OVER, a8b8g8r8, x8b8g8r8, sse2_8888_n_8888),
-
-    SIMPLE_BILINEAR_FAST_PATH (SRC, a8r8g8b8, a8r8g8b8, sse2_8888_8888),
-    SIMPLE_BILINEAR_FAST_PATH (SRC, a8r8g8b8, x8r8g8b8, sse2_8888_8888),
-    SIMPLE_BILINEAR_FAST_PATH (SRC, x8r8g8b8, x8r8g8b8, sse2_8888_8888),
-    SIMPLE_BILINEAR_FAST_PATH (SRC, a8b8g8r8, a8b8g8r8, sse2_8888_8888),
-    SIMPLE_BILINEAR_FAST_PATH (SRC, a8b8g8r8, x8b8g8r8, sse2_8888_8888),
-    SIMPLE_BILINEAR_FAST_PATH (SRC, x8b8g8r8, x8b8g8r8, sse2_8888_8888),
-
-    SIMPLE_BILINEAR_FAST_PATH (OVER, a8r8g8b8, x8r8g8b8, sse2_8888_8888),
-    SIMPLE_BILINEAR_FAST_PATH (OVER, a8b8g8r8, x8b8g8r8, sse2_8888_8888),
-    SIMPLE_BILINEAR_FAST_PATH (OVER, a8r8g8b8, a8r8g8b8, sse2_8888_8888),
-    SIMPLE_BILINEAR_FAST_PATH (OVER, a8b8g8r8, a8b8g8r8, sse2_8888_8888),
+    SIMPLE_NEAREST_SOLID_MASK_FAST_PATH_REFLECT (OVER, a8r8g8b8, a8r8g8b8, sse2_8888_n_8888),
+    SIMPLE_NEAREST_SOLID_MASK_FAST_PATH_REFLECT (OVER, a8b8g8r8, a8b8g8r8, sse2_8888_n_8888),
+    SIMPLE_NEAREST_SOLID_MASK_FAST_PATH_REFLECT (OVER, a8r8g8b8, x8r8g8b8, sse2_8888_n_8888),
+    SIMPLE_NEAREST_SOLID_MASK_FAST_PATH_REFLECT (OVER, a8b8g8r8, x8b8g8r8, sse2_8888_n_8888),
+
+    SIMPLE_BILINEAR_FAST_PATH (SRC, a8r8g8b8, a8r8g8b8, sse2_8888_8888_upscale),
+    SIMPLE_BILINEAR_FAST_PATH (SRC, a8r8g8b8, x8r8g8b8, sse2_8888_8888_upscale),
+    SIMPLE_BILINEAR_FAST_PATH (SRC, x8r8g8b8, x8r8g8b8, sse2_8888_8888_upscale),
+    SIMPLE_BILINEAR_FAST_PATH (SRC, a8b8g8r8, a8b8g8r8, sse2_8888_8888_upscale),
+    SIMPLE_BILINEAR_FAST_PATH (SRC, a8b8g8r8, x8b8g8r8, sse2_8888_8888_upscale),
+    SIMPLE_BILINEAR_FAST_PATH (SRC, x8b8g8r8, x8b8g8r8, sse2_8888_8888_upscale),
+
+    SIMPLE_BILINEAR_FAST_PATH (OVER, a8r8g8b8, x8r8g8b8, sse2_8888_8888_upscale),
+    SIMPLE_BILINEAR_FAST_PATH (OVER, a8b8g8r8, x8b8g8r8, sse2_8888_8888_upscale),
+    SIMPLE_BILINEAR_FAST_PATH (OVER, a8r8g8b8, a8r8g8b8, sse2_8888_8888_upscale),
+    SIMPLE_BILINEAR_FAST_PATH (OVER, a8b8g8r8, a8b8g8r8, sse2_8888_8888_upscale),
+
+    SIMPLE_BILINEAR_FAST_PATH_REFLECT (SRC, a8r8g8b8, a8r8g8b8, sse2_8888_8888_upscale),
+    SIMPLE_BILINEAR_FAST_PATH_REFLECT (SRC, a8r8g8b8, x8r8g8b8, sse2_8888_8888_upscale),
+    SIMPLE_BILINEAR_FAST_PATH_REFLECT (SRC, x8r8g8b8, x8r8g8b8, sse2_8888_8888_upscale),
+    SIMPLE_BILINEAR_FAST_PATH_REFLECT (SRC, a8b8g8r8, a8b8g8r8, sse2_8888_8888_upscale),
+    SIMPLE_BILINEAR_FAST_PATH_REFLECT (SRC, a8b8g8r8, x8b8g8r8, sse2_8888_8888_upscale),
+    SIMPLE_BILINEAR_FAST_PATH_REFLECT (SRC, x8b8g8r8, x8b8g8r8, sse2_8888_8888_upscale),
+    SIMPLE_BILINEAR_FAST_PATH_REFLECT (OVER, a8r8g8b8, x8r8g8b8, sse2_8888_8888_upscale),
+    SIMPLE_BILINEAR_FAST_PATH_REFLECT (OVER, a8b8g8r8, x8b8g8r8, sse2_8888_8888_upscale),
+    SIMPLE_BILINEAR_FAST_PATH_REFLECT (OVER, a8r8g8b8, a8r8g8b8, sse2_8888_8888_upscale),
+    SIMPLE_BILINEAR_FAST_PATH_REFLECT (OVER, a8b8g8r8, a8b8g8r8, sse2_8888_8888_upscale),
 
     SIMPLE_BILINEAR_SOLID_MASK_FAST_PATH (OVER, a8r8g8b8, x8r8g8b8, sse2_8888_n_8888),
     SIMPLE_BILINEAR_SOLID_MASK_FAST_PATH (OVER, a8b8g8r8, x8b8g8r8, sse2_8888_n_8888),
     SIMPLE_BILINEAR_SOLID_MASK_FAST_PATH (OVER, a8r8g8b8, a8r8g8b8, sse2_8888_n_8888),
     SIMPLE_BILINEAR_SOLID_MASK_FAST_PATH (OVER, a8b8g8r8, a8b8g8r8, sse2_8888_n_8888),
 
+    SIMPLE_BILINEAR_SOLID_MASK_FAST_PATH_REFLECT (OVER, a8r8g8b8, x8r8g8b8, sse2_8888_n_8888),
+    SIMPLE_BILINEAR_SOLID_MASK_FAST_PATH_REFLECT (OVER, a8b8g8r8, x8b8g8r8, sse2_8888_n_8888),
+    SIMPLE_BILINEAR_SOLID_MASK_FAST_PATH_REFLECT (OVER, a8r8g8b8, a8r8g8b8, sse2_8888_n_8888),
+    SIMPLE_BILINEAR_SOLID_MASK_FAST_PATH_REFLECT (OVER, a8b8g8r8, a8b8g8r8, sse2_8888_n_8888),
+
     SIMPLE_BILINEAR_A8_MASK_FAST_PATH (OVER, a8r8g8b8, x8r8g8b8, sse2_8888_8_8888),
     SIMPLE_BILINEAR_A8_MASK_FAST_PATH (OVER, a8b8g8r8, x8b8g8r8, sse2_8888_8_8888),
     SIMPLE_BILINEAR_A8_MASK_FAST_PATH (OVER, a8r8g8b8, a8r8g8b8, sse2_8888_8_8888),
     SIMPLE_BILINEAR_A8_MASK_FAST_PATH (OVER, a8b8g8r8, a8b8g8r8, sse2_8888_8_8888),
 
+    SIMPLE_BILINEAR_A8_MASK_FAST_PATH_REFLECT (OVER, a8r8g8b8, x8r8g8b8, sse2_8888_8_8888),
+    SIMPLE_BILINEAR_A8_MASK_FAST_PATH_REFLECT (OVER, a8b8g8r8, x8b8g8r8, sse2_8888_8_8888),
+    SIMPLE_BILINEAR_A8_MASK_FAST_PATH_REFLECT (OVER, a8r8g8b8, a8r8g8b8, sse2_8888_8_8888),
+    SIMPLE_BILINEAR_A8_MASK_FAST_PATH_REFLECT (OVER, a8b8g8r8, a8b8g8r8, sse2_8888_8_8888),
+
+#define SSE2_ROTATE_FLAGS(filter)					\
+    (FAST_PATH_ROTATE_TRANSFORM		|				\
+     FAST_PATH_ ## filter ## _FILTER	|				\
+     FAST_PATH_STANDARD_FLAGS)
+
+#define SSE2_ROTATE_FAST_PATH(op, s, d)				\
+    {   PIXMAN_OP_ ## op,						\
+	PIXMAN_ ## s, SSE2_ROTATE_FLAGS (NEAREST),			\
+	PIXMAN_null, 0,							\
+	PIXMAN_ ## d, FAST_PATH_STD_DEST_FLAGS,				\
+	sse2_composite_rotate_nearest_8888_8888,			\
+    },									\
+    {   PIXMAN_OP_ ## op,						\
+	PIXMAN_ ## s, SSE2_ROTATE_FLAGS (BILINEAR),			\
+	PIXMAN_null, 0,							\
+	PIXMAN_ ## d, FAST_PATH_STD_DEST_FLAGS,				\
+	sse2_composite_rotate_bilinear_8888_8888,			\
+    }
+
+    SSE2_ROTATE_FAST_PATH (SRC, a8r8g8b8, a8r8g8b8),
+    SSE2_ROTATE_FAST_PATH (SRC, a8r8g8b8, x8r8g8b8),
+    SSE2_ROTATE_FAST_PATH (SRC, x8r8g8b8, x8r8g8b8),
+    SSE2_ROTATE_FAST_PATH (SRC, x8r8g8b8, a8r8g8b8),
+    SSE2_ROTATE_FAST_PATH (SRC, a8b8g8r8, a8b8g8r8),
+    SSE2_ROTATE_FAST_PATH (SRC, a8b8g8r8, x8b8g8r8),
+    SSE2_ROTATE_FAST_PATH (SRC, x8b8g8r8, x8b8g8r8),
+    SSE2_ROTATE_FAST_PATH (SRC, x8b8g8r8, a8b8g8r8),
+    SSE2_ROTATE_FAST_PATH (OVER, a8r8g8b8, a8r8g8b8),
+    SSE2_ROTATE_FAST_PATH (OVER, a8r8g8b8, x8r8g8b8),
+    SSE2_ROTATE_FAST_PATH (OVER, a8b8g8r8, a8b8g8r8),
+    SSE2_ROTATE_FAST_PATH (OVER, a8b8g8r8, x8b8g8r8),
+
     { PIXMAN_OP_NONE },
 };
 
@@ -6332,6 +7149,851 @@ sse2_fetch_a8 (pixman_iter_t *iter, const uint32_t *mask)
     return iter->buffer;
 }
 
+/* Applies @repeat to four gradient positions in 16.16 fixed point and
+ * looks up their colors in @ramp, like gradient_ramp_pixel() in
+ * pixman-gradient-walker.c does. Lanes set in @xmm_outside, or outside
+ * the gradient with PIXMAN_REPEAT_NONE, are transparent.
+ */
+static force_inline __m128i
+sse2_gradient_ramp_lookup (const uint32_t *ramp,
+			   pixman_repeat_t repeat,
+			   __m128i         xmm_x,
+			   __m128i         xmm_outside)
+{
+    __m128i xmm_0xffff = _mm_set1_epi32 (pixman_fixed_1_minus_e);
+    __m128i xmm_0x10000 = _mm_set1_epi32 (pixman_fixed_1);
+    __m128i xmm_m;
+    uint32_t idx[4];
+
+    switch (repeat)
+    {
+    case PIXMAN_REPEAT_NONE:
+	xmm_outside = _mm_or_si128 (
+	    xmm_outside,
+	    _mm_or_si128 (_mm_cmplt_epi32 (xmm_x, _mm_setzero_si128 ()),
+			  _mm_cmpgt_epi32 (xmm_x, xmm_0xffff)));
+	xmm_x = _mm_andnot_si128 (xmm_outside, xmm_x);
+	break;
+
+    case PIXMAN_REPEAT_PAD:
+	xmm_m = _mm_cmplt_epi32 (xmm_x, _mm_setzero_si128 ());
+	xmm_x = _mm_andnot_si128 (xmm_m, xmm_x);
+	xmm_m = _mm_cmpgt_epi32 (xmm_x, xmm_0x10000);
+	xmm_x = _mm_or_si128 (_mm_andnot_si128 (xmm_m, xmm_x),
+			      _mm_and_si128 (xmm_m, xmm_0x10000));
+	break;
+
+    case PIXMAN_REPEAT_NORMAL:
+	xmm_x = _mm_and_si128 (xmm_x, xmm_0xffff);
+	break;
+
+    case PIXMAN_REPEAT_REFLECT:
+	xmm_m = _mm_cmpeq_epi32 (
+	    _mm_and_si128 (xmm_x, xmm_0x10000), xmm_0x10000);
+	xmm_x = _mm_and_si128 (xmm_x, xmm_0xffff);
+	xmm_x = _mm_or_si128 (
+	    _mm_and_si128 (xmm_m, _mm_sub_epi32 (xmm_0x10000, xmm_x)),
+	    _mm_andnot_si128 (xmm_m, xmm_x));
+	break;
+    }
+
+    /* (x * GRADIENT_RAMP_SIZE + pixman_fixed_1 / 2) >> 16 */
+    xmm_x = _mm_srli_epi32 (
+	_mm_add_epi32 (xmm_x, _mm_set1_epi32 (1 << (15 - GRADIENT_RAMP_BITS))),
+	16 - GRADIENT_RAMP_BITS);
+    _mm_storeu_si128 ((__m128i *)idx, xmm_x);
+
+    return _mm_andnot_si128 (
+	xmm_outside,
+	_mm_set_epi32 (ramp[idx[3]], ramp[idx[2]], ramp[idx[1]], ramp[idx[0]]));
+}
+
+/* Converts four gradient positions from double to 32 bits, the way the
+ * walker would see them. With NORMAL and REFLECT repeat, only the low
+ * 17 bits matter, so positions that don't fit are wrapped.
+ */
+static force_inline __m128i
+sse2_gradient_positions (pixman_repeat_t repeat,
+			 __m128d         xmm_t01,
+			 __m128d         xmm_t23)
+{
+    __m128d xmm_max = _mm_set1_pd (1 << 30);
+    __m128d xmm_min = _mm_set1_pd (-(1 << 30));
+
+    if (repeat == PIXMAN_REPEAT_NORMAL || repeat == PIXMAN_REPEAT_REFLECT)
+    {
+	__m128d xmm_big = _mm_or_pd (
+	    _mm_or_pd (_mm_cmpgt_pd (xmm_t01, xmm_max),
+		       _mm_cmplt_pd (xmm_t01, xmm_min)),
+	    _mm_or_pd (_mm_cmpgt_pd (xmm_t23, xmm_max),
+		       _mm_cmplt_pd (xmm_t23, xmm_min)));
+
+	if (_mm_movemask_pd (xmm_big))
+	{
+	    double t[4];
+	    int32_t x[4];
+	    int j;
+
+	    _mm_storeu_pd (t + 0, xmm_t01);
+	    _mm_storeu_pd (t + 2, xmm_t23);
+
+	    for (j = 0; j < 4; ++j)
+	    {
+		if (t[j] > 4611686018427387904.)
+		    t[j] = 4611686018427387904.;
+		else if (t[j] < -4611686018427387904.)
+		    t[j] = -4611686018427387904.;
+
+		x[j] = (int32_t)(pixman_fixed_48_16_t)t[j];
+	    }
+
+	    return _mm_loadu_si128 ((__m128i *)x);
+	}
+    }
+    else
+    {
+	xmm_t01 = _mm_min_pd (_mm_max_pd (xmm_t01, xmm_min), xmm_max);
+	xmm_t23 = _mm_min_pd (_mm_max_pd (xmm_t23, xmm_min), xmm_max);
+    }
+
+    return _mm_unpacklo_epi64 (_mm_cvttpd_epi32 (xmm_t01),
+			       _mm_cvttpd_epi32 (xmm_t23));
+}
+
+/* Packs two masks of double lanes into the 32 bit lanes of one mask */
+static force_inline __m128i
+sse2_gradient_pack_mask (__m128d xmm_m01, __m128d xmm_m23)
+{
+    return _mm_unpacklo_epi64 (
+	_mm_shuffle_epi32 (_mm_castpd_si128 (xmm_m01), _MM_SHUFFLE (2, 0, 2, 0)),
+	_mm_shuffle_epi32 (_mm_castpd_si128 (xmm_m23), _MM_SHUFFLE (2, 0, 2, 0)));
+}
+
+static force_inline void
+sse2_gradient_store (uint32_t *buffer, int n, __m128i xmm_color)
+{
+    if (n >= 4)
+    {
+	save_128_unaligned ((__m128i *)buffer, xmm_color);
+    }
+    else
+    {
+	uint32_t color[4];
+	int j;
+
+	_mm_storeu_si128 ((__m128i *)color, xmm_color);
+
+	for (j = 0; j < n; ++j)
+	    buffer[j] = color[j];
+    }
+}
+
+/* Linear gradients with an affine transformation. Positions along the
+ * gradient are computed for four pixels at a time, the repeat mode is
+ * applied to them with packed integer math, and the colors are looked
+ * up in the gradient ramp. The positions are computed the same way as
+ * in linear_get_scanline_narrow(), so the colors are the same as what
+ * the walker returns with the ramp.
+ */
+static uint32_t *
+sse2_fetch_linear_gradient (pixman_iter_t *iter, const uint32_t *mask)
+{
+    pixman_image_t *image = iter->image;
+    linear_gradient_t *linear = (linear_gradient_t *)image;
+    pixman_repeat_t repeat = image->common.repeat;
+    const uint32_t *ramp = _pixman_gradient_get_ramp (&linear->common, repeat);
+    uint32_t *buffer = iter->buffer;
+    int width = iter->width;
+    pixman_vector_t v, unit;
+    pixman_fixed_32_32_t l, t;
+    pixman_fixed_48_16_t dx, dy;
+    double inc;
+    __m128d xmm_inc, xmm_i01, xmm_i23, xmm_4;
+    __m128i xmm_t;
+    int i;
+
+    /* reference point is the center of the pixel */
+    v.vector[0] = pixman_int_to_fixed (iter->x) + pixman_fixed_1 / 2;
+    v.vector[1] = pixman_int_to_fixed (iter->y) + pixman_fixed_1 / 2;
+    v.vector[2] = pixman_fixed_1;
+
+    iter->y++;
+
+    if (image->common.transform)
+    {
+	if (!pixman_transform_point_3d (image->common.transform, &v))
+	    return buffer;
+
+	unit.vector[0] = image->common.transform->matrix[0][0];
+	unit.vector[1] = image->common.transform->matrix[1][0];
+    }
+    else
+    {
+	unit.vector[0] = pixman_fixed_1;
+	unit.vector[1] = 0;
+    }
+
+    dx = linear->p2.x - linear->p1.x;
+    dy = linear->p2.y - linear->p1.y;
+
+    l = dx * dx + dy * dy;
+
+    if (l == 0 || v.vector[2] == 0)
+    {
+	t = 0;
+	inc = 0;
+    }
+    else
+    {
+	double invden, v2;
+
+	invden = pixman_fixed_1 * (double) pixman_fixed_1 /
+	    (l * (double) v.vector[2]);
+	v2 = v.vector[2] * (1. / pixman_fixed_1);
+	t = ((dx * v.vector[0] + dy * v.vector[1]) -
+	     (dx * linear->p1.x + dy * linear->p1.y) * v2) * invden;
+	inc = (dx * unit.vector[0] + dy * unit.vector[1]) * invden;
+    }
+
+    /* The positions have to fit in 32 bits */
+    if (t < -(1 << 30) || t > (1 << 30)	||
+	fabs (inc * width) > (1 << 30))
+    {
+	pixman_gradient_walker_t walker;
+
+	_pixman_gradient_walker_init (&walker, &linear->common, repeat);
+
+	for (i = 0; i < width; ++i)
+	{
+	    buffer[i] = _pixman_gradient_walker_pixel (
+		&walker, t + (pixman_fixed_32_32_t)(inc * i));
+	}
+
+	return buffer;
+    }
+
+    xmm_inc = _mm_set1_pd (inc);
+    xmm_i01 = _mm_set_pd (1, 0);
+    xmm_i23 = _mm_set_pd (3, 2);
+    xmm_4 = _mm_set1_pd (4);
+    xmm_t = _mm_set1_epi32 ((int32_t)t);
+
+    for (i = 0; i < width; i += 4)
+    {
+	__m128i xmm_x;
+
+	xmm_x = _mm_unpacklo_epi64 (
+	    _mm_cvttpd_epi32 (_mm_mul_pd (xmm_inc, xmm_i01)),
+	    _mm_cvttpd_epi32 (_mm_mul_pd (xmm_inc, xmm_i23)));
+	xmm_x = _mm_add_epi32 (xmm_x, xmm_t);
+
+	xmm_i01 = _mm_add_pd (xmm_i01, xmm_4);
+	xmm_i23 = _mm_add_pd (xmm_i23, xmm_4);
+
+	sse2_gradient_store (buffer + i, width - i,
+			     sse2_gradient_ramp_lookup (
+				 ramp, repeat, xmm_x, _mm_setzero_si128 ()));
+    }
+
+    return buffer;
+}
+
+/* Solves A·t² - 2·B·t + C = 0 for two pixels and returns the root that
+ * radial_compute_color() would pick. Lanes without a valid root are
+ * cleared in @xmm_valid.
+ */
+static force_inline __m128d
+sse2_radial_root (const radial_gradient_t *radial,
+		  pixman_repeat_t          repeat,
+		  __m128d                  xmm_b,
+		  __m128d                  xmm_c,
+		  __m128d                 *xmm_valid)
+{
+    __m128d xmm_zero = _mm_setzero_pd ();
+    __m128d xmm_inva = _mm_set1_pd (radial->inva);
+    __m128d xmm_discr, xmm_sqrt, xmm_t0, xmm_t1, xmm_ok0, xmm_ok1;
+
+    xmm_discr = _mm_sub_pd (_mm_mul_pd (xmm_b, xmm_b),
+			    _mm_mul_pd (_mm_set1_pd (radial->a), xmm_c));
+    xmm_sqrt = _mm_sqrt_pd (_mm_max_pd (xmm_discr, xmm_zero));
+
+    xmm_t0 = _mm_mul_pd (_mm_add_pd (xmm_b, xmm_sqrt), xmm_inva);
+    xmm_t1 = _mm_mul_pd (_mm_sub_pd (xmm_b, xmm_sqrt), xmm_inva);
+
+    if (repeat == PIXMAN_REPEAT_NONE)
+    {
+	__m128d xmm_one = _mm_set1_pd (pixman_fixed_1);
+
+	xmm_ok0 = _mm_and_pd (_mm_cmpge_pd (xmm_t0, xmm_zero),
+			      _mm_cmple_pd (xmm_t0, xmm_one));
+	xmm_ok1 = _mm_and_pd (_mm_cmpge_pd (xmm_t1, xmm_zero),
+			      _mm_cmple_pd (xmm_t1, xmm_one));
+    }
+    else
+    {
+	__m128d xmm_dr = _mm_set1_pd (radial->delta.radius);
+	__m128d xmm_mindr = _mm_set1_pd (radial->mindr);
+
+	xmm_ok0 = _mm_cmpge_pd (_mm_mul_pd (xmm_t0, xmm_dr), xmm_mindr);
+	xmm_ok1 = _mm_cmpge_pd (_mm_mul_pd (xmm_t1, xmm_dr), xmm_mindr);
+    }
+
+    *xmm_valid = _mm_and_pd (_mm_cmpge_pd (xmm_discr, xmm_zero),
+			     _mm_or_pd (xmm_ok0, xmm_ok1));
+
+    return _mm_and_pd (*xmm_valid,
+		       _mm_or_pd (_mm_and_pd (xmm_ok0, xmm_t0),
+				  _mm_andnot_pd (xmm_ok0, xmm_t1)));
+}
+
+static force_inline void
+sse2_radial_store (uint32_t       *buffer,
+		   int             n,
+		   const uint32_t *ramp,
+		   pixman_repeat_t repeat,
+		   __m128d         xmm_t01,
+		   __m128d         xmm_t23,
+		   __m128d         xmm_valid01,
+		   __m128d         xmm_valid23)
+{
+    __m128i xmm_outside = _mm_xor_si128 (
+	sse2_gradient_pack_mask (xmm_valid01, xmm_valid23),
+	_mm_set1_epi32 (-1));
+
+    sse2_gradient_store (
+	buffer, n,
+	sse2_gradient_ramp_lookup (
+	    ramp, repeat,
+	    sse2_gradient_positions (repeat, xmm_t01, xmm_t23),
+	    xmm_outside));
+}
+
+/* Radial gradients with an affine transformation, see
+ * radial_get_scanline_narrow() for the math. B and C are stepped along
+ * the scanline, and the roots are computed for four pixels at a time.
+ * The colors are the same as what the walker returns with the ramp.
+ *
+ * Concentric circles go through the same quadratic. The closed form
+ * t = (|pd| - r₁) / dr rounds differently, which moves pixels across
+ * the edges of the gradient and the seams of the repeat.
+ */
+static uint32_t *
+sse2_fetch_radial_gradient (pixman_iter_t *iter, const uint32_t *mask)
+{
+    pixman_image_t *image = iter->image;
+    radial_gradient_t *radial = (radial_gradient_t *)image;
+    pixman_repeat_t repeat = image->common.repeat;
+    const uint32_t *ramp = _pixman_gradient_get_ramp (&radial->common, repeat);
+    uint32_t *buffer = iter->buffer;
+    int width = iter->width;
+    pixman_vector_t v, unit;
+    pixman_fixed_48_16_t px, py, ux, uy;
+    pixman_fixed_32_32_t b, db, c, dc, ddc;
+    int i;
+
+    /* reference point is the center of the pixel */
+    v.vector[0] = pixman_int_to_fixed (iter->x) + pixman_fixed_1 / 2;
+    v.vector[1] = pixman_int_to_fixed (iter->y) + pixman_fixed_1 / 2;
+    v.vector[2] = pixman_fixed_1;
+
+    iter->y++;
+
+    if (image->common.transform)
+    {
+	if (!pixman_transform_point_3d (image->common.transform, &v))
+	    return buffer;
+
+	unit.vector[0] = image->common.transform->matrix[0][0];
+	unit.vector[1] = image->common.transform->matrix[1][0];
+    }
+    else
+    {
+	unit.vector[0] = pixman_fixed_1;
+	unit.vector[1] = 0;
+    }
+
+    /* warning: this computation may overflow */
+    v.vector[0] -= radial->c1.x;
+    v.vector[1] -= radial->c1.y;
+
+    /* Computed and updated exactly, as in radial_get_scanline_narrow() */
+    px = v.vector[0];
+    py = v.vector[1];
+    ux = unit.vector[0];
+    uy = unit.vector[1];
+
+    b = px * radial->delta.x + py * radial->delta.y +
+	radial->c1.radius * (pixman_fixed_48_16_t) radial->delta.radius;
+    db = ux * radial->delta.x + uy * radial->delta.y;
+
+    c = px * px + py * py -
+	radial->c1.radius * (pixman_fixed_48_16_t) radial->c1.radius;
+    dc = (2 * px + ux) * ux + (2 * py + uy) * uy;
+    ddc = 2 * (ux * ux + uy * uy);
+
+    if (fabs ((double)b) + width * fabs ((double)db) < (1LL << 53) &&
+	fabs ((double)c) + width * (fabs ((double)dc) +
+				    width * fabs ((double)ddc)) < (1LL << 53))
+    {
+	/* B and C stay below 2^53, so stepping them in doubles is
+	 * exact, and all four lanes can be stepped at once.
+	 */
+	__m128d xmm_b01, xmm_b23, xmm_c01, xmm_c23, xmm_dc01, xmm_dc23;
+	__m128d xmm_db, xmm_ddc, xmm_6ddc, xmm_4;
+
+	xmm_b01 = _mm_set_pd (b + db, b);
+	xmm_b23 = _mm_set_pd (b + 3 * db, b + 2 * db);
+	xmm_c01 = _mm_set_pd (c + dc, c);
+	xmm_c23 = _mm_set_pd (c + 3 * dc + 3 * ddc, c + 2 * dc + ddc);
+	xmm_dc01 = _mm_set_pd (dc + ddc, dc);
+	xmm_dc23 = _mm_set_pd (dc + 3 * ddc, dc + 2 * ddc);
+
+	xmm_db = _mm_set1_pd (4 * db);
+	xmm_ddc = _mm_set1_pd (4 * ddc);
+	xmm_6ddc = _mm_set1_pd (6 * ddc);
+	xmm_4 = _mm_set1_pd (4);
+
+	for (i = 0; i < width; i += 4)
+	{
+	    __m128d xmm_t01, xmm_t23, xmm_valid01, xmm_valid23;
+
+	    xmm_t01 = sse2_radial_root (radial, repeat, xmm_b01, xmm_c01, &xmm_valid01);
+	    xmm_t23 = sse2_radial_root (radial, repeat, xmm_b23, xmm_c23, &xmm_valid23);
+
+	    /* B(n + 4) = B(n) + 4 dB
+	     * C(n + 4) = C(n) + 4 dC(n) + 6 ddC
+	     * dC(n + 4) = dC(n) + 4 ddC
+	     */
+	    xmm_b01 = _mm_add_pd (xmm_b01, xmm_db);
+	    xmm_b23 = _mm_add_pd (xmm_b23, xmm_db);
+	    xmm_c01 = _mm_add_pd (
+		xmm_c01, _mm_add_pd (_mm_mul_pd (xmm_4, xmm_dc01), xmm_6ddc));
+	    xmm_c23 = _mm_add_pd (
+		xmm_c23, _mm_add_pd (_mm_mul_pd (xmm_4, xmm_dc23), xmm_6ddc));
+	    xmm_dc01 = _mm_add_pd (xmm_dc01, xmm_ddc);
+	    xmm_dc23 = _mm_add_pd (xmm_dc23, xmm_ddc);
+
+	    sse2_radial_store (buffer + i, width - i, ramp, repeat,
+			       xmm_t01, xmm_t23, xmm_valid01, xmm_valid23);
+	}
+    }
+    else
+    {
+	for (i = 0; i < width; i += 4)
+	{
+	    __m128d xmm_b01, xmm_b23, xmm_c01, xmm_c23;
+	    __m128d xmm_t01, xmm_t23, xmm_valid01, xmm_valid23;
+
+	    xmm_b01 = _mm_set_pd (b + db, b);
+	    xmm_c01 = _mm_set_pd (c + dc, c);
+
+	    b += 2 * db;
+	    c += 2 * dc + ddc;
+	    dc += 2 * ddc;
+
+	    xmm_b23 = _mm_set_pd (b + db, b);
+	    xmm_c23 = _mm_set_pd (c + dc, c);
+
+	    b += 2 * db;
+	    c += 2 * dc + ddc;
+	    dc += 2 * ddc;
+
+	    xmm_t01 = sse2_radial_root (radial, repeat, xmm_b01, xmm_c01, &xmm_valid01);
+	    xmm_t23 = sse2_radial_root (radial, repeat, xmm_b23, xmm_c23, &xmm_valid23);
+
+	    sse2_radial_store (buffer + i, width - i, ramp, repeat,
+			       xmm_t01, xmm_t23, xmm_valid01, xmm_valid23);
+	}
+    }
+
+    return buffer;
+}
+
+/* atan2() for four points, from the approximation of atan() on [0, 1]
+ * in Abramowitz and Stegun 4.4.47, which is off by less than 1e-5.
+ * That is less than 1/600000 of a turn, so the position along a
+ * conical gradient is off by much less than one entry of the ramp.
+ */
+static force_inline __m128
+sse2_atan2 (__m128 xmm_y, __m128 xmm_x)
+{
+    __m128 xmm_sign = _mm_set1_ps (-0.0f);
+    __m128 xmm_ax = _mm_andnot_ps (xmm_sign, xmm_x);
+    __m128 xmm_ay = _mm_andnot_ps (xmm_sign, xmm_y);
+    __m128 xmm_swap = _mm_cmpgt_ps (xmm_ay, xmm_ax);
+    __m128 xmm_a, xmm_s, xmm_r, xmm_m;
+
+    xmm_a = _mm_div_ps (_mm_min_ps (xmm_ax, xmm_ay),
+			_mm_max_ps (_mm_max_ps (xmm_ax, xmm_ay),
+				    _mm_set1_ps (FLT_MIN)));
+    xmm_s = _mm_mul_ps (xmm_a, xmm_a);
+
+    xmm_r = _mm_set1_ps (0.0208351f);
+    xmm_r = _mm_add_ps (_mm_mul_ps (xmm_r, xmm_s), _mm_set1_ps (-0.0851330f));
+    xmm_r = _mm_add_ps (_mm_mul_ps (xmm_r, xmm_s), _mm_set1_ps (0.1801410f));
+    xmm_r = _mm_add_ps (_mm_mul_ps (xmm_r, xmm_s), _mm_set1_ps (-0.3302995f));
+    xmm_r = _mm_add_ps (_mm_mul_ps (xmm_r, xmm_s), _mm_set1_ps (0.9998660f));
+    xmm_r = _mm_mul_ps (xmm_r, xmm_a);
+
+    /* atan (y / x) = pi / 2 - atan (x / y) */
+    xmm_r = _mm_or_ps (
+	_mm_and_ps (xmm_swap, _mm_sub_ps (_mm_set1_ps (M_PI / 2), xmm_r)),
+	_mm_andnot_ps (xmm_swap, xmm_r));
+
+    /* Left half-plane */
+    xmm_m = _mm_cmplt_ps (xmm_x, _mm_setzero_ps ());
+    xmm_r = _mm_or_ps (
+	_mm_and_ps (xmm_m, _mm_sub_ps (_mm_set1_ps (M_PI), xmm_r)),
+	_mm_andnot_ps (xmm_m, xmm_r));
+
+    /* Lower half-plane */
+    xmm_m = _mm_and_ps (_mm_cmplt_ps (xmm_y, _mm_setzero_ps ()), xmm_sign);
+
+    return _mm_xor_ps (xmm_r, xmm_m);
+}
+
+/* Conical gradients with an affine transformation. The angles are
+ * computed for four pixels at a time with an approximation of atan2(),
+ * so the colors can be slightly different from the ones of the
+ * generic code. Wide iterators, and images with PIXMAN_FILTER_BEST,
+ * keep using the generic code, which calls atan2().
+ */
+static uint32_t *
+sse2_fetch_conical_gradient (pixman_iter_t *iter, const uint32_t *mask)
+{
+    pixman_image_t *image = iter->image;
+    conical_gradient_t *conical = (conical_gradient_t *)image;
+    pixman_repeat_t repeat = image->common.repeat;
+    const uint32_t *ramp = _pixman_gradient_get_ramp (&conical->common, repeat);
+    uint32_t *buffer = iter->buffer;
+    int width = iter->width;
+    double cx = 1.;
+    double cy = 0.;
+    double rx = iter->x + 0.5;
+    double ry = iter->y + 0.5;
+    __m128 xmm_offx, xmm_offy, xmm_angle, xmm_2pi, xmm_scale;
+    int i;
+
+    iter->y++;
+
+    if (image->common.transform)
+    {
+	pixman_vector_t v;
+
+	/* reference point is the center of the pixel */
+	v.vector[0] = pixman_int_to_fixed (iter->x) + pixman_fixed_1 / 2;
+	v.vector[1] = pixman_int_to_fixed (iter->y - 1) + pixman_fixed_1 / 2;
+	v.vector[2] = pixman_fixed_1;
+
+	if (!pixman_transform_point_3d (image->common.transform, &v))
+	    return buffer;
+
+	cx = image->common.transform->matrix[0][0] / 65536.;
+	cy = image->common.transform->matrix[1][0] / 65536.;
+
+	rx = v.vector[0] / 65536.;
+	ry = v.vector[1] / 65536.;
+    }
+
+    rx -= conical->center.x / 65536.;
+    ry -= conical->center.y / 65536.;
+
+    xmm_offx = _mm_set_ps (3 * cx, 2 * cx, cx, 0);
+    xmm_offy = _mm_set_ps (3 * cy, 2 * cy, cy, 0);
+    xmm_angle = _mm_set1_ps (conical->angle);
+    xmm_2pi = _mm_set1_ps (2 * M_PI);
+    xmm_scale = _mm_set1_ps (pixman_fixed_1 / (2 * M_PI));
+
+    for (i = 0; i < width; i += 4)
+    {
+	__m128 xmm_x, xmm_y, xmm_t;
+	__m128i xmm_pos;
+
+	xmm_x = _mm_add_ps (_mm_set1_ps (rx + i * cx), xmm_offx);
+	xmm_y = _mm_add_ps (_mm_set1_ps (ry + i * cy), xmm_offy);
+
+	/* As in coordinates_to_parameter(), t is brought into
+	 * [0, 2 pi) and then scaled to [0, 1] with the rotation CCW.
+	 */
+	xmm_t = _mm_add_ps (sse2_atan2 (xmm_y, xmm_x), xmm_angle);
+	xmm_t = _mm_add_ps (
+	    xmm_t, _mm_and_ps (_mm_cmplt_ps (xmm_t, _mm_setzero_ps ()), xmm_2pi));
+	xmm_t = _mm_sub_ps (
+	    xmm_t, _mm_and_ps (_mm_cmpge_ps (xmm_t, xmm_2pi), xmm_2pi));
+
+	xmm_pos = _mm_cvttps_epi32 (
+	    _mm_sub_ps (_mm_set1_ps (pixman_fixed_1), _mm_mul_ps (xmm_t, xmm_scale)));
+
+	sse2_gradient_store (buffer + i, width - i,
+			     sse2_gradient_ramp_lookup (ramp, repeat, xmm_pos,
+							_mm_setzero_si128 ()));
+    }
+
+    return buffer;
+}
+
+/* Separable convolution filters on a8r8g8b8 and x8r8g8b8 images with an
+ * affine transformation. For each pixel, the horizontal taps are applied
+ * to every row, two pixels at a time with _mm_madd_epi16(), and the row
+ * sums are then combined with the vertical taps in the same way. For
+ * this, the filter coefficients are reduced to 14 fractional bits and
+ * the row sums to 6 fractional bits, so the result may be off by one
+ * from what the generic code computes.
+ */
+#define CONVOLUTION_MAX_TAPS	256
+#define CONVOLUTION_MAX_PAIRS	2048
+
+static pixman_bool_t
+sse2_separable_convolution_supported (const pixman_fixed_t *params)
+{
+    int cwidth = pixman_fixed_to_int (params[0]);
+    int cheight = pixman_fixed_to_int (params[1]);
+    int x_phase_bits = pixman_fixed_to_int (params[2]);
+    int y_phase_bits = pixman_fixed_to_int (params[3]);
+    int n, i;
+
+    if (x_phase_bits > 12 || y_phase_bits > 12)
+	return FALSE;
+
+    if (((cwidth + 3) & ~3) > CONVOLUTION_MAX_TAPS			||
+	(1 << x_phase_bits) * ((cwidth + 3) & ~3) / 2 > CONVOLUTION_MAX_PAIRS	||
+	(1 << y_phase_bits) * ((cheight + 1) & ~1) / 2 > CONVOLUTION_MAX_PAIRS)
+    {
+	return FALSE;
+    }
+
+    n = (1 << x_phase_bits) * cwidth + (1 << y_phase_bits) * cheight;
+
+    /* The coefficients must fit in 16 bits with 14 fractional bits */
+    for (i = 0; i < n; ++i)
+    {
+	if (params[4 + i] < -0x1fff0 || params[4 + i] > 0x1fff0)
+	    return FALSE;
+    }
+
+    return TRUE;
+}
+
+/* With a scale transformation, the generic code applies the horizontal
+ * and the vertical taps in separate passes, which is faster than this
+ * fetcher once the kernels have more than a few taps.
+ */
+static pixman_bool_t
+sse2_separable_convolution_prefer_two_pass (pixman_iter_t *iter)
+{
+    pixman_fixed_t *params = iter->image->common.filter_params;
+
+    return (iter->image_flags & FAST_PATH_SCALE_TRANSFORM)	&&
+	iter->height > 1					&&
+	pixman_fixed_to_int (params[0]) * pixman_fixed_to_int (params[1]) > 36;
+}
+
+/* Converts n coefficients for each phase to pairs of 16 bit values,
+ * padded with zeros to a multiple of 2 * n_pairs coefficients.
+ */
+static void
+sse2_convolution_coefficient_pairs (uint32_t             *pairs,
+				    const pixman_fixed_t *coeffs,
+				    int                   n_phases,
+				    int                   n,
+				    int                   n_pairs)
+{
+    int p, i;
+
+    for (p = 0; p < n_phases; ++p)
+    {
+	for (i = 0; i < n_pairs; ++i)
+	{
+	    int16_t c0 = 0, c1 = 0;
+
+	    if (2 * i < n)
+		c0 = (coeffs[2 * i] + 2) >> 2;
+	    if (2 * i + 1 < n)
+		c1 = (coeffs[2 * i + 1] + 2) >> 2;
+
+	    *pairs++ = (uint16_t)c0 | ((uint32_t)(uint16_t)c1 << 16);
+	}
+
+	coeffs += n;
+    }
+}
+
+/* Applies the horizontal taps to row y, starting at x1. The result
+ * has the four channel sums in 32 bit lanes, with 14 fractional bits.
+ */
+static force_inline __m128i
+sse2_convolve_row (bits_image_t    *bits,
+		   pixman_repeat_t  repeat_mode,
+		   int              x1,
+		   int              y,
+		   int              n_taps,
+		   const uint32_t  *pairs,
+		   uint32_t         alpha,
+		   uint32_t        *taps)
+{
+    const uint32_t *row;
+    __m128i xmm_alpha = _mm_set1_epi32 (alpha);
+    __m128i xmm_sum = _mm_setzero_si128 ();
+    int j;
+
+    if (!repeat (repeat_mode, &y, bits->height))
+	return xmm_sum;
+
+    row = bits->bits + bits->rowstride * y;
+
+    if (x1 >= 0 && x1 + n_taps <= bits->width)
+    {
+	row += x1;
+    }
+    else
+    {
+	for (j = 0; j < n_taps; ++j)
+	{
+	    int x = x1 + j;
+
+	    if (repeat (repeat_mode, &x, bits->width))
+		taps[j] = row[x] | alpha;
+	    else
+		taps[j] = 0;
+	}
+
+	row = taps;
+	xmm_alpha = _mm_setzero_si128 ();
+    }
+
+    for (j = 0; j < n_taps; j += 4)
+    {
+	__m128i xmm_p;
+
+	xmm_p = _mm_or_si128 (load_128_unaligned ((__m128i *)(row + j)), xmm_alpha);
+
+	/* Interleave the channels of pixels 0, 1 and of pixels 2, 3 */
+	xmm_p = _mm_shuffle_epi32 (xmm_p, _MM_SHUFFLE (3, 1, 2, 0));
+	xmm_p = _mm_unpacklo_epi8 (xmm_p, _mm_srli_si128 (xmm_p, 8));
+
+	xmm_sum = _mm_add_epi32 (
+	    xmm_sum, _mm_madd_epi16 (_mm_unpacklo_epi8 (xmm_p, _mm_setzero_si128 ()),
+				     _mm_set1_epi32 (pairs[j / 2])));
+	xmm_sum = _mm_add_epi32 (
+	    xmm_sum, _mm_madd_epi16 (_mm_unpackhi_epi8 (xmm_p, _mm_setzero_si128 ()),
+				     _mm_set1_epi32 (pairs[j / 2 + 1])));
+    }
+
+    /* Down to 6 fractional bits */
+    return _mm_srai_epi32 (_mm_add_epi32 (xmm_sum, _mm_set1_epi32 (0x80)), 8);
+}
+
+static uint32_t *
+sse2_fetch_separable_convolution (pixman_iter_t *iter, const uint32_t *mask)
+{
+    pixman_image_t *image = iter->image;
+    bits_image_t *bits = &image->bits;
+    pixman_repeat_t repeat_mode = image->common.repeat;
+    pixman_fixed_t *params = image->common.filter_params;
+    int cwidth = pixman_fixed_to_int (params[0]);
+    int cheight = pixman_fixed_to_int (params[1]);
+    int x_off = ((cwidth << 16) - pixman_fixed_1) >> 1;
+    int y_off = ((cheight << 16) - pixman_fixed_1) >> 1;
+    int x_phase_bits = pixman_fixed_to_int (params[2]);
+    int y_phase_bits = pixman_fixed_to_int (params[3]);
+    int x_phase_shift = 16 - x_phase_bits;
+    int y_phase_shift = 16 - y_phase_bits;
+    int x_pairs = ((cwidth + 3) & ~3) / 2;
+    int y_pairs = ((cheight + 1) & ~1) / 2;
+    uint32_t alpha = PIXMAN_FORMAT_A (bits->format) ? 0 : 0xff000000;
+    uint32_t x_coeffs[CONVOLUTION_MAX_PAIRS];
+    uint32_t y_coeffs[CONVOLUTION_MAX_PAIRS];
+    uint32_t taps[CONVOLUTION_MAX_TAPS];
+    uint32_t *buffer = iter->buffer;
+    pixman_fixed_t vx, vy;
+    pixman_fixed_t ux, uy;
+    pixman_vector_t v;
+    int k;
+
+    /* reference point is the center of the pixel */
+    v.vector[0] = pixman_int_to_fixed (iter->x) + pixman_fixed_1 / 2;
+    v.vector[1] = pixman_int_to_fixed (iter->y++) + pixman_fixed_1 / 2;
+    v.vector[2] = pixman_fixed_1;
+
+    if (!pixman_transform_point_3d (image->common.transform, &v))
+	return buffer;
+
+    ux = image->common.transform->matrix[0][0];
+    uy = image->common.transform->matrix[1][0];
+
+    vx = v.vector[0];
+    vy = v.vector[1];
+
+    sse2_convolution_coefficient_pairs (
+	x_coeffs, params + 4, 1 << x_phase_bits, cwidth, x_pairs);
+    sse2_convolution_coefficient_pairs (
+	y_coeffs, params + 4 + (1 << x_phase_bits) * cwidth,
+	1 << y_phase_bits, cheight, y_pairs);
+
+    for (k = 0; k < iter->width; ++k)
+    {
+	const uint32_t *x_params, *y_params;
+	__m128i xmm_sum = _mm_setzero_si128 ();
+	pixman_fixed_t x, y;
+	int32_t x1, y1;
+	int i;
+
+	if (mask && !mask[k])
+	    goto next;
+
+	/* Round to the middle of the closest phase, as the generic code does */
+	x = ((vx >> x_phase_shift) << x_phase_shift) + ((1 << x_phase_shift) >> 1);
+	y = ((vy >> y_phase_shift) << y_phase_shift) + ((1 << y_phase_shift) >> 1);
+
+	x1 = pixman_fixed_to_int (x - pixman_fixed_e - x_off);
+	y1 = pixman_fixed_to_int (y - pixman_fixed_e - y_off);
+
+	x_params = x_coeffs + ((x & 0xffff) >> x_phase_shift) * x_pairs;
+	y_params = y_coeffs + ((y & 0xffff) >> y_phase_shift) * y_pairs;
+
+	for (i = 0; i < y_pairs; ++i)
+	{
+	    uint32_t fy = y_params[i];
+	    __m128i xmm_row0, xmm_row1, xmm_rows;
+
+	    if (!fy)
+		continue;
+
+	    xmm_row0 = xmm_row1 = _mm_setzero_si128 ();
+
+	    if (fy & 0xffff)
+	    {
+		xmm_row0 = sse2_convolve_row (bits, repeat_mode, x1, y1 + 2 * i,
+					      2 * x_pairs, x_params, alpha, taps);
+	    }
+	    if (fy >> 16)
+	    {
+		xmm_row1 = sse2_convolve_row (bits, repeat_mode, x1, y1 + 2 * i + 1,
+					      2 * x_pairs, x_params, alpha, taps);
+	    }
+
+	    /* Interleave the channels of the two rows */
+	    xmm_rows = _mm_packs_epi32 (xmm_row0, xmm_row1);
+	    xmm_rows = _mm_unpacklo_epi16 (xmm_rows, _mm_srli_si128 (xmm_rows, 8));
+
+	    xmm_sum = _mm_add_epi32 (
+		xmm_sum, _mm_madd_epi16 (xmm_rows, _mm_set1_epi32 (fy)));
+	}
+
+	xmm_sum = _mm_srai_epi32 (
+	    _mm_add_epi32 (xmm_sum, _mm_set1_epi32 (1 << 19)), 20);
+	xmm_sum = _mm_packs_epi32 (xmm_sum, xmm_sum);
+
+	buffer[k] = _mm_cvtsi128_si32 (_mm_packus_epi16 (xmm_sum, xmm_sum));
+
+    next:
+	vx += ux;
+	vy += uy;
+    }
+
+    return buffer;
+}
+
 typedef struct
 {
     pixman_format_code_t	format;
@@ -6376,6 +8038,62 @@ sse2_src_iter_init (pixman_implementation_t *imp, pixman_iter_t *iter)
 	}
     }
 
+    if ((iter->iter_flags & ITER_NARROW)			&&
+	image->type == LINEAR					&&
+	_pixman_gradient_get_ramp (&image->gradient, image->common.repeat) &&
+	(!image->common.transform ||
+	 image->common.transform->matrix[2][0] == 0))
+    {
+	/* Horizontal gradients are fetched once by the general code */
+	_pixman_linear_gradient_iter_init (image, iter);
+
+	if (iter->get_scanline != _pixman_iter_get_scanline_noop)
+	    iter->get_scanline = sse2_fetch_linear_gradient;
+
+	return TRUE;
+    }
+
+    if ((iter->iter_flags & ITER_NARROW)			&&
+	image->type == RADIAL					&&
+	image->radial.a != 0					&&
+	_pixman_gradient_get_ramp (&image->gradient, image->common.repeat) &&
+	(!image->common.transform ||
+	 (image->common.transform->matrix[2][0] == 0 &&
+	  image->common.transform->matrix[2][1] == 0 &&
+	  image->common.transform->matrix[2][2] == pixman_fixed_1)))
+    {
+	iter->get_scanline = sse2_fetch_radial_gradient;
+	return TRUE;
+    }
+
+    if ((iter->iter_flags & ITER_NARROW)			&&
+	image->type == CONICAL					&&
+	_pixman_gradient_get_ramp (&image->gradient, image->common.repeat) &&
+	(!image->common.transform ||
+	 (image->common.transform->matrix[2][0] == 0 &&
+	  image->common.transform->matrix[2][1] == 0 &&
+	  image->common.transform->matrix[2][2] == pixman_fixed_1)))
+    {
+	iter->get_scanline = sse2_fetch_conical_gradient;
+	return TRUE;
+    }
+
+#define CONVOLUTION_FLAGS						\
+    (FAST_PATH_NO_ALPHA_MAP | FAST_PATH_NO_ACCESSORS |			\
+     FAST_PATH_HAS_TRANSFORM | FAST_PATH_AFFINE_TRANSFORM |		\
+     FAST_PATH_SEPARABLE_CONVOLUTION_FILTER)
+
+    if ((iter->iter_flags & ITER_NARROW)			&&
+	(iter->image_flags & CONVOLUTION_FLAGS) == CONVOLUTION_FLAGS &&
+	(image->common.extended_format_code == PIXMAN_a8r8g8b8 ||
+	 image->common.extended_format_code == PIXMAN_x8r8g8b8) &&
+	sse2_separable_convolution_supported (image->common.filter_params) &&
+	!sse2_separable_convolution_prefer_two_pass (iter))
+    {
+	iter->get_scanline = sse2_fetch_separable_convolution;
+	return TRUE;
+    }
+
     return FALSE;
 }
 
@@ -245,6 +245,7 @@ pixman_add_traps (pixman_image_t *     image,
     pixman_fixed_t t, b;
 
     _pixman_image_validate (image);
+    _pixman_bits_image_discard_mipmap (image);
     
     height = image->bits.height;
     bpp = PIXMAN_FORMAT_BPP (image->bits.format);
@@ -323,6 +324,8 @@ pixman_add_trapezoids (pixman_image_t *          image,
 {
     int i;
 
+    _pixman_bits_image_discard_mipmap (image);
+
 #if 0
     dump_image (image, "before");
 #endif
@@ -358,6 +361,7 @@ pixman_rasterize_trapezoid (pixman_image_t *          image,
     return_if_fail (image->type == BITS);
 
     _pixman_image_validate (image);
+    _pixman_bits_image_discard_mipmap (image);
     
     if (!pixman_trapezoid_valid (trap))
 	return;
@@ -504,6 +508,8 @@ pixman_composite_trapezoids (pixman_op_t		op,
 	(mask_format == dst->common.extended_format_code)	&&
 	!(dst->common.have_clip_region))
     {
+	_pixman_bits_image_discard_mipmap (dst);
+
 	for (i = 0; i < n_traps; ++i)
 	{
 	    const pixman_trapezoid_t *trap = &(traps[i]);
@@ -701,6 +707,8 @@ pixman_add_triangles (pixman_image_t          *image,
 {
     pixman_trapezoid_t *traps;
 
+    _pixman_bits_image_discard_mipmap (image);
+
     if ((traps = convert_triangles (n_tris, tris)))
     {
 	pixman_add_trapezoids (image, x_off, y_off,
@@ -27,6 +27,7 @@
 #include <config.h>
 #endif
 #include "pixman-private.h"
+#include "pixman-combine32.h"
 
 #include <stdlib.h>
 
@@ -547,6 +548,184 @@ analyze_extent (pixman_image_t       *image,
     return TRUE;
 }
 
+/* Composites of up to SMALL_COMPOSITE_SIZE pixels in each direction,
+ * such as glyphs and cursors, spend more time on setup than on pixels.
+ * When the destination is clipped to at most one rectangle, the
+ * composite is a single box, and when the source and mask are
+ * untransformed and sampled inside their bounds, the flags that
+ * analyze_extent() would add are known. Those composites skip the
+ * region code.
+ */
+#define SMALL_COMPOSITE_SIZE 16
+
+/* Like analyze_extent() for untransformed images, but returns FALSE
+ * when the general code has to decide.
+ */
+static force_inline pixman_bool_t
+analyze_small_extent (pixman_image_t       *image,
+		      const pixman_box32_t *extents,
+		      uint32_t             *flags)
+{
+    if (!(image->common.flags & FAST_PATH_ID_TRANSFORM)	||
+	image->common.alpha_map					||
+	image->common.have_clip_region)
+    {
+	return FALSE;
+    }
+
+    if (image->common.type == BITS)
+    {
+	if (extents->x1 < 0					||
+	    extents->y1 < 0					||
+	    extents->x2 > image->bits.width			||
+	    extents->y2 > image->bits.height			||
+	    image->bits.width >= 0x7fff				||
+	    image->bits.height >= 0x7fff)
+	{
+	    return FALSE;
+	}
+
+	*flags |= FAST_PATH_SAMPLES_COVER_CLIP_NEAREST;
+    }
+    else if (!IS_16BIT (extents->x1 - 1)		||
+	     !IS_16BIT (extents->y1 - 1)		||
+	     !IS_16BIT (extents->x2 + 1)		||
+	     !IS_16BIT (extents->y2 + 1))
+    {
+	return FALSE;
+    }
+
+    if ((*flags & (FAST_PATH_SAMPLES_OPAQUE |
+		   FAST_PATH_NEAREST_FILTER |
+		   FAST_PATH_SAMPLES_COVER_CLIP_NEAREST)) ==
+	(FAST_PATH_SAMPLES_OPAQUE |
+	 FAST_PATH_NEAREST_FILTER |
+	 FAST_PATH_SAMPLES_COVER_CLIP_NEAREST))
+    {
+	*flags |= FAST_PATH_IS_OPAQUE;
+    }
+
+    return TRUE;
+}
+
+static pixman_bool_t
+composite_small (pixman_op_t      op,
+		 pixman_image_t * src,
+		 pixman_image_t * mask,
+		 pixman_image_t * dest,
+		 int32_t          src_x,
+		 int32_t          src_y,
+		 int32_t          mask_x,
+		 int32_t          mask_y,
+		 int32_t          dest_x,
+		 int32_t          dest_y,
+		 int32_t          width,
+		 int32_t          height)
+{
+    pixman_format_code_t mask_format;
+    pixman_implementation_t *imp;
+    pixman_composite_func_t func;
+    pixman_composite_info_t info;
+    pixman_box32_t box, extents;
+
+    if (dest->common.alpha_map					||
+	(dest->common.have_clip_region && dest->common.clip_region.data))
+    {
+	return FALSE;
+    }
+
+    /* pixbufs */
+    if (mask && mask->type == BITS && src->type == BITS &&
+	mask->bits.bits == src->bits.bits)
+    {
+	return FALSE;
+    }
+
+    _pixman_bits_image_discard_mipmap (dest);
+
+    _pixman_image_validate (src);
+    if (mask)
+	_pixman_image_validate (mask);
+    _pixman_image_validate (dest);
+
+    box.x1 = MAX (dest_x, 0);
+    box.y1 = MAX (dest_y, 0);
+    box.x2 = MIN (dest_x + width, dest->bits.width);
+    box.y2 = MIN (dest_y + height, dest->bits.height);
+
+    if (dest->common.have_clip_region)
+    {
+	const pixman_box32_t *clip = &dest->common.clip_region.extents;
+
+	box.x1 = MAX (box.x1, clip->x1);
+	box.y1 = MAX (box.y1, clip->y1);
+	box.x2 = MIN (box.x2, clip->x2);
+	box.y2 = MIN (box.y2, clip->y2);
+    }
+
+    if (box.x1 >= box.x2 || box.y1 >= box.y2)
+	return TRUE;
+
+    info.src_flags = src->common.flags;
+
+    extents.x1 = box.x1 + src_x - dest_x;
+    extents.y1 = box.y1 + src_y - dest_y;
+    extents.x2 = box.x2 + src_x - dest_x;
+    extents.y2 = box.y2 + src_y - dest_y;
+
+    if (!analyze_small_extent (src, &extents, &info.src_flags))
+	return FALSE;
+
+    if (mask && !(mask->common.flags & FAST_PATH_IS_OPAQUE))
+    {
+	mask_format = mask->common.extended_format_code;
+	info.mask_flags = mask->common.flags;
+    }
+    else
+    {
+	mask_format = PIXMAN_null;
+	info.mask_flags = FAST_PATH_IS_OPAQUE;
+    }
+
+    if (mask)
+    {
+	extents.x1 = box.x1 + mask_x - dest_x;
+	extents.y1 = box.y1 + mask_y - dest_y;
+	extents.x2 = box.x2 + mask_x - dest_x;
+	extents.y2 = box.y2 + mask_y - dest_y;
+
+	if (!analyze_small_extent (mask, &extents, &info.mask_flags))
+	    return FALSE;
+    }
+
+    info.dest_flags = dest->common.flags;
+
+    info.op = optimize_operator (op, info.src_flags, info.mask_flags, info.dest_flags);
+
+    _pixman_implementation_lookup_composite (
+	get_implementation (), info.op,
+	src->common.extended_format_code, info.src_flags,
+	mask_format, info.mask_flags,
+	dest->common.extended_format_code, info.dest_flags,
+	&imp, &func, NULL);
+
+    info.src_image = src;
+    info.mask_image = mask;
+    info.dest_image = dest;
+    info.src_x = box.x1 + src_x - dest_x;
+    info.src_y = box.y1 + src_y - dest_y;
+    info.mask_x = box.x1 + mask_x - dest_x;
+    info.mask_y = box.y1 + mask_y - dest_y;
+    info.dest_x = box.x1;
+    info.dest_y = box.y1;
+    info.width = box.x2 - box.x1;
+    info.height = box.y2 - box.y1;
+
+    func (imp, &info);
+
+    return TRUE;
+}
+
 /*
  * Work around GCC bug causing crashes in Mozilla with SSE2
  *
@@ -585,10 +764,34 @@ pixman_image_composite32 (pixman_op_t      op,
     pixman_box32_t extents;
     pixman_implementation_t *imp;
     pixman_composite_func_t func;
+    pixman_composite_boxes_func_t boxes_func;
     pixman_composite_info_t info;
     const pixman_box32_t *pbox;
+    pixman_image_t src_level, mask_level;
+    pixman_transform_t src_level_transform, mask_level_transform;
     int n;
 
+    if (width <= SMALL_COMPOSITE_SIZE && height <= SMALL_COMPOSITE_SIZE &&
+	composite_small (op, src, mask, dest,
+			 src_x, src_y, mask_x, mask_y, dest_x, dest_y,
+			 width, height))
+    {
+	return;
+    }
+
+    _pixman_bits_image_discard_mipmap (dest);
+
+    if (src != dest)
+    {
+	src = _pixman_bits_image_select_mip_level (
+	    src, &src_level, &src_level_transform);
+    }
+    if (mask && mask != dest)
+    {
+	mask = _pixman_bits_image_select_mip_level (
+	    mask, &mask_level, &mask_level_transform);
+    }
+
     _pixman_image_validate (src);
     if (mask)
 	_pixman_image_validate (mask);
@@ -685,7 +888,7 @@ pixman_image_composite32 (pixman_op_t      op,
 	src_format, info.src_flags,
 	mask_format, info.mask_flags,
 	dest_format, info.dest_flags,
-	&imp, &func);
+	&imp, &func, &boxes_func);
 
     info.src_image = src;
     info.mask_image = mask;
@@ -693,6 +896,22 @@ pixman_image_composite32 (pixman_op_t      op,
 
     pbox = pixman_region32_rectangles (&region, &n);
 
+    if (boxes_func && n > 1)
+    {
+	info.src_x = src_x;
+	info.src_y = src_y;
+	info.mask_x = mask_x;
+	info.mask_y = mask_y;
+	info.dest_x = dest_x;
+	info.dest_y = dest_y;
+	info.width = width;
+	info.height = height;
+
+	boxes_func (imp, &info, pbox, n);
+
+	goto out;
+    }
+
     while (n--)
     {
 	info.src_x = pbox->x1 + src_x - dest_x;
@@ -880,11 +1099,10 @@ pixman_image_fill_boxes (pixman_op_t           op,
                          int                   n_boxes,
                          const pixman_box32_t *boxes)
 {
-    pixman_image_t *solid;
     pixman_color_t c;
-    int i;
 
     _pixman_image_validate (dest);
+    _pixman_bits_image_discard_mipmap (dest);
     
     if (color->alpha == 0xffff)
     {
@@ -939,25 +1157,277 @@ pixman_image_fill_boxes (pixman_op_t           op,
         }
     }
 
-    solid = pixman_image_create_solid_fill (color);
-    if (!solid)
-        return FALSE;
+    pixman_image_composite_solid_boxes (op, color, NULL, dest, n_boxes, boxes);
+
+    return TRUE;
+}
+
+/* A solid mask without component alpha multiplies the source by its
+ * alpha, so it can be folded into the color of a solid source. The
+ * product is computed the way the combiners compute it. Destinations
+ * with wide formats keep the mask, since their combiners multiply with
+ * more precision.
+ */
+static pixman_bool_t
+fold_solid_mask (pixman_color_t *color, pixman_image_t *mask, pixman_image_t *dest)
+{
+    uint32_t s, m;
+
+    if (mask->type != SOLID				||
+	mask->common.component_alpha			||
+	mask->common.alpha_map				||
+	mask->common.have_clip_region			||
+	PIXMAN_FORMAT_IS_WIDE (dest->bits.format))
+    {
+	return FALSE;
+    }
+
+    s = color_to_uint32 (color);
+    m = mask->solid.color_32 >> 24;
+
+    UN8x4_MUL_UN8 (s, m);
+
+    color->alpha = (s >> 24) * 0x101;
+    color->red = ((s >> 16) & 0xff) * 0x101;
+    color->green = ((s >> 8) & 0xff) * 0x101;
+    color->blue = (s & 0xff) * 0x101;
+
+    return TRUE;
+}
+
+/* Composites a solid color through an optional mask. The color goes
+ * into an image on the stack, so there is no allocation, and a solid
+ * mask, such as a global opacity, is folded into the color so that the
+ * solid fast paths without a mask are used.
+ */
+PIXMAN_EXPORT void
+pixman_image_composite_solid (pixman_op_t           op,
+			      const pixman_color_t *color,
+			      pixman_image_t *      mask,
+			      pixman_image_t *      dest,
+			      int32_t               mask_x,
+			      int32_t               mask_y,
+			      int32_t               dest_x,
+			      int32_t               dest_y,
+			      int32_t               width,
+			      int32_t               height)
+{
+    pixman_image_t solid;
+    pixman_color_t c = *color;
+
+    if (mask && fold_solid_mask (&c, mask, dest))
+	mask = NULL;
+
+    _pixman_image_init (&solid);
+    _pixman_image_init_solid_fill (&solid, &c);
+
+    pixman_image_composite32 (op, &solid, mask, dest,
+			      0, 0, mask_x, mask_y, dest_x, dest_y,
+			      width, height);
+
+    _pixman_image_fini (&solid);
+}
+
+/* Composites a solid image onto the boxes with a single fast path
+ * lookup. Without a mask and a destination alpha map, the flags don't
+ * depend on the boxes, so each box only has to be clipped. Fast paths
+ * with a box function get the clipped boxes in batches. Returns FALSE
+ * if the boxes have to be composited one by one.
+ */
+#define N_CLIPPED_BOXES 64
+
+static pixman_bool_t
+composite_solid_boxes_no_mask (pixman_op_t           op,
+			       pixman_image_t *      solid,
+			       pixman_image_t *      dest,
+			       int                   n_boxes,
+			       const pixman_box32_t *boxes)
+{
+    pixman_implementation_t *imp;
+    pixman_composite_func_t func;
+    pixman_composite_boxes_func_t boxes_func;
+    pixman_composite_info_t info;
+    pixman_region32_t region;
+    pixman_box32_t clip;
+    pixman_box32_t clipped[N_CLIPPED_BOXES];
+    pixman_bool_t complex_clip = FALSE;
+    int n_clipped = 0;
+    int i;
+
+    /* The boxes must pass the 16 bit checks of analyze_extent() */
+    if (dest->common.alpha_map			||
+	dest->bits.width >= 0x7fff		||
+	dest->bits.height >= 0x7fff)
+    {
+	return FALSE;
+    }
+
+    _pixman_bits_image_discard_mipmap (dest);
+
+    _pixman_image_validate (solid);
+    _pixman_image_validate (dest);
+
+    clip.x1 = 0;
+    clip.y1 = 0;
+    clip.x2 = dest->bits.width;
+    clip.y2 = dest->bits.height;
+
+    if (dest->common.have_clip_region)
+    {
+	const pixman_box32_t *extents =
+	    pixman_region32_extents (&dest->common.clip_region);
+
+	clip.x1 = MAX (clip.x1, extents->x1);
+	clip.y1 = MAX (clip.y1, extents->y1);
+	clip.x2 = MIN (clip.x2, extents->x2);
+	clip.y2 = MIN (clip.y2, extents->y2);
+
+	complex_clip = pixman_region32_n_rects (&dest->common.clip_region) > 1;
+    }
+
+    if (clip.x1 >= clip.x2 || clip.y1 >= clip.y2)
+	return TRUE;
+
+    info.src_flags = solid->common.flags;
+    info.mask_flags = FAST_PATH_IS_OPAQUE;
+    info.dest_flags = dest->common.flags;
+
+    info.op = optimize_operator (op, info.src_flags, info.mask_flags, info.dest_flags);
+
+    _pixman_implementation_lookup_composite (
+	get_implementation (), info.op,
+	solid->common.extended_format_code, info.src_flags,
+	PIXMAN_null, info.mask_flags,
+	dest->common.extended_format_code, info.dest_flags,
+	&imp, &func, &boxes_func);
+
+    info.src_image = solid;
+    info.mask_image = NULL;
+    info.dest_image = dest;
+    info.src_x = 0;
+    info.src_y = 0;
+    info.mask_x = 0;
+    info.mask_y = 0;
+    info.dest_x = 0;
+    info.dest_y = 0;
 
     for (i = 0; i < n_boxes; ++i)
     {
-        const pixman_box32_t *box = &(boxes[i]);
+	pixman_box32_t box;
+
+	box.x1 = MAX (boxes[i].x1, clip.x1);
+	box.y1 = MAX (boxes[i].y1, clip.y1);
+	box.x2 = MIN (boxes[i].x2, clip.x2);
+	box.y2 = MIN (boxes[i].y2, clip.y2);
+
+	if (box.x1 >= box.x2 || box.y1 >= box.y2)
+	    continue;
 
-        pixman_image_composite32 (op, solid, NULL, dest,
-                                  0, 0, 0, 0,
-                                  box->x1, box->y1,
-                                  box->x2 - box->x1, box->y2 - box->y1);
+	if (complex_clip)
+	{
+	    const pixman_box32_t *pbox;
+	    int n;
+
+	    pixman_region32_init_rect (&region, box.x1, box.y1,
+				       box.x2 - box.x1, box.y2 - box.y1);
+
+	    if (pixman_region32_intersect (
+		    &region, &region, &dest->common.clip_region))
+	    {
+		pbox = pixman_region32_rectangles (&region, &n);
+
+		if (boxes_func && n > 1)
+		{
+		    info.dest_x = 0;
+		    info.dest_y = 0;
+
+		    boxes_func (imp, &info, pbox, n);
+
+		    n = 0;
+		}
+
+		while (n--)
+		{
+		    info.dest_x = pbox->x1;
+		    info.dest_y = pbox->y1;
+		    info.width = pbox->x2 - pbox->x1;
+		    info.height = pbox->y2 - pbox->y1;
+
+		    func (imp, &info);
+
+		    pbox++;
+		}
+	    }
+
+	    pixman_region32_fini (&region);
+	}
+	else if (boxes_func)
+	{
+	    clipped[n_clipped++] = box;
+
+	    if (n_clipped == N_CLIPPED_BOXES)
+	    {
+		boxes_func (imp, &info, clipped, n_clipped);
+		n_clipped = 0;
+	    }
+	}
+	else
+	{
+	    info.dest_x = box.x1;
+	    info.dest_y = box.y1;
+	    info.width = box.x2 - box.x1;
+	    info.height = box.y2 - box.y1;
+
+	    func (imp, &info);
+	}
     }
 
-    pixman_image_unref (solid);
+    if (n_clipped)
+	boxes_func (imp, &info, clipped, n_clipped);
 
     return TRUE;
 }
 
+/* Like pixman_image_composite_solid() for each box. The mask has the
+ * same coordinates as the destination.
+ */
+PIXMAN_EXPORT void
+pixman_image_composite_solid_boxes (pixman_op_t           op,
+				    const pixman_color_t *color,
+				    pixman_image_t *      mask,
+				    pixman_image_t *      dest,
+				    int                   n_boxes,
+				    const pixman_box32_t *boxes)
+{
+    pixman_image_t solid;
+    pixman_color_t c = *color;
+    int i;
+
+    if (mask && fold_solid_mask (&c, mask, dest))
+	mask = NULL;
+
+    _pixman_image_init (&solid);
+    _pixman_image_init_solid_fill (&solid, &c);
+
+    if (!mask && composite_solid_boxes_no_mask (op, &solid, dest, n_boxes, boxes))
+    {
+	_pixman_image_fini (&solid);
+	return;
+    }
+
+    for (i = 0; i < n_boxes; ++i)
+    {
+	const pixman_box32_t *box = &(boxes[i]);
+
+	pixman_image_composite32 (op, &solid, mask, dest,
+				  0, 0, box->x1, box->y1,
+				  box->x1, box->y1,
+				  box->x2 - box->x1, box->y2 - box->y1);
+    }
+
+    _pixman_image_fini (&solid);
+}
+
 /**
  * pixman_version:
  *
@@ -786,6 +786,9 @@ pixman_image_t *pixman_image_create_bits_no_clear    (pixman_format_code_t forma
 						      int                  height,
 						      uint32_t *           bits,
 						      int                  rowstride_bytes);
+pixman_image_t *pixman_image_create_bits_aligned     (pixman_format_code_t format,
+						      int                  width,
+						      int                  height);
 
 /* Destructor */
 pixman_image_t *pixman_image_ref                     (pixman_image_t               *image);
@@ -820,6 +823,8 @@ void            pixman_image_set_alpha_map           (pixman_image_t
 void            pixman_image_set_component_alpha     (pixman_image_t               *image,
 						      pixman_bool_t                 component_alpha);
 pixman_bool_t   pixman_image_get_component_alpha     (pixman_image_t               *image);
+void            pixman_image_set_mipmap              (pixman_image_t               *image,
+						      pixman_bool_t                 mipmap);
 void		pixman_image_set_accessors	     (pixman_image_t		   *image,
 						      pixman_read_memory_func_t	    read_func,
 						      pixman_write_memory_func_t    write_func);
@@ -906,6 +911,22 @@ void          pixman_image_composite32        (pixman_op_t        op,
 					       int32_t            dest_y,
 					       int32_t            width,
 					       int32_t            height);
+void          pixman_image_composite_solid    (pixman_op_t           op,
+					       const pixman_color_t *color,
+					       pixman_image_t       *mask,
+					       pixman_image_t       *dest,
+					       int32_t               mask_x,
+					       int32_t               mask_y,
+					       int32_t               dest_x,
+					       int32_t               dest_y,
+					       int32_t               width,
+					       int32_t               height);
+void          pixman_image_composite_solid_boxes (pixman_op_t           op,
+						  const pixman_color_t *color,
+						  pixman_image_t       *mask,
+						  pixman_image_t       *dest,
+						  int                   n_boxes,
+						  const pixman_box32_t *boxes);
 
 /* Executive Summary: This function is a no-op that only exists
  * for historical reasons.
@@ -937,10 +958,29 @@ typedef struct
     const void *glyph;
 } pixman_glyph_t;
 
+typedef struct
+{
+    uint32_t	n_glyphs;
+    uint64_t	n_bytes;
+    uint64_t	n_hits;
+    uint64_t	n_misses;
+    uint64_t	n_evictions;
+    uint64_t	run_n_bytes;
+    uint64_t	n_run_hits;
+    uint64_t	n_run_misses;
+} pixman_glyph_cache_stats_t;
+
 pixman_glyph_cache_t *pixman_glyph_cache_create       (void);
 void                  pixman_glyph_cache_destroy      (pixman_glyph_cache_t *cache);
 void                  pixman_glyph_cache_freeze       (pixman_glyph_cache_t *cache);
 void                  pixman_glyph_cache_thaw         (pixman_glyph_cache_t *cache);
+void                  pixman_glyph_cache_set_limits   (pixman_glyph_cache_t *cache,
+						       uint64_t              high_water_bytes,
+						       uint64_t              low_water_bytes);
+void                  pixman_glyph_cache_get_stats    (pixman_glyph_cache_t *cache,
+						       pixman_glyph_cache_stats_t *stats);
+void                  pixman_glyph_cache_set_run_cache_limit (pixman_glyph_cache_t *cache,
+							      uint64_t              max_bytes);
 const void *          pixman_glyph_cache_lookup       (pixman_glyph_cache_t *cache,
 						       void                 *font_key,
 						       void                 *glyph_key);
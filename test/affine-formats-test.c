@@ -0,0 +1,164 @@
+#include <stdlib.h>
+#include "utils.h"
+
+#define SRC_WIDTH 29
+#define SRC_HEIGHT 19
+#define WIDTH 43
+#define HEIGHT 37
+
+static const pixman_format_code_t formats[] =
+{
+    PIXMAN_a8r8g8b8, PIXMAN_x8r8g8b8, PIXMAN_a8b8g8r8, PIXMAN_x8b8g8r8,
+    PIXMAN_b8g8r8a8, PIXMAN_b8g8r8x8, PIXMAN_r8g8b8a8, PIXMAN_r8g8b8x8,
+    PIXMAN_x14r6g6b6, PIXMAN_r8g8b8, PIXMAN_b8g8r8, PIXMAN_r5g6b5,
+    PIXMAN_b5g6r5, PIXMAN_a1r5g5b5, PIXMAN_x1r5g5b5, PIXMAN_a1b5g5r5,
+    PIXMAN_x1b5g5r5, PIXMAN_a4r4g4b4, PIXMAN_x4r4g4b4, PIXMAN_a4b4g4r4,
+    PIXMAN_x4b4g4r4, PIXMAN_a8, PIXMAN_r3g3b2, PIXMAN_b2g3r3,
+    PIXMAN_a2r2g2b2, PIXMAN_a2b2g2r2, PIXMAN_c8, PIXMAN_g8,
+    PIXMAN_x4c4, PIXMAN_x4g4, PIXMAN_x4a4, PIXMAN_a4,
+    PIXMAN_r1g2b1, PIXMAN_b1g2r1, PIXMAN_a1r1g1b1, PIXMAN_a1b1g1r1,
+    PIXMAN_c4, PIXMAN_g4, PIXMAN_a1, PIXMAN_g1,
+};
+
+static const pixman_repeat_t repeats[] =
+{
+    PIXMAN_REPEAT_NONE,
+    PIXMAN_REPEAT_NORMAL,
+    PIXMAN_REPEAT_PAD,
+    PIXMAN_REPEAT_REFLECT,
+};
+
+static const pixman_filter_t filters[] =
+{
+    PIXMAN_FILTER_NEAREST,
+    PIXMAN_FILTER_BILINEAR,
+    PIXMAN_FILTER_SEPARABLE_CONVOLUTION,
+};
+
+#define RANDOM_ELT(array)						\
+    (array[prng_rand_n (ARRAY_LENGTH (array))])
+
+static pixman_indexed_t rgb_palette[9];
+static pixman_indexed_t y_palette[9];
+
+static void
+on_destroy (pixman_image_t *image, void *data)
+{
+    free (data);
+}
+
+static pixman_image_t *
+make_image (pixman_format_code_t format, int width, int height)
+{
+    int stride = (width * PIXMAN_FORMAT_BPP (format) + 31) / 32 * 4;
+    uint32_t *bits = malloc (stride * height);
+    pixman_image_t *image;
+
+    prng_randmemset (bits, stride * height, 0);
+
+    image = pixman_image_create_bits (format, width, height, bits, stride);
+    pixman_image_set_destroy_function (image, on_destroy, bits);
+
+    if (PIXMAN_FORMAT_TYPE (format) == PIXMAN_TYPE_COLOR)
+	pixman_image_set_indexed (image, &rgb_palette[PIXMAN_FORMAT_BPP (format)]);
+    else if (PIXMAN_FORMAT_TYPE (format) == PIXMAN_TYPE_GRAY)
+	pixman_image_set_indexed (image, &y_palette[PIXMAN_FORMAT_BPP (format)]);
+
+    return image;
+}
+
+static void
+random_transform (pixman_transform_t *transform)
+{
+    struct pixman_f_transform ft;
+    int i;
+
+    pixman_f_transform_init_identity (&ft);
+
+    for (i = 0; i < 2; ++i)
+    {
+	ft.m[i][0] = (prng_rand_n (2001) - 1000) / 500.0;
+	ft.m[i][1] = (prng_rand_n (2001) - 1000) / 500.0;
+	ft.m[i][2] = prng_rand_n (81) - 40;
+    }
+
+    pixman_transform_from_pixman_f_transform (transform, &ft);
+}
+
+static uint32_t
+test_affine_format (int testnum, int verbose)
+{
+    pixman_format_code_t format;
+    pixman_transform_t transform;
+    pixman_image_t *src, *dest;
+    pixman_filter_t filter;
+    pixman_fixed_t *params = NULL;
+    int n_params = 0;
+    uint32_t crc;
+
+    prng_srand (testnum);
+
+    format = RANDOM_ELT (formats);
+    filter = RANDOM_ELT (filters);
+
+    /* The SSE2 separable convolution fetcher for these formats rounds
+     * differently, and separable-convolution-test checks it.
+     */
+    if (filter == PIXMAN_FILTER_SEPARABLE_CONVOLUTION &&
+	(format == PIXMAN_a8r8g8b8 || format == PIXMAN_x8r8g8b8))
+    {
+	filter = PIXMAN_FILTER_BILINEAR;
+    }
+
+    src = make_image (format, SRC_WIDTH, SRC_HEIGHT);
+    dest = make_image (PIXMAN_a8r8g8b8, WIDTH, HEIGHT);
+
+    if (filter == PIXMAN_FILTER_SEPARABLE_CONVOLUTION)
+    {
+	pixman_fixed_t scale_x = pixman_double_to_fixed (0.5 + prng_rand_n (6) / 2.0);
+	pixman_fixed_t scale_y = pixman_double_to_fixed (0.5 + prng_rand_n (6) / 2.0);
+	int x_phase_bits = prng_rand_n (4);
+	int y_phase_bits = prng_rand_n (4);
+
+	params = pixman_filter_create_separable_convolution (
+	    &n_params, scale_x, scale_y,
+	    PIXMAN_KERNEL_LINEAR, PIXMAN_KERNEL_LINEAR,
+	    PIXMAN_KERNEL_BOX, PIXMAN_KERNEL_BOX,
+	    x_phase_bits, y_phase_bits);
+    }
+
+    random_transform (&transform);
+
+    pixman_image_set_filter (src, filter, params, n_params);
+    pixman_image_set_repeat (src, RANDOM_ELT (repeats));
+    pixman_image_set_transform (src, &transform);
+
+    pixman_image_composite32 (PIXMAN_OP_SRC, src, NULL, dest,
+			      0, 0, 0, 0, 0, 0, WIDTH, HEIGHT);
+
+    crc = compute_crc32_for_image (0, dest);
+
+    pixman_image_unref (src);
+    pixman_image_unref (dest);
+    free (params);
+
+    return crc;
+}
+
+int
+main (int argc, const char *argv[])
+{
+    int i;
+
+    prng_srand (0);
+
+    for (i = 1; i <= 8; i *= 2)
+    {
+	initialize_palette (&rgb_palette[i], i, TRUE);
+	initialize_palette (&y_palette[i], i, FALSE);
+    }
+
+    return fuzzer_test_main ("affine-formats", 3000,
+			     0x0BA232D6,
+			     test_affine_format, argc, argv);
+}
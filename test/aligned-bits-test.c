@@ -0,0 +1,184 @@
+/*
+ * Checks that images created by pixman_image_create_bits_aligned() have
+ * cleared, cache line aligned rows, and that composites with them give
+ * the same results as with images that have the usual alignment.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "utils.h"
+
+#define MAX_WIDTH 77
+#define MAX_HEIGHT 13
+#define N_TESTS 2000
+
+static const pixman_format_code_t formats[] =
+{
+    PIXMAN_a8r8g8b8,
+    PIXMAN_x8r8g8b8,
+    PIXMAN_r5g6b5,
+    PIXMAN_a8,
+    PIXMAN_a1,
+};
+
+static const pixman_op_t ops[] =
+{
+    PIXMAN_OP_SRC,
+    PIXMAN_OP_OVER,
+    PIXMAN_OP_ADD,
+};
+
+static pixman_bool_t
+check_layout (pixman_image_t *image)
+{
+    int stride = pixman_image_get_stride (image);
+    int height = pixman_image_get_height (image);
+    uint8_t *bits = (uint8_t *)pixman_image_get_data (image);
+    int i;
+
+    if (((uintptr_t)bits & 63) || (stride & 63))
+	return FALSE;
+
+    if (stride * 8 < pixman_image_get_width (image) *
+	PIXMAN_FORMAT_BPP (pixman_image_get_format (image)))
+    {
+	return FALSE;
+    }
+
+    for (i = 0; i < stride * height; ++i)
+    {
+	if (bits[i])
+	    return FALSE;
+    }
+
+    return TRUE;
+}
+
+/* Copies the pixels of 'image' into a new image of the given format, or
+ * of the same format when it is PIXMAN_null.
+ */
+static pixman_image_t *
+copy_image (pixman_image_t *image, pixman_format_code_t format,
+	    pixman_bool_t aligned)
+{
+    int width = pixman_image_get_width (image);
+    int height = pixman_image_get_height (image);
+    pixman_image_t *copy;
+
+    if (format == PIXMAN_null)
+	format = pixman_image_get_format (image);
+
+    if (aligned)
+	copy = pixman_image_create_bits_aligned (format, width, height);
+    else
+	copy = pixman_image_create_bits (format, width, height, NULL, -1);
+
+    pixman_image_composite32 (PIXMAN_OP_SRC, image, NULL, copy,
+			      0, 0, 0, 0, 0, 0, width, height);
+
+    return copy;
+}
+
+/* Compares the pixels, without the bits that the formats leave unused */
+static pixman_bool_t
+same_pixels (pixman_image_t *a, pixman_image_t *b)
+{
+    pixman_image_t *a8888 = copy_image (a, PIXMAN_a8r8g8b8, FALSE);
+    pixman_image_t *b8888 = copy_image (b, PIXMAN_a8r8g8b8, FALSE);
+    pixman_bool_t result;
+
+    result = memcmp (pixman_image_get_data (a8888),
+		     pixman_image_get_data (b8888),
+		     pixman_image_get_stride (a8888) *
+		     pixman_image_get_height (a8888)) == 0;
+
+    pixman_image_unref (a8888);
+    pixman_image_unref (b8888);
+
+    return result;
+}
+
+int
+main (int argc, char **argv)
+{
+    int n_failures = 0;
+    int i;
+
+    for (i = 0; i < N_TESTS; ++i)
+    {
+	pixman_image_t *src, *dest, *src_a, *dest_a;
+	pixman_format_code_t src_format, dest_format;
+	pixman_op_t op;
+	int width, height, src_x, src_y, dest_x, dest_y;
+	int src_width, src_height, dest_width, dest_height;
+
+	prng_srand (i);
+
+	src_format = formats[prng_rand_n (ARRAY_LENGTH (formats))];
+	dest_format = formats[prng_rand_n (ARRAY_LENGTH (formats))];
+	op = ops[prng_rand_n (ARRAY_LENGTH (ops))];
+
+	src_width = prng_rand_n (MAX_WIDTH) + 1;
+	src_height = prng_rand_n (MAX_HEIGHT) + 1;
+	dest_width = prng_rand_n (MAX_WIDTH) + 1;
+	dest_height = prng_rand_n (MAX_HEIGHT) + 1;
+
+	src_a = pixman_image_create_bits_aligned (
+	    src_format, src_width, src_height);
+	dest_a = pixman_image_create_bits_aligned (
+	    dest_format, dest_width, dest_height);
+
+	if (!check_layout (src_a) || !check_layout (dest_a))
+	{
+	    printf ("test %d: aligned image has the wrong layout\n", i);
+	    n_failures++;
+	}
+
+	/* Fill with random pixels and copy to images with 4 byte strides */
+	prng_randmemset (pixman_image_get_data (src_a),
+			 pixman_image_get_stride (src_a) * src_height, 0);
+	prng_randmemset (pixman_image_get_data (dest_a),
+			 pixman_image_get_stride (dest_a) * dest_height, 0);
+
+	src = copy_image (src_a, PIXMAN_null, FALSE);
+	dest = copy_image (dest_a, PIXMAN_null, FALSE);
+
+	/* Mostly offsets that keep the rows of both images aligned */
+	if (prng_rand_n (4))
+	{
+	    src_x = prng_rand_n (src_width) & ~3;
+	    dest_x = prng_rand_n (dest_width) & ~3;
+	}
+	else
+	{
+	    src_x = prng_rand_n (src_width);
+	    dest_x = prng_rand_n (dest_width);
+	}
+	src_y = prng_rand_n (src_height);
+	dest_y = prng_rand_n (dest_height);
+	width = prng_rand_n (MIN (src_width - src_x, dest_width - dest_x)) + 1;
+	height = prng_rand_n (MIN (src_height - src_y, dest_height - dest_y)) + 1;
+
+	pixman_image_composite32 (op, src, NULL, dest,
+				  src_x, src_y, 0, 0, dest_x, dest_y,
+				  width, height);
+	pixman_image_composite32 (op, src_a, NULL, dest_a,
+				  src_x, src_y, 0, 0, dest_x, dest_y,
+				  width, height);
+
+	if (!same_pixels (dest, dest_a))
+	{
+	    printf ("test %d (%s %s -> %s) differs\n",
+		    i, operator_name (op), format_name (src_format),
+		    format_name (dest_format));
+	    n_failures++;
+	}
+
+	pixman_image_unref (src);
+	pixman_image_unref (dest);
+	pixman_image_unref (src_a);
+	pixman_image_unref (dest_a);
+    }
+
+    return n_failures != 0;
+}
@@ -0,0 +1,128 @@
+#include <stdlib.h>
+#include "utils.h"
+
+#define WIDTH 61
+#define HEIGHT 43
+#define MAX_RECTS 40
+
+static const pixman_format_code_t formats[] =
+{
+    PIXMAN_a8r8g8b8,
+    PIXMAN_x8r8g8b8,
+    PIXMAN_a8b8g8r8,
+    PIXMAN_x8b8g8r8,
+    PIXMAN_r5g6b5,
+    PIXMAN_a8,
+};
+
+static const pixman_op_t ops[] =
+{
+    PIXMAN_OP_SRC,
+    PIXMAN_OP_OVER,
+    PIXMAN_OP_ADD,
+};
+
+#define RANDOM_ELT(array)						\
+    (array[prng_rand_n (ARRAY_LENGTH (array))])
+
+static void
+on_destroy (pixman_image_t *image, void *data)
+{
+    free (data);
+}
+
+static pixman_image_t *
+make_image (void)
+{
+    uint32_t *bits = malloc (WIDTH * HEIGHT * 4);
+    pixman_image_t *image;
+
+    prng_randmemset (bits, WIDTH * HEIGHT * 4, 0);
+
+    image = pixman_image_create_bits (
+	RANDOM_ELT (formats), WIDTH, HEIGHT, bits, WIDTH * 4);
+    pixman_image_set_destroy_function (image, on_destroy, bits);
+
+    return image;
+}
+
+/* Fast paths with a box function composite all rectangles of the
+ * region in one call.
+ */
+static void
+random_region (pixman_region32_t *region)
+{
+    int n = prng_rand_n (MAX_RECTS) + 1;
+
+    pixman_region32_init (region);
+
+    while (n--)
+    {
+	int x = prng_rand_n (WIDTH);
+	int y = prng_rand_n (HEIGHT);
+	int w = prng_rand_n (12) + 1;
+	int h = prng_rand_n (12) + 1;
+
+	pixman_region32_union_rect (region, region, x, y, w, h);
+    }
+}
+
+static uint32_t
+test_composite_boxes (int testnum, int verbose)
+{
+    pixman_image_t *src, *dest;
+    pixman_region32_t region;
+    pixman_op_t op;
+    int src_x, src_y, dest_x, dest_y;
+    uint32_t crc;
+
+    prng_srand (testnum);
+
+    op = RANDOM_ELT (ops);
+
+    if (prng_rand_n (2))
+    {
+	pixman_color_t color;
+
+	color.alpha = prng_rand_n (0x10000);
+	color.red = prng_rand_n (color.alpha + 1);
+	color.green = prng_rand_n (color.alpha + 1);
+	color.blue = prng_rand_n (color.alpha + 1);
+
+	src = pixman_image_create_solid_fill (&color);
+    }
+    else
+    {
+	src = make_image ();
+    }
+
+    dest = make_image ();
+
+    src_x = prng_rand_n (9) - 4;
+    src_y = prng_rand_n (9) - 4;
+    dest_x = prng_rand_n (9) - 4;
+    dest_y = prng_rand_n (9) - 4;
+
+    random_region (&region);
+    pixman_image_set_clip_region32 (dest, &region);
+    pixman_region32_fini (&region);
+
+    pixman_image_composite32 (op, src, NULL, dest,
+			      src_x, src_y, 0, 0, dest_x, dest_y,
+			      WIDTH, HEIGHT);
+
+    crc = compute_crc32_for_image (0, dest);
+
+    pixman_image_unref (src);
+    pixman_image_unref (dest);
+
+    return crc;
+}
+
+int
+main (int argc, const char *argv[])
+{
+    return fuzzer_test_main ("composite-boxes", 3000,
+			     0x5E126ED4,
+			     test_composite_boxes, argc, argv);
+}
@@ -0,0 +1,212 @@
+/*
+ * Checks that pixman_image_composite_solid() and
+ * pixman_image_composite_solid_boxes() give the same results as
+ * compositing with a solid fill image, with and without masks, including
+ * solid masks that are folded into the color, and with clipped
+ * destinations.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "utils.h"
+
+#define WIDTH 41
+#define HEIGHT 23
+#define MAX_BOXES 5
+#define N_TESTS 4000
+
+static const pixman_format_code_t formats[] =
+{
+    PIXMAN_a8r8g8b8,
+    PIXMAN_x8r8g8b8,
+    PIXMAN_r5g6b5,
+    PIXMAN_a8,
+    PIXMAN_a2r10g10b10,
+};
+
+static const pixman_op_t ops[] =
+{
+    PIXMAN_OP_SRC,
+    PIXMAN_OP_OVER,
+    PIXMAN_OP_IN,
+    PIXMAN_OP_OUT_REVERSE,
+    PIXMAN_OP_ADD,
+    PIXMAN_OP_SATURATE,
+    PIXMAN_OP_MULTIPLY,
+    PIXMAN_OP_SCREEN,
+};
+
+static void
+random_color (pixman_color_t *color)
+{
+    color->alpha = prng_rand_n (4) ? prng_rand_n (0x10000) : 0xffff;
+    color->red = prng_rand_n (color->alpha + 1);
+    color->green = prng_rand_n (color->alpha + 1);
+    color->blue = prng_rand_n (color->alpha + 1);
+}
+
+static pixman_image_t *
+random_mask (uint8_t *bits)
+{
+    pixman_image_t *mask;
+    pixman_color_t color;
+
+    switch (prng_rand_n (4))
+    {
+    case 0:
+	return NULL;
+
+    case 1:
+	return pixman_image_create_bits (
+	    PIXMAN_a8, WIDTH, HEIGHT, (uint32_t *)bits, WIDTH);
+
+    default:
+	/* A global opacity, sometimes with component alpha */
+	random_color (&color);
+	color.red = color.green = color.blue = color.alpha;
+	mask = pixman_image_create_solid_fill (&color);
+	pixman_image_set_component_alpha (mask, prng_rand_n (4) == 0);
+	return mask;
+    }
+}
+
+/* One or more rectangles */
+static void
+random_clip (pixman_region32_t *clip)
+{
+    int n = prng_rand_n (3) + 1;
+
+    pixman_region32_init (clip);
+
+    while (n--)
+    {
+	pixman_region32_union_rect (clip, clip,
+				    prng_rand_n (WIDTH), prng_rand_n (HEIGHT),
+				    prng_rand_n (WIDTH), prng_rand_n (HEIGHT));
+    }
+}
+
+static pixman_bool_t
+same_pixels (pixman_format_code_t format, uint32_t *a, uint32_t *b)
+{
+    int i;
+
+    /* The unused channel of x8r8g8b8 is undefined */
+    if (format == PIXMAN_x8r8g8b8)
+    {
+	for (i = 0; i < WIDTH * HEIGHT; ++i)
+	{
+	    a[i] &= 0xffffff;
+	    b[i] &= 0xffffff;
+	}
+    }
+
+    return memcmp (a, b, WIDTH * HEIGHT * 4) == 0;
+}
+
+int
+main (int argc, char **argv)
+{
+    uint32_t *fast, *reference;
+    uint8_t *mask_bits;
+    int n_failures = 0;
+    int i, j;
+
+    fast = malloc (WIDTH * HEIGHT * 4);
+    reference = malloc (WIDTH * HEIGHT * 4);
+    mask_bits = malloc (WIDTH * HEIGHT);
+
+    for (i = 0; i < N_TESTS; ++i)
+    {
+	pixman_image_t *fast_img, *reference_img, *solid, *mask;
+	pixman_box32_t boxes[MAX_BOXES];
+	pixman_format_code_t format;
+	pixman_color_t color;
+	pixman_op_t op;
+	int n_boxes, stride;
+
+	prng_srand (i);
+
+	format = formats[prng_rand_n (ARRAY_LENGTH (formats))];
+	op = ops[prng_rand_n (ARRAY_LENGTH (ops))];
+	stride = (WIDTH * PIXMAN_FORMAT_BPP (format) / 8 + 3) & ~3;
+
+	prng_randmemset (fast, WIDTH * HEIGHT * 4, 0);
+	prng_randmemset (mask_bits, WIDTH * HEIGHT, 0);
+	memcpy (reference, fast, WIDTH * HEIGHT * 4);
+
+	random_color (&color);
+	mask = random_mask (mask_bits);
+
+	fast_img = pixman_image_create_bits (
+	    format, WIDTH, HEIGHT, fast, stride);
+	reference_img = pixman_image_create_bits (
+	    format, WIDTH, HEIGHT, reference, stride);
+	solid = pixman_image_create_solid_fill (&color);
+
+	if (prng_rand_n (2))
+	{
+	    pixman_region32_t clip;
+
+	    random_clip (&clip);
+	    pixman_image_set_clip_region32 (fast_img, &clip);
+	    pixman_image_set_clip_region32 (reference_img, &clip);
+	    pixman_region32_fini (&clip);
+	}
+
+	n_boxes = prng_rand_n (MAX_BOXES) + 1;
+
+	for (j = 0; j < n_boxes; ++j)
+	{
+	    boxes[j].x1 = prng_rand_n (WIDTH + 10) - 5;
+	    boxes[j].y1 = prng_rand_n (HEIGHT + 10) - 5;
+	    boxes[j].x2 = boxes[j].x1 + prng_rand_n (WIDTH);
+	    boxes[j].y2 = boxes[j].y1 + prng_rand_n (HEIGHT);
+	}
+
+	if (prng_rand_n (2))
+	{
+	    pixman_image_composite_solid_boxes (
+		op, &color, mask, fast_img, n_boxes, boxes);
+	}
+	else
+	{
+	    for (j = 0; j < n_boxes; ++j)
+	    {
+		pixman_image_composite_solid (
+		    op, &color, mask, fast_img,
+		    boxes[j].x1, boxes[j].y1, boxes[j].x1, boxes[j].y1,
+		    boxes[j].x2 - boxes[j].x1, boxes[j].y2 - boxes[j].y1);
+	    }
+	}
+
+	for (j = 0; j < n_boxes; ++j)
+	{
+	    pixman_image_composite32 (
+		op, solid, mask, reference_img,
+		0, 0, boxes[j].x1, boxes[j].y1, boxes[j].x1, boxes[j].y1,
+		boxes[j].x2 - boxes[j].x1, boxes[j].y2 - boxes[j].y1);
+	}
+
+	if (!same_pixels (format, fast, reference))
+	{
+	    printf ("test %d (%s %s, %s mask) differs\n",
+		    i, operator_name (op), format_name (format),
+		    !mask ? "no" :
+		    pixman_image_get_width (mask) ? "a8" : "solid");
+	    n_failures++;
+	}
+
+	pixman_image_unref (fast_img);
+	pixman_image_unref (reference_img);
+	pixman_image_unref (solid);
+	if (mask)
+	    pixman_image_unref (mask);
+    }
+
+    free (fast);
+    free (reference);
+    free (mask_bits);
+
+    return n_failures != 0;
+}
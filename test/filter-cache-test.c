@@ -0,0 +1,91 @@
+/*
+ * Checks that separable convolution parameters stay the same when they
+ * come from the filter cache, including after entries were evicted and
+ * when they are created from several threads at once.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "utils.h"
+
+#define N_FILTERS 48
+#define N_ROUNDS 20
+
+typedef struct
+{
+    pixman_fixed_t	scale_x;
+    pixman_fixed_t	scale_y;
+    pixman_kernel_t	reconstruct_x;
+    pixman_kernel_t	reconstruct_y;
+    pixman_kernel_t	sample_x;
+    pixman_kernel_t	sample_y;
+    int			bits_x;
+    int			bits_y;
+    int			n_params;
+    pixman_fixed_t *	params;
+} filter_t;
+
+static pixman_fixed_t *
+create (const filter_t *f, int *n_params)
+{
+    return pixman_filter_create_separable_convolution (
+	n_params, f->scale_x, f->scale_y,
+	f->reconstruct_x, f->reconstruct_y,
+	f->sample_x, f->sample_y, f->bits_x, f->bits_y);
+}
+
+int
+main (int argc, char **argv)
+{
+    filter_t filters[N_FILTERS];
+    int n_failures = 0;
+    int i;
+
+    prng_srand (0);
+
+    for (i = 0; i < N_FILTERS; ++i)
+    {
+	filter_t *f = &filters[i];
+
+	f->scale_x = pixman_double_to_fixed (0.25 + prng_rand_n (32) / 4.0);
+	f->scale_y = prng_rand_n (2) ? -f->scale_x :
+	    pixman_double_to_fixed (0.25 + prng_rand_n (32) / 4.0);
+	f->reconstruct_x = prng_rand_n (PIXMAN_KERNEL_LANCZOS3_STRETCHED + 1);
+	f->reconstruct_y = prng_rand_n (PIXMAN_KERNEL_LANCZOS3_STRETCHED + 1);
+	f->sample_x = prng_rand_n (PIXMAN_KERNEL_LANCZOS3_STRETCHED + 1);
+	f->sample_y = prng_rand_n (PIXMAN_KERNEL_LANCZOS3_STRETCHED + 1);
+	f->bits_x = prng_rand_n (5);
+	f->bits_y = prng_rand_n (5);
+
+	f->params = create (f, &f->n_params);
+    }
+
+#ifdef USE_OPENMP
+#   pragma omp parallel for default(none) shared(filters) reduction(+:n_failures)
+#endif
+    for (i = 0; i < N_FILTERS * N_ROUNDS; ++i)
+    {
+	/* Visit the filters out of order to mix hits and evictions */
+	const filter_t *f = &filters[(i * 7) % N_FILTERS];
+	pixman_fixed_t *params;
+	int n_params;
+
+	params = create (f, &n_params);
+
+	if (n_params != f->n_params ||
+	    memcmp (params, f->params, n_params * sizeof (pixman_fixed_t)) != 0)
+	{
+	    n_failures++;
+	}
+
+	free (params);
+    }
+
+    for (i = 0; i < N_FILTERS; ++i)
+	free (filters[i].params);
+
+    if (n_failures)
+	printf ("%d filters differ from the first ones created\n", n_failures);
+
+    return n_failures != 0;
+}
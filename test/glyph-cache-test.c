@@ -0,0 +1,316 @@
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "utils.h"
+
+#define N_GLYPHS 64
+#define GLYPH_SIZE 16
+#define N_RUNS 10000
+
+#define KEY(i) ((void *)(uintptr_t)((i) + 1))
+
+static void
+composite_run (pixman_glyph_cache_t *cache,
+	       pixman_image_t       *dest,
+	       int                   x,
+	       int                   n_glyphs,
+	       const void          **glyph_ptrs)
+{
+    static const pixman_color_t red = { 0xffff, 0x0000, 0x0000, 0x8000 };
+    pixman_glyph_t glyphs[N_GLYPHS];
+    pixman_image_t *src;
+    int i;
+
+    for (i = 0; i < n_glyphs; ++i)
+    {
+	glyphs[i].glyph = glyph_ptrs[i];
+	glyphs[i].x = x + i * GLYPH_SIZE / 2;
+	glyphs[i].y = GLYPH_SIZE;
+    }
+
+    src = pixman_image_create_solid_fill (&red);
+
+    pixman_composite_glyphs (PIXMAN_OP_OVER, src, dest, PIXMAN_a8,
+			     0, 0, x, 0, x, 0, 8 * GLYPH_SIZE, 2 * GLYPH_SIZE,
+			     cache, n_glyphs, glyphs);
+
+    pixman_image_unref (src);
+}
+
+static void
+test_run_cache (void)
+{
+    pixman_glyph_cache_t *cache;
+    pixman_glyph_cache_stats_t stats;
+    pixman_image_t *images[2], *dest[2];
+    const void *glyphs[8];
+    int i, j;
+
+    prng_srand (0);
+
+    for (i = 0; i < 2; ++i)
+    {
+	images[i] = pixman_image_create_bits (
+	    i? PIXMAN_a8 : PIXMAN_a1, GLYPH_SIZE, GLYPH_SIZE, NULL, -1);
+	prng_randmemset (pixman_image_get_data (images[i]),
+			 GLYPH_SIZE * pixman_image_get_stride (images[i]), 0);
+
+	dest[i] = pixman_image_create_bits (
+	    PIXMAN_a8r8g8b8, 16 * GLYPH_SIZE, 2 * GLYPH_SIZE, NULL, -1);
+    }
+
+    /* dest[0] is rendered with the run cache, dest[1] without */
+    for (i = 0; i < 2; ++i)
+    {
+	cache = pixman_glyph_cache_create ();
+
+	if (i == 0)
+	    pixman_glyph_cache_set_run_cache_limit (cache, 1024 * 1024);
+
+	pixman_glyph_cache_freeze (cache);
+	for (j = 0; j < 8; ++j)
+	{
+	    if (!(glyphs[j] = pixman_glyph_cache_lookup (cache, NULL, KEY (j))))
+	    {
+		glyphs[j] = pixman_glyph_cache_insert (
+		    cache, NULL, KEY (j), 0, GLYPH_SIZE, images[j & 1]);
+	    }
+	}
+
+	composite_run (cache, dest[i], 0, 8, glyphs);
+	composite_run (cache, dest[i], 0, 8, glyphs);
+	composite_run (cache, dest[i], 3 * GLYPH_SIZE, 8, glyphs);
+	composite_run (cache, dest[i], 0, 7, glyphs);
+
+	pixman_glyph_cache_get_stats (cache, &stats);
+	if (i == 0)
+	{
+	    assert (stats.n_run_misses == 2);
+	    assert (stats.n_run_hits == 2);
+	    assert (stats.run_n_bytes > 0);
+	}
+	else
+	{
+	    assert (stats.n_run_misses == 0);
+	    assert (stats.n_run_hits == 0);
+	    assert (stats.run_n_bytes == 0);
+	}
+
+	/* Removing a glyph drops the runs that use it */
+	pixman_glyph_cache_remove (cache, NULL, KEY (7));
+	pixman_glyph_cache_get_stats (cache, &stats);
+	pixman_glyph_cache_thaw (cache);
+
+	if (i == 0)
+	{
+	    uint64_t bytes = stats.run_n_bytes;
+
+	    assert (bytes > 0);
+
+	    pixman_glyph_cache_remove (cache, NULL, KEY (0));
+	    pixman_glyph_cache_get_stats (cache, &stats);
+	    assert (stats.run_n_bytes == 0);
+	}
+
+	pixman_glyph_cache_destroy (cache);
+    }
+
+    assert (memcmp (pixman_image_get_data (dest[0]),
+		    pixman_image_get_data (dest[1]),
+		    2 * GLYPH_SIZE * pixman_image_get_stride (dest[0])) == 0);
+
+    for (i = 0; i < 2; ++i)
+    {
+	pixman_image_unref (images[i]);
+	pixman_image_unref (dest[i]);
+    }
+}
+
+/* More runs than the run table holds. The least recently used runs are
+ * dropped, and the table keeps working through the removals.
+ */
+static void
+test_many_runs (void)
+{
+    static const pixman_color_t white = { 0xffff, 0xffff, 0xffff, 0xffff };
+    pixman_glyph_cache_t *cache;
+    pixman_glyph_cache_stats_t stats;
+    pixman_image_t *image, *src, *dest;
+    pixman_glyph_t glyphs[2];
+    int i;
+
+    image = pixman_image_create_bits (
+	PIXMAN_a8, GLYPH_SIZE, GLYPH_SIZE, NULL, -1);
+    src = pixman_image_create_solid_fill (&white);
+    dest = pixman_image_create_bits (
+	PIXMAN_a8r8g8b8, 4 * GLYPH_SIZE, 4 * GLYPH_SIZE, NULL, -1);
+
+    cache = pixman_glyph_cache_create ();
+    pixman_glyph_cache_set_run_cache_limit (cache, 64 * 1024 * 1024);
+
+    pixman_glyph_cache_freeze (cache);
+    glyphs[0].glyph = pixman_glyph_cache_insert (cache, NULL, KEY (0), 0, 0, image);
+    glyphs[1].glyph = pixman_glyph_cache_insert (cache, NULL, KEY (1), 0, 0, image);
+
+    /* Each run has a different distance between its two glyphs */
+    for (i = 0; i <= N_RUNS; ++i)
+    {
+	glyphs[0].x = glyphs[0].y = 0;
+	glyphs[1].x = (i % N_RUNS) % 100;
+	glyphs[1].y = (i % N_RUNS) / 100;
+
+	pixman_composite_glyphs (PIXMAN_OP_OVER, src, dest, PIXMAN_a8,
+				 0, 0, 0, 0, 0, 0, 4 * GLYPH_SIZE, 4 * GLYPH_SIZE,
+				 cache, 2, glyphs);
+    }
+
+    /* The first run was dropped by the time it was composited again */
+    pixman_glyph_cache_get_stats (cache, &stats);
+    assert (stats.n_run_misses == N_RUNS + 1);
+    assert (stats.n_run_hits == 0);
+
+    /* The last one was not */
+    pixman_composite_glyphs (PIXMAN_OP_OVER, src, dest, PIXMAN_a8,
+			     0, 0, 0, 0, 0, 0, 4 * GLYPH_SIZE, 4 * GLYPH_SIZE,
+			     cache, 2, glyphs);
+    pixman_glyph_cache_get_stats (cache, &stats);
+    assert (stats.n_run_hits == 1);
+
+    /* Every run uses both glyphs */
+    pixman_glyph_cache_remove (cache, NULL, KEY (1));
+    pixman_glyph_cache_get_stats (cache, &stats);
+    assert (stats.run_n_bytes == 0);
+
+    pixman_glyph_cache_thaw (cache);
+    pixman_glyph_cache_destroy (cache);
+
+    pixman_image_unref (image);
+    pixman_image_unref (src);
+    pixman_image_unref (dest);
+}
+
+/* With a byte budget, a frozen cache takes glyphs until its hash table
+ * is full. Glyphs removed while it is frozen leave tombstones, which
+ * must not fill up the last empty slot of the table.
+ */
+static void
+test_full_table (void)
+{
+    pixman_glyph_cache_t *cache;
+    pixman_glyph_cache_stats_t stats;
+    pixman_image_t *image;
+    int i, n;
+
+    image = pixman_image_create_bits (PIXMAN_a8, 1, 1, NULL, -1);
+
+    cache = pixman_glyph_cache_create ();
+    pixman_glyph_cache_set_limits (cache, (uint64_t)1 << 40, (uint64_t)1 << 40);
+
+    pixman_glyph_cache_freeze (cache);
+
+    for (i = 0; i < 30000; ++i)
+	assert (pixman_glyph_cache_insert (cache, NULL, KEY (i), 0, 0, image));
+    for (i = 0; i < 30000; i += 2)
+	pixman_glyph_cache_remove (cache, NULL, KEY (i));
+
+    n = 15000;
+    for (i = 30000; i < 70000; ++i)
+    {
+	assert (!pixman_glyph_cache_lookup (cache, NULL, KEY (i)));
+	if (!pixman_glyph_cache_insert (cache, NULL, KEY (i), 0, 0, image))
+	    break;
+	n++;
+    }
+
+    assert (i < 70000);
+    assert (!pixman_glyph_cache_lookup (cache, NULL, KEY (i)));
+    assert (pixman_glyph_cache_lookup (cache, NULL, KEY (i - 1)));
+
+    pixman_glyph_cache_get_stats (cache, &stats);
+    assert (stats.n_glyphs == n);
+
+    pixman_glyph_cache_thaw (cache);
+    pixman_glyph_cache_destroy (cache);
+    pixman_image_unref (image);
+}
+
+int
+main (int argc, char **argv)
+{
+    pixman_glyph_cache_t *cache;
+    pixman_glyph_cache_stats_t stats;
+    pixman_image_t *image;
+    uint64_t glyph_bytes;
+    int i;
+
+    image = pixman_image_create_bits (
+	PIXMAN_a8, GLYPH_SIZE, GLYPH_SIZE, NULL, -1);
+
+    cache = pixman_glyph_cache_create ();
+
+    pixman_glyph_cache_get_stats (cache, &stats);
+    assert (stats.n_glyphs == 0);
+    assert (stats.n_bytes == 0);
+
+    /* Fill the cache and measure how many bytes a single glyph takes */
+    pixman_glyph_cache_freeze (cache);
+    for (i = 0; i < N_GLYPHS; ++i)
+    {
+	assert (!pixman_glyph_cache_lookup (cache, NULL, KEY (i)));
+	assert (pixman_glyph_cache_insert (cache, NULL, KEY (i), 0, 0, image));
+    }
+    for (i = 0; i < N_GLYPHS; ++i)
+	assert (pixman_glyph_cache_lookup (cache, NULL, KEY (i)));
+    pixman_glyph_cache_thaw (cache);
+
+    pixman_glyph_cache_get_stats (cache, &stats);
+    assert (stats.n_glyphs == N_GLYPHS);
+    assert (stats.n_hits == N_GLYPHS);
+    assert (stats.n_misses == N_GLYPHS);
+    assert (stats.n_evictions == 0);
+    assert (stats.n_bytes >= N_GLYPHS * GLYPH_SIZE * GLYPH_SIZE);
+    assert (stats.n_bytes % N_GLYPHS == 0);
+
+    glyph_bytes = stats.n_bytes / N_GLYPHS;
+
+    /* Nothing should be evicted until the next thaw */
+    pixman_glyph_cache_set_limits (
+	cache, glyph_bytes * N_GLYPHS / 2, glyph_bytes * N_GLYPHS / 4);
+
+    pixman_glyph_cache_get_stats (cache, &stats);
+    assert (stats.n_glyphs == N_GLYPHS);
+
+    pixman_glyph_cache_freeze (cache);
+    pixman_glyph_cache_thaw (cache);
+
+    pixman_glyph_cache_get_stats (cache, &stats);
+    assert (stats.n_glyphs == N_GLYPHS / 4);
+    assert (stats.n_bytes == glyph_bytes * N_GLYPHS / 4);
+    assert (stats.n_evictions == N_GLYPHS - N_GLYPHS / 4);
+
+    /* The least recently inserted glyphs were evicted first */
+    for (i = 0; i < N_GLYPHS; ++i)
+    {
+	const void *glyph = pixman_glyph_cache_lookup (cache, NULL, KEY (i));
+
+	assert ((glyph != NULL) == (i >= N_GLYPHS - N_GLYPHS / 4));
+    }
+
+    pixman_glyph_cache_freeze (cache);
+    pixman_glyph_cache_remove (cache, NULL, KEY (N_GLYPHS - 1));
+    pixman_glyph_cache_thaw (cache);
+
+    pixman_glyph_cache_get_stats (cache, &stats);
+    assert (stats.n_glyphs == N_GLYPHS / 4 - 1);
+    assert (stats.n_bytes == glyph_bytes * (N_GLYPHS / 4 - 1));
+
+    pixman_glyph_cache_destroy (cache);
+    pixman_image_unref (image);
+
+    test_run_cache ();
+    test_many_runs ();
+    test_full_table ();
+
+    return 0;
+}
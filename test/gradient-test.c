@@ -0,0 +1,193 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "utils.h"
+
+#define WIDTH 61
+#define HEIGHT 23
+#define N_TESTS 3000
+
+/* The gradient ramp may be off by half an entry in position. With
+ * stops at least 1/5 apart, that is well below one 8 bit step; the
+ * rest is rounding in the walker and in premultiplication.
+ */
+#define TOLERANCE 4
+
+static const pixman_repeat_t repeats[] =
+{
+    PIXMAN_REPEAT_NONE,
+    PIXMAN_REPEAT_NORMAL,
+    PIXMAN_REPEAT_PAD,
+    PIXMAN_REPEAT_REFLECT,
+};
+
+static const char *type_names[] = { "linear", "radial", "conical" };
+
+static pixman_fixed_t
+random_coord (int range)
+{
+    return pixman_double_to_fixed (((int)prng_rand_n (range * 64) - range * 16) / 32.0);
+}
+
+static pixman_image_t *
+create_gradient (int type)
+{
+    pixman_gradient_stop_t stops[5];
+    pixman_point_fixed_t p1, p2;
+    pixman_fixed_t r1, r2;
+    int n_stops = prng_rand_n (4) + 2;
+    int i;
+
+    for (i = 0; i < n_stops; ++i)
+    {
+	stops[i].x = pixman_fixed_1 * i / (n_stops - 1);
+	if (i > 0 && i < n_stops - 1)
+	    stops[i].x += prng_rand_n (pixman_fixed_1 / 32) - pixman_fixed_1 / 64;
+
+	stops[i].color.alpha = prng_rand ();
+	stops[i].color.red = prng_rand ();
+	stops[i].color.green = prng_rand ();
+	stops[i].color.blue = prng_rand ();
+    }
+
+    p1.x = random_coord (WIDTH);
+    p1.y = random_coord (HEIGHT);
+    p2.x = random_coord (WIDTH);
+    p2.y = random_coord (HEIGHT);
+
+    switch (type)
+    {
+    case 0:
+	/* Vertical gradients have the same color along each row */
+	if (prng_rand_n (4) == 0)
+	    p2.x = p1.x;
+
+	return pixman_image_create_linear_gradient (&p1, &p2, stops, n_stops);
+
+    case 1:
+	/* Concentric circles are a special case. Centered on a pixel, they
+	 * have pixels right on the circles, where rounding decides whether
+	 * the pixel is inside the gradient.
+	 */
+	if (prng_rand_n (4) == 0)
+	{
+	    p1.x = pixman_int_to_fixed (prng_rand_n (WIDTH)) + pixman_fixed_1 / 2;
+	    p1.y = pixman_int_to_fixed (prng_rand_n (HEIGHT)) + pixman_fixed_1 / 2;
+	    p2 = p1;
+	}
+
+	r1 = pixman_int_to_fixed (prng_rand_n (WIDTH / 2));
+	r2 = pixman_int_to_fixed (prng_rand_n (WIDTH));
+
+	return pixman_image_create_radial_gradient (
+	    &p1, &p2, r1, r2, stops, n_stops);
+
+    default:
+	return pixman_image_create_conical_gradient (
+	    &p1, pixman_int_to_fixed (prng_rand_n (360)), stops, n_stops);
+    }
+}
+
+static void
+set_random_transform (pixman_image_t *image)
+{
+    pixman_transform_t transform;
+    double angle, sx, sy;
+
+    if (prng_rand_n (2) == 0)
+	return;
+
+    angle = prng_rand_n (360) * M_PI / 180;
+    sx = 0.5 + prng_rand_n (4);
+    sy = 0.5 + prng_rand_n (4);
+
+    pixman_transform_init_rotate (&transform,
+				  pixman_double_to_fixed (cos (angle)),
+				  pixman_double_to_fixed (sin (angle)));
+    pixman_transform_scale (&transform, NULL,
+			    pixman_double_to_fixed (sx),
+			    pixman_double_to_fixed (sy));
+
+    pixman_image_set_transform (image, &transform);
+}
+
+int
+main (int argc, char **argv)
+{
+    uint32_t *fast, *exact, wide_white = 0xffffffff;
+    pixman_image_t *fast_img, *exact_img, *wide_mask;
+    int n_failures = 0;
+    int i;
+
+    fast = malloc (WIDTH * HEIGHT * 4);
+    exact = malloc (WIDTH * HEIGHT * 4);
+
+    fast_img = pixman_image_create_bits (
+	PIXMAN_a8r8g8b8, WIDTH, HEIGHT, fast, WIDTH * 4);
+    exact_img = pixman_image_create_bits (
+	PIXMAN_a8r8g8b8, WIDTH, HEIGHT, exact, WIDTH * 4);
+
+    /* An opaque mask in a format with more than 8 bits per channel makes
+     * the general code fetch the source through the wide C fetchers,
+     * which expand what the narrow C fetchers return.
+     */
+    wide_mask = pixman_image_create_bits (
+	PIXMAN_a2r10g10b10, 1, 1, &wide_white, 4);
+    pixman_image_set_repeat (wide_mask, PIXMAN_REPEAT_NORMAL);
+
+    for (i = 0; i < N_TESTS; ++i)
+    {
+	int type = i % 3;
+	pixman_repeat_t repeat;
+	pixman_image_t *gradient;
+	int diff;
+
+	prng_srand (i);
+
+	gradient = create_gradient (type);
+	repeat = repeats[prng_rand_n (ARRAY_LENGTH (repeats))];
+
+	pixman_image_set_repeat (gradient, repeat);
+	set_random_transform (gradient);
+
+	pixman_image_composite32 (PIXMAN_OP_SRC, gradient, NULL, fast_img,
+				  0, 0, 0, 0, 0, 0, WIDTH, HEIGHT);
+
+	if (type == 1)
+	{
+	    pixman_image_composite32 (PIXMAN_OP_SRC, gradient, wide_mask,
+				      exact_img, 0, 0, 0, 0, 0, 0, WIDTH, HEIGHT);
+
+	    if (memcmp (fast, exact, WIDTH * HEIGHT * 4) != 0)
+	    {
+		printf ("radial gradient %d (repeat %d) differs from the C code\n",
+			i, repeat);
+		n_failures++;
+	    }
+	}
+
+	pixman_image_set_filter (gradient, PIXMAN_FILTER_BEST, NULL, 0);
+
+	pixman_image_composite32 (PIXMAN_OP_SRC, gradient, NULL, exact_img,
+				  0, 0, 0, 0, 0, 0, WIDTH, HEIGHT);
+
+	diff = max_channel_diff (fast, exact, WIDTH * HEIGHT);
+	if (diff > TOLERANCE)
+	{
+	    printf ("%s gradient %d (repeat %d) is off by %d\n",
+		    type_names[type], i, repeat, diff);
+	    n_failures++;
+	}
+
+	pixman_image_unref (gradient);
+    }
+
+    pixman_image_unref (fast_img);
+    pixman_image_unref (exact_img);
+    pixman_image_unref (wide_mask);
+    free (fast);
+    free (exact);
+
+    return n_failures != 0;
+}
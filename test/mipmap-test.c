@@ -0,0 +1,243 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "utils.h"
+
+/* Pixels outside the image are those at the edge with PIXMAN_REPEAT_PAD,
+ * and transparent black with PIXMAN_REPEAT_NONE.
+ */
+static uint32_t
+get_pixel (const uint32_t *src, int width, int height, int x, int y,
+	   pixman_repeat_t repeat)
+{
+    if (x >= width || y >= height)
+    {
+	if (repeat == PIXMAN_REPEAT_NONE)
+	    return 0;
+
+	x = x < width ? x : width - 1;
+	y = y < height ? y : height - 1;
+    }
+
+    return src[y * width + x];
+}
+
+static void
+reduce (uint32_t *dst, const uint32_t *src, int width, int height,
+	pixman_repeat_t repeat)
+{
+    int w = (width + 1) / 2;
+    int h = (height + 1) / 2;
+    int x, y, c;
+
+    for (y = 0; y < h; ++y)
+    {
+	for (x = 0; x < w; ++x)
+	{
+	    uint32_t p0 = get_pixel (src, width, height, 2 * x, 2 * y, repeat);
+	    uint32_t p1 = get_pixel (src, width, height, 2 * x + 1, 2 * y, repeat);
+	    uint32_t p2 = get_pixel (src, width, height, 2 * x, 2 * y + 1, repeat);
+	    uint32_t p3 = get_pixel (src, width, height, 2 * x + 1, 2 * y + 1, repeat);
+	    uint32_t p = 0;
+
+	    for (c = 0; c < 32; c += 8)
+	    {
+		uint32_t sum = ((p0 >> c) & 0xff) + ((p1 >> c) & 0xff) +
+			       ((p2 >> c) & 0xff) + ((p3 >> c) & 0xff);
+
+		p |= ((sum + 2) >> 2) << c;
+	    }
+
+	    dst[y * w + x] = p;
+	}
+    }
+}
+
+static pixman_image_t *
+create_source (pixman_format_code_t format, uint32_t *bits,
+	       int width, int height, double scale, pixman_repeat_t repeat)
+{
+    pixman_image_t *image;
+    pixman_transform_t transform;
+
+    image = pixman_image_create_bits (format, width, height, bits, width * 4);
+
+    pixman_transform_init_scale (&transform,
+				 pixman_double_to_fixed (scale),
+				 pixman_double_to_fixed (scale));
+    pixman_image_set_transform (image, &transform);
+    pixman_image_set_filter (image, PIXMAN_FILTER_BILINEAR, NULL, 0);
+    pixman_image_set_repeat (image, repeat);
+
+    return image;
+}
+
+static void
+composite (pixman_image_t *src, uint32_t *dst, int width, int height)
+{
+    pixman_image_t *dest = pixman_image_create_bits (
+	PIXMAN_a8r8g8b8, width, height, dst, width * 4);
+
+    pixman_image_composite32 (PIXMAN_OP_SRC, src, NULL, dest,
+			      0, 0, 0, 0, 0, 0, width, height);
+
+    pixman_image_unref (dest);
+}
+
+/* A 4x downscale samples the centers of the level 2 pixels. Images
+ * without alpha are opaque inside, and transparent outside with
+ * PIXMAN_REPEAT_NONE.
+ */
+static int
+check_levels (pixman_format_code_t format, uint32_t *bits,
+	      int width, int height, pixman_repeat_t repeat)
+{
+    int w1 = (width + 1) / 2, h1 = (height + 1) / 2;
+    int w2 = (w1 + 1) / 2, h2 = (h1 + 1) / 2;
+    uint32_t *opaque = malloc (width * height * 4);
+    uint32_t *level1 = malloc (w1 * h1 * 4);
+    uint32_t *level2 = malloc (w2 * h2 * 4);
+    uint32_t *result = malloc (w2 * h2 * 4);
+    pixman_image_t *src;
+    int failed, i;
+
+    for (i = 0; i < width * height; ++i)
+    {
+	opaque[i] = bits[i];
+	if (format == PIXMAN_x8r8g8b8)
+	    opaque[i] |= 0xff000000;
+    }
+
+    reduce (level1, opaque, width, height, repeat);
+    reduce (level2, level1, w1, h1, repeat);
+
+    src = create_source (format, bits, width, height, 4.0, repeat);
+    pixman_image_set_mipmap (src, TRUE);
+    composite (src, result, w2, h2);
+    pixman_image_unref (src);
+
+    failed = memcmp (result, level2, w2 * h2 * 4) != 0;
+    if (failed)
+	printf ("%dx%d %s image (repeat %d) does not match its level 2\n",
+		width, height, format_name (format), repeat);
+
+    free (opaque);
+    free (level1);
+    free (level2);
+    free (result);
+
+    return failed;
+}
+
+/* Returns whether the mipmap changes the result of a composite */
+static pixman_bool_t
+mipmap_changes (uint32_t *bits, int width, int height, double scale,
+		pixman_repeat_t repeat)
+{
+    int w = width / scale, h = height / scale;
+    uint32_t *a = malloc (w * h * 4);
+    uint32_t *b = malloc (w * h * 4);
+    pixman_image_t *src;
+    pixman_bool_t changed;
+
+    src = create_source (PIXMAN_a8r8g8b8, bits, width, height, scale, repeat);
+    composite (src, a, w, h);
+    pixman_image_set_mipmap (src, TRUE);
+    composite (src, b, w, h);
+    pixman_image_unref (src);
+
+    changed = memcmp (a, b, w * h * 4) != 0;
+
+    free (a);
+    free (b);
+
+    return changed;
+}
+
+/* The levels must be rebuilt after the image is changed */
+static int
+check_discard (uint32_t *bits, int width, int height)
+{
+    static const pixman_color_t white = { 0xffff, 0xffff, 0xffff, 0xffff };
+    pixman_rectangle16_t rect = { 0, 0, width, height };
+    uint32_t *result = malloc (width * height * 4);
+    pixman_image_t *src;
+    int failed = 0;
+    int i;
+
+    src = create_source (PIXMAN_a8r8g8b8, bits, width, height, 4.0,
+			 PIXMAN_REPEAT_PAD);
+    pixman_image_set_mipmap (src, TRUE);
+    composite (src, result, width / 4, height / 4);
+
+    pixman_image_fill_rectangles (PIXMAN_OP_SRC, src, &white, 1, &rect);
+    composite (src, result, width / 4, height / 4);
+    for (i = 0; i < width / 4 * height / 4; ++i)
+	failed |= result[i] != 0xffffffff;
+
+    for (i = 0; i < width * height; ++i)
+	bits[i] = 0x80808080;
+    pixman_image_set_mipmap (src, TRUE);
+    composite (src, result, width / 4, height / 4);
+    for (i = 0; i < width / 4 * height / 4; ++i)
+	failed |= result[i] != 0x80808080;
+
+    if (failed)
+	printf ("levels were not discarded after a change\n");
+
+    pixman_image_unref (src);
+    free (result);
+
+    return failed;
+}
+
+int
+main (int argc, char **argv)
+{
+    static const pixman_format_code_t formats[] =
+    {
+	PIXMAN_a8r8g8b8, PIXMAN_x8r8g8b8
+    };
+    static const int sizes[][2] = { { 64, 48 }, { 63, 47 }, { 17, 90 } };
+    uint32_t *bits = malloc (128 * 128 * 4);
+    int failed = 0;
+    int i, j;
+
+    prng_srand (0);
+    prng_randmemset (bits, 128 * 128 * 4, 0);
+
+    for (i = 0; i < ARRAY_LENGTH (formats); ++i)
+    {
+	for (j = 0; j < ARRAY_LENGTH (sizes); ++j)
+	{
+	    failed |= check_levels (formats[i], bits, sizes[j][0], sizes[j][1],
+				    PIXMAN_REPEAT_PAD);
+	    failed |= check_levels (formats[i], bits, sizes[j][0], sizes[j][1],
+				    PIXMAN_REPEAT_NONE);
+	}
+    }
+
+    if (mipmap_changes (bits, 64, 48, 1.5, PIXMAN_REPEAT_PAD))
+    {
+	printf ("mipmap changed a downscale by less than two\n");
+	failed = 1;
+    }
+
+    if (!mipmap_changes (bits, 128, 128, 3.0, PIXMAN_REPEAT_NORMAL))
+    {
+	printf ("mipmap did not change a downscale by three\n");
+	failed = 1;
+    }
+
+    if (mipmap_changes (bits, 63, 47, 4.0, PIXMAN_REPEAT_NORMAL))
+    {
+	printf ("mipmap changed a repeating image of odd size\n");
+	failed = 1;
+    }
+
+    failed |= check_discard (bits, 64, 48);
+
+    free (bits);
+
+    return failed;
+}
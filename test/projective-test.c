@@ -0,0 +1,116 @@
+#include <stdlib.h>
+#include "utils.h"
+
+#define SRC_WIDTH 31
+#define SRC_HEIGHT 23
+#define WIDTH 57
+#define HEIGHT 41
+
+static const pixman_repeat_t repeats[] =
+{
+    PIXMAN_REPEAT_NONE,
+    PIXMAN_REPEAT_NORMAL,
+    PIXMAN_REPEAT_PAD,
+    PIXMAN_REPEAT_REFLECT,
+};
+
+static const pixman_filter_t filters[] =
+{
+    PIXMAN_FILTER_NEAREST,
+    PIXMAN_FILTER_BILINEAR,
+};
+
+static const pixman_format_code_t formats[] =
+{
+    PIXMAN_a8r8g8b8,
+    PIXMAN_x8r8g8b8,
+};
+
+#define RANDOM_ELT(array)						\
+    (array[prng_rand_n (ARRAY_LENGTH (array))])
+
+static void
+on_destroy (pixman_image_t *image, void *data)
+{
+    free (data);
+}
+
+static pixman_image_t *
+make_image (pixman_format_code_t format, int width, int height)
+{
+    uint32_t *bits = malloc (width * height * 4);
+    pixman_image_t *image;
+
+    prng_randmemset (bits, width * height * 4, 0);
+
+    image = pixman_image_create_bits (format, width, height, bits, width * 4);
+    pixman_image_set_destroy_function (image, on_destroy, bits);
+
+    return image;
+}
+
+/* Maps the destination onto a random quadrilateral, as a card flip or a
+ * quad to quad effect does.
+ */
+static void
+random_transform (pixman_transform_t *transform)
+{
+    struct pixman_f_transform ft;
+    int i;
+
+    pixman_f_transform_init_identity (&ft);
+
+    for (i = 0; i < 2; ++i)
+    {
+	ft.m[i][0] = (prng_rand_n (2001) - 1000) / 500.0;
+	ft.m[i][1] = (prng_rand_n (2001) - 1000) / 500.0;
+	ft.m[i][2] = prng_rand_n (81) - 40;
+    }
+
+    ft.m[2][0] = (prng_rand_n (2001) - 1000) / 40000.0;
+    ft.m[2][1] = (prng_rand_n (2001) - 1000) / 40000.0;
+    ft.m[2][2] = 0.5 + prng_rand_n (100) / 100.0;
+
+    pixman_transform_from_pixman_f_transform (transform, &ft);
+
+    /* Make sure the transformation is projective */
+    if (transform->matrix[2][0] == 0 && transform->matrix[2][1] == 0)
+	transform->matrix[2][0] = 1;
+}
+
+static uint32_t
+test_projective (int testnum, int verbose)
+{
+    pixman_transform_t transform;
+    pixman_image_t *src, *dest;
+    uint32_t crc;
+
+    prng_srand (testnum);
+
+    src = make_image (RANDOM_ELT (formats), SRC_WIDTH, SRC_HEIGHT);
+    dest = make_image (PIXMAN_a8r8g8b8, WIDTH, HEIGHT);
+
+    random_transform (&transform);
+
+    pixman_image_set_filter (src, RANDOM_ELT (filters), NULL, 0);
+    pixman_image_set_repeat (src, RANDOM_ELT (repeats));
+    pixman_image_set_transform (src, &transform);
+
+    pixman_image_composite32 (PIXMAN_OP_SRC, src, NULL, dest,
+			      0, 0, 0, 0, 0, 0, WIDTH, HEIGHT);
+
+    crc = compute_crc32_for_image (0, dest);
+
+    pixman_image_unref (src);
+    pixman_image_unref (dest);
+
+    return crc;
+}
+
+int
+main (int argc, const char *argv[])
+{
+    return fuzzer_test_main ("projective", 2000,
+			     0xB9BB050B,
+			     test_projective, argc, argv);
+}
@@ -0,0 +1,124 @@
+#include <stdlib.h>
+#include "utils.h"
+
+#define MAX_SRC_WIDTH 24
+#define MAX_SRC_HEIGHT 24
+#define WIDTH 67
+#define HEIGHT 29
+
+static const pixman_filter_t filters[] =
+{
+    PIXMAN_FILTER_NEAREST,
+    PIXMAN_FILTER_BILINEAR,
+};
+
+static const pixman_format_code_t formats[] =
+{
+    PIXMAN_a8r8g8b8,
+    PIXMAN_x8r8g8b8,
+    PIXMAN_r5g6b5,
+};
+
+static const pixman_op_t ops[] =
+{
+    PIXMAN_OP_SRC,
+    PIXMAN_OP_OVER,
+};
+
+#define RANDOM_ELT(array)						\
+    (array[prng_rand_n (ARRAY_LENGTH (array))])
+
+static void
+on_destroy (pixman_image_t *image, void *data)
+{
+    free (data);
+}
+
+static pixman_image_t *
+make_image (pixman_format_code_t format, int width, int height)
+{
+    int stride = (width * PIXMAN_FORMAT_BPP (format) / 8 + 3) & ~3;
+    uint32_t *bits = malloc (stride * height);
+    pixman_image_t *image;
+
+    prng_randmemset (bits, stride * height, 0);
+
+    image = pixman_image_create_bits (format, width, height, bits, stride);
+    pixman_image_set_destroy_function (image, on_destroy, bits);
+
+    return image;
+}
+
+static uint32_t
+test_reflect (int testnum, int verbose)
+{
+    pixman_image_t *src, *dest, *mask = NULL;
+    pixman_transform_t transform;
+    pixman_fixed_t sx, sy;
+    int src_width, src_height;
+    int src_x, src_y;
+    uint32_t crc;
+
+    prng_srand (testnum);
+
+    /* Narrow sources make the scanlines cross many edges of the image
+     * and its mirror image.
+     */
+    src_width = prng_rand_n (MAX_SRC_WIDTH) + 1;
+    src_height = prng_rand_n (MAX_SRC_HEIGHT) + 1;
+    src = make_image (RANDOM_ELT (formats), src_width, src_height);
+    dest = make_image (RANDOM_ELT (formats), WIDTH, HEIGHT);
+
+    switch (prng_rand_n (3))
+    {
+    case 0:
+	break;
+
+    case 1:
+	mask = make_image (PIXMAN_a8, WIDTH, HEIGHT);
+	break;
+
+    default:
+	mask = make_image (PIXMAN_a8, 1, 1);
+	pixman_image_set_repeat (mask, PIXMAN_REPEAT_NORMAL);
+	break;
+    }
+
+    /* Mostly upscales and small downscales, sometimes large downscales */
+    sx = prng_rand_n (4) ? 1 + prng_rand_n (2 * pixman_fixed_1) :
+	1 + prng_rand_n (40 * pixman_fixed_1);
+    sy = prng_rand_n (2) ? 1 : -1;
+    sy *= 1 + prng_rand_n (3 * pixman_fixed_1);
+    pixman_transform_init_scale (&transform, sx, sy);
+    transform.matrix[0][2] = prng_rand_n (2 * pixman_fixed_1 * 100) -
+	pixman_fixed_1 * 100;
+    transform.matrix[1][2] = prng_rand_n (2 * pixman_fixed_1 * 100) -
+	pixman_fixed_1 * 100;
+
+    src_x = prng_rand_n (41) - 20;
+    src_y = prng_rand_n (41) - 20;
+
+    pixman_image_set_filter (src, RANDOM_ELT (filters), NULL, 0);
+    pixman_image_set_repeat (src, PIXMAN_REPEAT_REFLECT);
+    pixman_image_set_transform (src, &transform);
+
+    pixman_image_composite32 (RANDOM_ELT (ops), src, mask, dest,
+			      src_x, src_y, 0, 0, 0, 0, WIDTH, HEIGHT);
+
+    crc = compute_crc32_for_image (0, dest);
+
+    pixman_image_unref (src);
+    pixman_image_unref (dest);
+    if (mask)
+	pixman_image_unref (mask);
+
+    return crc;
+}
+
+int
+main (int argc, const char *argv[])
+{
+    return fuzzer_test_main ("reflect", 4000,
+			     0x181EB964,
+			     test_reflect, argc, argv);
+}
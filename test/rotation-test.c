@@ -0,0 +1,116 @@
+#include <stdlib.h>
+#include <math.h>
+#include "utils.h"
+
+#define SRC_WIDTH 47
+#define SRC_HEIGHT 53
+#define WIDTH 150
+#define HEIGHT 130
+
+static const pixman_repeat_t repeats[] =
+{
+    PIXMAN_REPEAT_NONE,
+    PIXMAN_REPEAT_NORMAL,
+    PIXMAN_REPEAT_PAD,
+    PIXMAN_REPEAT_REFLECT,
+};
+
+static const pixman_filter_t filters[] =
+{
+    PIXMAN_FILTER_NEAREST,
+    PIXMAN_FILTER_BILINEAR,
+};
+
+static const pixman_format_code_t formats[] =
+{
+    PIXMAN_a8r8g8b8,
+    PIXMAN_x8r8g8b8,
+};
+
+static const pixman_op_t ops[] =
+{
+    PIXMAN_OP_SRC,
+    PIXMAN_OP_OVER,
+};
+
+#define RANDOM_ELT(array)						\
+    (array[prng_rand_n (ARRAY_LENGTH (array))])
+
+static void
+on_destroy (pixman_image_t *image, void *data)
+{
+    free (data);
+}
+
+static pixman_image_t *
+make_image (int width, int height)
+{
+    uint32_t *bits = malloc (width * height * 4);
+    pixman_image_t *image;
+
+    prng_randmemset (bits, width * height * 4, 0);
+
+    image = pixman_image_create_bits (
+	RANDOM_ELT (formats), width, height, bits, width * 4);
+    pixman_image_set_destroy_function (image, on_destroy, bits);
+
+    return image;
+}
+
+/* A rotation around a random point, possibly with a uniform scale */
+static void
+random_rotation (pixman_transform_t *transform)
+{
+    double angle = prng_rand_n (3600) * M_PI / 1800;
+    double scale = prng_rand_n (2) ? 1.0 : 0.25 + prng_rand_n (300) / 100.0;
+    pixman_fixed_t c = pixman_double_to_fixed (cos (angle) * scale);
+    pixman_fixed_t s = pixman_double_to_fixed (sin (angle) * scale);
+
+    pixman_transform_init_identity (transform);
+
+    transform->matrix[0][0] = c;
+    transform->matrix[0][1] = -s;
+    transform->matrix[1][0] = s;
+    transform->matrix[1][1] = c;
+    transform->matrix[0][2] = pixman_int_to_fixed (prng_rand_n (201) - 100) +
+	prng_rand_n (65536);
+    transform->matrix[1][2] = pixman_int_to_fixed (prng_rand_n (201) - 100) +
+	prng_rand_n (65536);
+}
+
+static uint32_t
+test_rotation (int testnum, int verbose)
+{
+    pixman_transform_t transform;
+    pixman_image_t *src, *dest;
+    uint32_t crc;
+
+    prng_srand (testnum);
+
+    src = make_image (SRC_WIDTH, SRC_HEIGHT);
+    dest = make_image (WIDTH, HEIGHT);
+
+    random_rotation (&transform);
+
+    pixman_image_set_filter (src, RANDOM_ELT (filters), NULL, 0);
+    pixman_image_set_repeat (src, RANDOM_ELT (repeats));
+    pixman_image_set_transform (src, &transform);
+
+    pixman_image_composite32 (RANDOM_ELT (ops), src, NULL, dest,
+			      0, 0, 0, 0, 0, 0, WIDTH, HEIGHT);
+
+    crc = compute_crc32_for_image (0, dest);
+
+    pixman_image_unref (src);
+    pixman_image_unref (dest);
+
+    return crc;
+}
+
+int
+main (int argc, const char *argv[])
+{
+    return fuzzer_test_main ("rotation", 1000,
+			     0x3A240E8B,
+			     test_rotation, argc, argv);
+}
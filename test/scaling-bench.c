@@ -0,0 +1,115 @@
+/*
+ * Benchmarks downscaling of an a8r8g8b8 image with separable
+ * convolution filters, the way cairo uses them for high quality
+ * downscaling. Run it with PIXMAN_DISABLE=sse2 to compare with the
+ * generic C code. The image is also rotated by a small angle, because
+ * scale-only transformations with large kernels go to the two-pass
+ * scaler, with or without SSE2.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "utils.h"
+
+#define SRC_WIDTH 1024
+#define SRC_HEIGHT 768
+#define SUBSAMPLE_BITS 4
+#define MIN_TIME 0.5
+#define ANGLE (1.0 * M_PI / 180)
+
+static const double scales[] = { 0.25, 0.375, 0.5, 0.625, 0.75 };
+
+static const struct
+{
+    const char *	name;
+    pixman_kernel_t	reconstruct;
+    pixman_kernel_t	sample;
+} kernels[] =
+{
+    { "box",		PIXMAN_KERNEL_BOX,	PIXMAN_KERNEL_BOX },
+    { "linear",		PIXMAN_KERNEL_LINEAR,	PIXMAN_KERNEL_BOX },
+    { "lanczos3",	PIXMAN_KERNEL_IMPULSE,	PIXMAN_KERNEL_LANCZOS3 },
+};
+
+static double
+bench (pixman_image_t *src_img, pixman_image_t *dest_img,
+       int width, int height, int *n_pixels)
+{
+    double start = gettime (), t;
+
+    *n_pixels = 0;
+
+    do
+    {
+	pixman_image_composite32 (PIXMAN_OP_SRC, src_img, NULL, dest_img,
+				  0, 0, 0, 0, 0, 0, width, height);
+	*n_pixels += width * height;
+	t = gettime () - start;
+    }
+    while (t < MIN_TIME);
+
+    return t;
+}
+
+int
+main (int argc, char **argv)
+{
+    uint32_t *src;
+    pixman_image_t *src_img, *dest_img;
+    int i, j;
+
+    src = malloc (SRC_WIDTH * SRC_HEIGHT * 4);
+    prng_srand (0);
+    prng_randmemset (src, SRC_WIDTH * SRC_HEIGHT * 4, 0);
+
+    src_img = pixman_image_create_bits (
+	PIXMAN_x8r8g8b8, SRC_WIDTH, SRC_HEIGHT, src, SRC_WIDTH * 4);
+    dest_img = pixman_image_create_bits (
+	PIXMAN_a8r8g8b8, SRC_WIDTH, SRC_HEIGHT, NULL, 0);
+
+    printf ("%-10s %6s %12s\n", "kernel", "scale", "Mpixels/s");
+
+    for (i = 0; i < ARRAY_LENGTH (kernels); ++i)
+    {
+	for (j = 0; j < ARRAY_LENGTH (scales); ++j)
+	{
+	    pixman_transform_t transform;
+	    pixman_fixed_t *params;
+	    int n_params, n_pixels;
+	    double t;
+
+	    pixman_transform_init_rotate (
+		&transform,
+		pixman_double_to_fixed (cos (ANGLE)),
+		pixman_double_to_fixed (sin (ANGLE)));
+	    pixman_transform_scale (
+		&transform, NULL,
+		pixman_double_to_fixed (1 / scales[j]),
+		pixman_double_to_fixed (1 / scales[j]));
+	    pixman_image_set_transform (src_img, &transform);
+
+	    params = pixman_filter_create_separable_convolution (
+		&n_params,
+		pixman_double_to_fixed (1 / scales[j]),
+		pixman_double_to_fixed (1 / scales[j]),
+		kernels[i].reconstruct, kernels[i].reconstruct,
+		kernels[i].sample, kernels[i].sample,
+		SUBSAMPLE_BITS, SUBSAMPLE_BITS);
+	    pixman_image_set_filter (src_img, PIXMAN_FILTER_SEPARABLE_CONVOLUTION,
+				     params, n_params);
+	    free (params);
+
+	    t = bench (src_img, dest_img,
+		       SRC_WIDTH * scales[j], SRC_HEIGHT * scales[j], &n_pixels);
+
+	    printf ("%-10s %6.3f %12.2f\n",
+		    kernels[i].name, scales[j], n_pixels / t / 1000000.);
+	}
+    }
+
+    pixman_image_unref (src_img);
+    pixman_image_unref (dest_img);
+    free (src);
+
+    return 0;
+}
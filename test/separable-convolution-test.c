@@ -0,0 +1,176 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include "utils.h"
+
+#define SRC_WIDTH 37
+#define SRC_HEIGHT 29
+#define WIDTH 43
+#define HEIGHT 31
+#define N_TESTS 400
+
+/* The SIMD fetchers use 14 bit coefficients and round the sum of
+ * each row before applying the vertical taps.
+ */
+#define TOLERANCE 1
+
+static const pixman_repeat_t repeats[] =
+{
+    PIXMAN_REPEAT_NONE,
+    PIXMAN_REPEAT_NORMAL,
+    PIXMAN_REPEAT_PAD,
+    PIXMAN_REPEAT_REFLECT,
+};
+
+static const pixman_format_code_t formats[] =
+{
+    PIXMAN_a8r8g8b8,
+    PIXMAN_x8r8g8b8,
+};
+
+static void
+random_transform (pixman_transform_t *transform, double *sx, double *sy)
+{
+    int tx, ty;
+    int i;
+
+    *sx = 0.125 + prng_rand_n (12) / 8.0;
+    *sy = 0.125 + prng_rand_n (12) / 8.0;
+
+    pixman_transform_init_identity (transform);
+
+    if (prng_rand_n (2) == 0)
+    {
+	double angle = prng_rand_n (360) * M_PI / 180;
+
+	pixman_transform_rotate (transform, NULL,
+				 pixman_double_to_fixed (cos (angle)),
+				 pixman_double_to_fixed (sin (angle)));
+    }
+
+    pixman_transform_scale (transform, NULL,
+			    pixman_double_to_fixed (1 / *sx),
+			    pixman_double_to_fixed (1 / *sy));
+    tx = prng_rand_n (21) - 10;
+    ty = prng_rand_n (21) - 10;
+    pixman_transform_translate (transform, NULL,
+				pixman_int_to_fixed (tx),
+				pixman_int_to_fixed (ty));
+
+    /* With even coefficients, the sample positions are exact in both
+     * the affine and the projective form, which is needed for the
+     * two to pick the same pixels.
+     */
+    for (i = 0; i < 6; ++i)
+	transform->matrix[i / 3][i % 3] &= ~1;
+}
+
+int
+main (int argc, char **argv)
+{
+    uint32_t *src, *fast, *reference;
+    pixman_image_t *fast_img, *reference_img;
+    int n_failures = 0;
+    int i, j;
+
+    src = malloc (SRC_WIDTH * SRC_HEIGHT * 4);
+    fast = malloc (WIDTH * HEIGHT * 4);
+    reference = malloc (WIDTH * HEIGHT * 4);
+
+    fast_img = pixman_image_create_bits (
+	PIXMAN_a8r8g8b8, WIDTH, HEIGHT, fast, WIDTH * 4);
+    reference_img = pixman_image_create_bits (
+	PIXMAN_a8r8g8b8, WIDTH, HEIGHT, reference, WIDTH * 4);
+
+    for (i = 0; i < N_TESTS; ++i)
+    {
+	pixman_format_code_t format;
+	pixman_transform_t transform;
+	pixman_kernel_t reconstruct, sample;
+	pixman_fixed_t *params;
+	pixman_image_t *src_img;
+	pixman_repeat_t repeat;
+	double sx, sy;
+	int x_phase_bits, y_phase_bits;
+	int n_params;
+	int diff;
+
+	prng_srand (i);
+
+	format = formats[prng_rand_n (ARRAY_LENGTH (formats))];
+	repeat = repeats[prng_rand_n (ARRAY_LENGTH (repeats))];
+	reconstruct = prng_rand_n (PIXMAN_KERNEL_LANCZOS3_STRETCHED + 1);
+	sample = prng_rand_n (PIXMAN_KERNEL_LANCZOS3_STRETCHED + 1);
+
+	/* pixman_filter_create_separable_convolution() gives invalid
+	 * coefficients for this pair when scaling up
+	 */
+	if (reconstruct == PIXMAN_KERNEL_IMPULSE && sample == PIXMAN_KERNEL_BOX)
+	    sample = PIXMAN_KERNEL_LINEAR;
+
+	prng_randmemset (src, SRC_WIDTH * SRC_HEIGHT * 4, 0);
+	if (format == PIXMAN_a8r8g8b8)
+	{
+	    /* Keep the source premultiplied */
+	    for (j = 0; j < SRC_WIDTH * SRC_HEIGHT; ++j)
+	    {
+		uint32_t a = src[j] >> 24;
+
+		src[j] = (a << 24) |
+		    ((((src[j] >> 16) & 0xff) * a / 255) << 16) |
+		    ((((src[j] >> 8) & 0xff) * a / 255) << 8) |
+		    (((src[j] >> 0) & 0xff) * a / 255);
+	    }
+	}
+
+	src_img = pixman_image_create_bits (
+	    format, SRC_WIDTH, SRC_HEIGHT, src, SRC_WIDTH * 4);
+
+	random_transform (&transform, &sx, &sy);
+
+	x_phase_bits = prng_rand_n (5);
+	y_phase_bits = prng_rand_n (5);
+
+	params = pixman_filter_create_separable_convolution (
+	    &n_params,
+	    pixman_double_to_fixed (1 / sx), pixman_double_to_fixed (1 / sy),
+	    reconstruct, reconstruct, sample, sample,
+	    x_phase_bits, y_phase_bits);
+
+	pixman_image_set_filter (src_img, PIXMAN_FILTER_SEPARABLE_CONVOLUTION,
+				 params, n_params);
+	pixman_image_set_repeat (src_img, repeat);
+	pixman_image_set_transform (src_img, &transform);
+
+	pixman_image_composite32 (PIXMAN_OP_SRC, src_img, NULL, fast_img,
+				  0, 0, 0, 0, 0, 0, WIDTH, HEIGHT);
+
+	/* The same transformation in projective form */
+	for (j = 0; j < 9; ++j)
+	    transform.matrix[j / 3][j % 3] *= 2;
+
+	pixman_image_set_transform (src_img, &transform);
+
+	pixman_image_composite32 (PIXMAN_OP_SRC, src_img, NULL, reference_img,
+				  0, 0, 0, 0, 0, 0, WIDTH, HEIGHT);
+
+	diff = max_channel_diff (fast, reference, WIDTH * HEIGHT);
+	if (diff > TOLERANCE)
+	{
+	    printf ("test %d (format %s, repeat %d, kernels %d/%d) is off by %d\n",
+		    i, format_name (format), repeat, reconstruct, sample, diff);
+	    n_failures++;
+	}
+
+	free (params);
+	pixman_image_unref (src_img);
+    }
+
+    pixman_image_unref (fast_img);
+    pixman_image_unref (reference_img);
+    free (src);
+    free (fast);
+    free (reference);
+
+    return n_failures != 0;
+}
@@ -0,0 +1,98 @@
+/*
+ * Benchmarks the latency of pixman_image_composite32() for composites of
+ * 1x1 to 16x16 pixels, the sizes used for glyphs and cursors.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include "utils.h"
+
+#define WIDTH 256
+#define HEIGHT 256
+#define N_CALLS 100000
+
+static const int sizes[] = { 1, 2, 4, 8, 16 };
+
+typedef struct
+{
+    const char *		name;
+    pixman_op_t			op;
+    pixman_format_code_t	src_format;
+    pixman_format_code_t	mask_format;
+    pixman_format_code_t	dest_format;
+} composite_t;
+
+static const composite_t composites[] =
+{
+    { "over_8888_8888",	PIXMAN_OP_OVER,	PIXMAN_a8r8g8b8, PIXMAN_null, PIXMAN_a8r8g8b8 },
+    { "over_n_8_8888",	PIXMAN_OP_OVER,	PIXMAN_solid,	 PIXMAN_a8,   PIXMAN_a8r8g8b8 },
+    { "src_8888_8888",	PIXMAN_OP_SRC,	PIXMAN_a8r8g8b8, PIXMAN_null, PIXMAN_a8r8g8b8 },
+    { "add_8_8",	PIXMAN_OP_ADD,	PIXMAN_a8,	 PIXMAN_null, PIXMAN_a8 },
+};
+
+static pixman_image_t *
+create_image (pixman_format_code_t format)
+{
+    pixman_color_t color = { 0x4000, 0x8000, 0x2000, 0x8000 };
+    pixman_image_t *image;
+
+    if (format == PIXMAN_null)
+	return NULL;
+
+    if (format == PIXMAN_solid)
+	return pixman_image_create_solid_fill (&color);
+
+    image = pixman_image_create_bits (format, WIDTH, HEIGHT, NULL, -1);
+    prng_randmemset (pixman_image_get_data (image),
+		     pixman_image_get_stride (image) * HEIGHT, 0);
+
+    return image;
+}
+
+int
+main (int argc, char **argv)
+{
+    int i, j, k;
+
+    prng_srand (0);
+
+    printf ("%-16s", "ns per call");
+    for (j = 0; j < ARRAY_LENGTH (sizes); ++j)
+	printf (" %5dx%-3d", sizes[j], sizes[j]);
+    printf ("\n");
+
+    for (i = 0; i < ARRAY_LENGTH (composites); ++i)
+    {
+	const composite_t *c = &composites[i];
+	pixman_image_t *src_img = create_image (c->src_format);
+	pixman_image_t *mask_img = create_image (c->mask_format);
+	pixman_image_t *dest_img = create_image (c->dest_format);
+
+	printf ("%-16s", c->name);
+
+	for (j = 0; j < ARRAY_LENGTH (sizes); ++j)
+	{
+	    int size = sizes[j];
+	    double t = gettime ();
+
+	    for (k = 0; k < N_CALLS; ++k)
+	    {
+		int x = (k * 7) % (WIDTH - size);
+		int y = (k * 13) % (HEIGHT - size);
+
+		pixman_image_composite32 (c->op, src_img, mask_img, dest_img,
+					  y, x, x, y, x, y, size, size);
+	    }
+
+	    printf (" %9.1f", (gettime () - t) / N_CALLS * 1e9);
+	}
+
+	printf ("\n");
+
+	pixman_image_unref (src_img);
+	if (mask_img)
+	    pixman_image_unref (mask_img);
+	pixman_image_unref (dest_img);
+    }
+
+    return 0;
+}
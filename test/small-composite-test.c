@@ -0,0 +1,142 @@
+#include <stdlib.h>
+#include "utils.h"
+
+#define WIDTH 23
+#define HEIGHT 19
+#define MAX_SIZE 16
+
+static const pixman_format_code_t formats[] =
+{
+    PIXMAN_a8r8g8b8,
+    PIXMAN_x8r8g8b8,
+    PIXMAN_r5g6b5,
+    PIXMAN_a8,
+};
+
+static const pixman_repeat_t repeats[] =
+{
+    PIXMAN_REPEAT_NONE,
+    PIXMAN_REPEAT_NORMAL,
+    PIXMAN_REPEAT_PAD,
+};
+
+static const pixman_op_t ops[] =
+{
+    PIXMAN_OP_SRC,
+    PIXMAN_OP_OVER,
+    PIXMAN_OP_IN,
+    PIXMAN_OP_ADD,
+};
+
+#define RANDOM_ELT(array)						\
+    (array[prng_rand_n (ARRAY_LENGTH (array))])
+
+static void
+on_destroy (pixman_image_t *image, void *data)
+{
+    free (data);
+}
+
+static pixman_image_t *
+make_image (int width, int height)
+{
+    uint32_t *bits = malloc (WIDTH * HEIGHT * 4);
+    pixman_image_t *image;
+
+    prng_randmemset (bits, WIDTH * HEIGHT * 4, 0);
+
+    image = pixman_image_create_bits (
+	RANDOM_ELT (formats), width, height, bits, WIDTH * 4);
+    pixman_image_set_destroy_function (image, on_destroy, bits);
+
+    return image;
+}
+
+static pixman_image_t *
+make_source (void)
+{
+    pixman_image_t *image;
+
+    if (prng_rand_n (4) == 0)
+    {
+	pixman_color_t color;
+
+	color.alpha = prng_rand_n (2) ? 0xffff : prng_rand_n (0x10000);
+	color.red = prng_rand_n (color.alpha + 1);
+	color.green = prng_rand_n (color.alpha + 1);
+	color.blue = prng_rand_n (color.alpha + 1);
+
+	return pixman_image_create_solid_fill (&color);
+    }
+
+    image = make_image (prng_rand_n (WIDTH) + 1, prng_rand_n (HEIGHT) + 1);
+    pixman_image_set_repeat (image, RANDOM_ELT (repeats));
+
+    return image;
+}
+
+static uint32_t
+test_small_composite (int testnum, int verbose)
+{
+    pixman_image_t *src, *mask = NULL, *dest;
+    pixman_region32_t clip;
+    int src_x, src_y, mask_x, mask_y, dest_x, dest_y;
+    int width, height;
+    uint32_t crc;
+
+    prng_srand (testnum);
+
+    src = make_source ();
+    if (prng_rand_n (2))
+    {
+	mask = make_source ();
+	if (prng_rand_n (4) == 0)
+	    pixman_image_set_component_alpha (mask, TRUE);
+    }
+    dest = make_image (WIDTH, HEIGHT);
+
+    /* Composites of up to 16x16 pixels skip the region code when the
+     * destination has at most one clip rectangle.
+     */
+    if (prng_rand_n (2))
+    {
+	int x = prng_rand_n (WIDTH);
+	int y = prng_rand_n (HEIGHT);
+	int w = prng_rand_n (WIDTH);
+	int h = prng_rand_n (HEIGHT);
+
+	pixman_region32_init_rect (&clip, x, y, w, h);
+	pixman_image_set_clip_region32 (dest, &clip);
+	pixman_region32_fini (&clip);
+    }
+
+    src_x = prng_rand_n (WIDTH + 8) - 4;
+    src_y = prng_rand_n (HEIGHT + 8) - 4;
+    mask_x = prng_rand_n (WIDTH + 8) - 4;
+    mask_y = prng_rand_n (HEIGHT + 8) - 4;
+    dest_x = prng_rand_n (WIDTH + 8) - 4;
+    dest_y = prng_rand_n (HEIGHT + 8) - 4;
+    width = prng_rand_n (MAX_SIZE) + 1;
+    height = prng_rand_n (MAX_SIZE) + 1;
+
+    pixman_image_composite32 (RANDOM_ELT (ops), src, mask, dest,
+			      src_x, src_y, mask_x, mask_y,
+			      dest_x, dest_y, width, height);
+
+    crc = compute_crc32_for_image (0, dest);
+
+    pixman_image_unref (src);
+    if (mask)
+	pixman_image_unref (mask);
+    pixman_image_unref (dest);
+
+    return crc;
+}
+
+int
+main (int argc, const char *argv[])
+{
+    return fuzzer_test_main ("small-composite", 20000,
+			     0xDB12A550,
+			     test_small_composite, argc, argv);
+}
@@ -602,6 +602,26 @@ draw_checkerboard (pixman_image_t *image,
     }
 }
 
+int
+max_channel_diff (const uint32_t *a, const uint32_t *b, int n_pixels)
+{
+    int max_diff = 0;
+    int i, j;
+
+    for (i = 0; i < n_pixels; ++i)
+    {
+	for (j = 0; j < 32; j += 8)
+	{
+	    int diff = abs ((int)((a[i] >> j) & 0xff) - (int)((b[i] >> j) & 0xff));
+
+	    if (diff > max_diff)
+		max_diff = diff;
+	}
+    }
+
+    return max_diff;
+}
+
 /*
  * A function, which can be used as a core part of the test programs,
  * intended to detect various problems with the help of fuzzing input
@@ -129,6 +129,12 @@ draw_checkerboard (pixman_image_t *image,
 		   int check_size,
 		   uint32_t color1, uint32_t color2);
 
+/* Returns the largest difference between any two corresponding 8 bit
+ * channels of two buffers of 32 bpp pixels.
+ */
+int
+max_channel_diff (const uint32_t *a, const uint32_t *b, int n_pixels);
+
 /* A pair of macros which can help to detect corruption of
  * floating point registers after a function call. This may
  * happen if _mm_empty() call is forgotten in MMX/SSE2 fast